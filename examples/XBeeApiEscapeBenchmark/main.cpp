@@ -0,0 +1,258 @@
+/**
+   @file
+   @brief Benchmark of the escape, un-escape and checksum kernels in
+          XBeeApiEscape.cpp, comparing them against straightforward
+          byte-at-a-time loops.  The results of each kernel are also
+          checked against those of the corresponding loop.
+
+          The kernels process buffers of less than 16 bytes a byte at a
+          time, but are still expected to lose to the inlined loops at the
+          smallest sizes as they're called out-of-line.
+
+          This example runs on a host rather than mbed.  Only
+          XBeeApiEscape.cpp is needed, e.g.:
+
+          g++ -O2 -std=c++11 -I<each src directory>
+              main.cpp src/Base/XBeeApiEscape.cpp
+
+          On x86 hosts the kernels use SSE2.  Add
+          -DXBEEAPI_CONFIG_DISABLE_SIMD to measure the word-at-a-time
+          versions instead.
+
+          Usage: benchmark [MB processed per measurement]
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiEscape.hpp"
+
+#include <chrono>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Sizes of buffer to measure.  The small sizes cover frame headers, AT command parameters
+   and the tails of longer runs.  16 bytes is the smallest run XBeeDevice writes from where
+   it is rather than copying, 100 is the largest data frame payload */
+static const size_t bench_sizes[] = { 1U, 2U, 4U, 8U, 16U, 32U, 64U, 100U, 1024U };
+
+/* Types of data to measure, differing in how often bytes needing escaping occur */
+typedef enum
+{
+    BENCH_DATA_CLEAN,   /* No bytes need escaping */
+    BENCH_DATA_SPARSE,  /* Roughly 1 byte in 100 needs escaping */
+    BENCH_DATA_RANDOM   /* Uniformly random bytes, so 4 in 256 need escaping */
+} BenchData_e;
+
+static const char* const bench_data_names[] = { "clean", "sparse", "random" };
+
+/* Prevents the compiler from optimising away the results of the kernels */
+static volatile size_t bench_sink;
+
+static bool byteNeedsEscape( const uint8_t p_byte )
+{
+    return ( p_byte == XBEE_SB_FRAME_DELIMITER ) ||
+           ( p_byte == XBEE_SB_ESCAPE ) ||
+           ( p_byte == XBEE_SB_XON ) ||
+           ( p_byte == XBEE_SB_XOFF );
+}
+
+/* Reference checksum, one byte at a time */
+static uint8_t byteChecksum( const uint8_t* p_data, size_t p_len, uint8_t p_sum )
+{
+    while( p_len-- )
+    {
+        p_sum += *(p_data++);
+    }
+    return p_sum;
+}
+
+/* Reference escape, one byte at a time */
+static size_t byteEscape( const uint8_t* p_src, size_t p_len, uint8_t* p_dest, uint8_t* const p_sum )
+{
+    uint8_t* const start = p_dest;
+
+    while( p_len-- )
+    {
+        *p_sum += *p_src;
+        if( byteNeedsEscape( *p_src ))
+        {
+            *(p_dest++) = XBEE_SB_ESCAPE;
+            *(p_dest++) = *(p_src++) ^ XBEE_SB_ESCAPE_XOR;
+        }
+        else
+        {
+            *(p_dest++) = *(p_src++);
+        }
+    }
+    return p_dest - start;
+}
+
+/* Reference un-escape, one byte at a time.  Escaped data never contains a delimiter, so
+   unlike xbeeApiUnescape() there's no need to look for one */
+static size_t byteUnescape( const uint8_t* p_src, size_t p_len, uint8_t* p_dest )
+{
+    uint8_t* const start = p_dest;
+
+    while( p_len-- )
+    {
+        if( *p_src == XBEE_SB_ESCAPE )
+        {
+            p_src++;
+            p_len--;
+            *(p_dest++) = *(p_src++) ^ XBEE_SB_ESCAPE_XOR;
+        }
+        else
+        {
+            *(p_dest++) = *(p_src++);
+        }
+    }
+    return p_dest - start;
+}
+
+/* Escape using the kernel in the same way as XBeeDevice does when transmitting - clean
+   runs are found with xbeeApiEscapeRun() & copied, with the byte ending each run escaped
+   individually */
+static size_t kernelEscape( const uint8_t* p_src, size_t p_len, uint8_t* p_dest, uint8_t* const p_sum )
+{
+    uint8_t* const start = p_dest;
+
+    while( p_len )
+    {
+        const size_t run = xbeeApiEscapeRun( p_src, p_len, p_sum );
+
+        memcpy( p_dest, p_src, run );
+        p_dest += run;
+        p_src += run;
+        p_len -= run;
+
+        if( p_len )
+        {
+            *p_sum += *p_src;
+            *(p_dest++) = XBEE_SB_ESCAPE;
+            *(p_dest++) = *(p_src++) ^ XBEE_SB_ESCAPE_XOR;
+            p_len--;
+        }
+    }
+    return p_dest - start;
+}
+
+static size_t kernelUnescape( const uint8_t* p_src, size_t p_len, uint8_t* p_dest )
+{
+    size_t written;
+    bool esc = false;
+
+    xbeeApiUnescape( p_src, p_len, p_dest, &written, &esc );
+    return written;
+}
+
+static void fillData( std::vector<uint8_t>& p_buff, const BenchData_e p_type )
+{
+    for( size_t i = 0; i < p_buff.size(); i++ )
+    {
+        uint8_t b = (uint8_t)rand();
+
+        if( p_type == BENCH_DATA_SPARSE )
+        {
+            b = (( rand() % 100 ) == 0 ) ? (uint8_t)XBEE_SB_FRAME_DELIMITER : (uint8_t)( b | 0x80U );
+        }
+        else if(( p_type == BENCH_DATA_CLEAN ) && byteNeedsEscape( b ))
+        {
+            b |= 0x80U;
+        }
+        p_buff[ i ] = b;
+    }
+}
+
+/* Time p_iterations calls of a function, returning the throughput in MB/s */
+template <typename F> static double measure( const size_t p_len, const size_t p_iterations, F p_func )
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for( size_t i = 0; i < p_iterations; i++ )
+    {
+        bench_sink = bench_sink + p_func();
+    }
+
+    const double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    return ( (double)p_len * p_iterations ) / ( secs * 1e6 );
+}
+
+static void report( const char* const p_name, const size_t p_len, const BenchData_e p_type,
+                    const double p_byte, const double p_kernel )
+{
+    printf( "%-9s %5u %-7s %10.1f %11.1f %7.2fx\n", p_name, (unsigned)p_len, bench_data_names[ p_type ],
+            p_byte, p_kernel, p_kernel / p_byte );
+}
+
+int main( int argc, char** argv )
+{
+    const size_t megabytes = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 10 ) : 200U;
+    bool ok = true;
+
+    printf( "%-9s %5s %-7s %10s %11s %8s\n", "kernel", "bytes", "data", "byte MB/s", "kernel MB/s", "speedup" );
+
+    for( size_t s = 0; s < sizeof( bench_sizes ) / sizeof( bench_sizes[ 0 ] ); s++ )
+    {
+        const size_t len = bench_sizes[ s ];
+        const size_t iterations = ( megabytes * 1000000U ) / len;
+
+        for( int t = BENCH_DATA_CLEAN; t <= BENCH_DATA_RANDOM; t++ )
+        {
+            const BenchData_e type = (BenchData_e)t;
+            std::vector<uint8_t> src( len );
+            std::vector<uint8_t> escByte( 2U * len );
+            std::vector<uint8_t> escKernel( 2U * len );
+            std::vector<uint8_t> dest( 2U * len );
+            uint8_t sumByte = 0;
+            uint8_t sumKernel = 0;
+
+            fillData( src, type );
+
+            /* Check that the kernels agree with the byte loops before timing them */
+            const size_t escLen = byteEscape( &src[ 0 ], len, &escByte[ 0 ], &sumByte );
+            ok &= ( kernelEscape( &src[ 0 ], len, &escKernel[ 0 ], &sumKernel ) == escLen ) &&
+                  ( memcmp( &escByte[ 0 ], &escKernel[ 0 ], escLen ) == 0 ) &&
+                  ( sumByte == sumKernel ) &&
+                  ( xbeeApiChecksum( &src[ 0 ], len, 0 ) == byteChecksum( &src[ 0 ], len, 0 )) &&
+                  ( kernelUnescape( &escByte[ 0 ], escLen, &dest[ 0 ] ) == len ) &&
+                  ( memcmp( &dest[ 0 ], &src[ 0 ], len ) == 0 );
+
+            report( "checksum", len, type,
+                    measure( len, iterations, [&]() { return (size_t)byteChecksum( &src[ 0 ], len, 0 ); } ),
+                    measure( len, iterations, [&]() { return (size_t)xbeeApiChecksum( &src[ 0 ], len, 0 ); } ));
+            report( "escape", len, type,
+                    measure( len, iterations, [&]() { uint8_t sum = 0; return byteEscape( &src[ 0 ], len, &dest[ 0 ], &sum ); } ),
+                    measure( len, iterations, [&]() { uint8_t sum = 0; return kernelEscape( &src[ 0 ], len, &dest[ 0 ], &sum ); } ));
+            report( "unescape", len, type,
+                    measure( escLen, iterations, [&]() { return byteUnescape( &escByte[ 0 ], escLen, &dest[ 0 ] ); } ),
+                    measure( escLen, iterations, [&]() { return kernelUnescape( &escByte[ 0 ], escLen, &dest[ 0 ] ); } ));
+        }
+    }
+
+    if( !ok )
+    {
+        printf( "MISMATCH between kernel and byte-at-a-time results\n" );
+    }
+
+    return ok ? 0 : 1;
+}
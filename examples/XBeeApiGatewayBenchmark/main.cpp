@@ -0,0 +1,258 @@
+/**
+   @file
+   @brief Benchmark of XBeeApiGateway, measuring the aggregate rate at which
+          frames are received as the number of radios increases, and then as
+          the number of workers servicing a fixed number of radios increases.
+          The radios are simulated using pseudo-terminals, so no hardware is
+          needed.  The writers simulating the radios use CPU time too, so the
+          worker scaling is best seen on a host with plenty of cores.
+
+          This example runs on a POSIX host rather than mbed.  Build with
+          XBEEAPI_CONFIG_POSIX and XBEEAPI_CONFIG_USING_STD_THREAD defined,
+          e.g.:
+
+          g++ -O2 -std=c++11 -pthread -DXBEEAPI_CONFIG_POSIX
+              -DXBEEAPI_CONFIG_USING_STD_THREAD -I<each src directory>
+              main.cpp <all src .cpp files> -lutil
+
+          Usage: benchmark [seconds per run] [max workers] [radios when varying workers]
+
+   @author John Bailey 
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+   
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "xbeeapi.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Number of bytes of data in each simulated frame */
+#define BENCH_PAYLOAD_LEN 20U
+
+/* Number of frames written to the pseudo-terminal by each simulated radio in one go */
+#define BENCH_FRAMES_PER_WRITE 64U
+
+/* Decoder which simply counts the data frames received */
+class FrameCounter : public XBeeApiRxFrameDecoder
+{
+    public:
+        std::atomic<unsigned long> m_count;
+
+        FrameCounter( XBeeDevice* p_device ) : XBeeApiRxFrameDecoder( p_device ), m_count( 0 )
+        {
+        }
+
+        virtual void frameRxCallback( const XBeeApiRxFrame* const )
+        {
+            m_count++;
+        }
+};
+
+/* Add a byte to a buffer of data being sent to the XBeeDevice, escaping it as needed */
+static void addEscaped( std::vector<uint8_t>& p_buff, const uint8_t p_byte )
+{
+    if(( p_byte == 0x7E ) || ( p_byte == 0x7D ) || ( p_byte == 0x11 ) || ( p_byte == 0x13 ))
+    {
+        p_buff.push_back( 0x7D );
+        p_buff.push_back( p_byte ^ 0x20 );
+    }
+    else
+    {
+        p_buff.push_back( p_byte );
+    }
+}
+
+/* Build the data sent by a simulated radio - a batch of 16-bit address RX frames */
+static std::vector<uint8_t> buildFrames( void )
+{
+    std::vector<uint8_t> ret_val;
+
+    for( unsigned f = 0; f < BENCH_FRAMES_PER_WRITE; f++ )
+    {
+        std::vector<uint8_t> body;
+        uint8_t sum = 0;
+
+        body.push_back( XBEE_CMD_RX_16B_ADDR );
+        body.push_back( 0x12 );
+        body.push_back( 0x34 );
+        body.push_back( 0x28 );
+        body.push_back( 0x00 );
+        for( unsigned i = 0; i < BENCH_PAYLOAD_LEN; i++ )
+        {
+            body.push_back( (uint8_t)( f + i ));
+        }
+
+        ret_val.push_back( 0x7E );
+        addEscaped( ret_val, (uint8_t)( body.size() >> 8 ));
+        addEscaped( ret_val, (uint8_t)( body.size() & 0xFF ));
+        for( size_t i = 0; i < body.size(); i++ )
+        {
+            addEscaped( ret_val, body[ i ] );
+            sum += body[ i ];
+        }
+        addEscaped( ret_val, 0xFF - sum );
+    }
+
+    return ret_val;
+}
+
+/* A simulated radio: a pseudo-terminal, with a thread writing frames to the master side
+   and the XBeeDevice using the slave side */
+struct SimRadio
+{
+    int                      m_master;
+    XBeeApiTransportTermios* m_transport;
+    XBeeDevice*              m_device;
+    FrameCounter*            m_counter;
+};
+
+/* Run the benchmark with a given number of radios & workers, returning frames/s */
+static double runBenchmark( const size_t p_radios, const size_t p_workers, const unsigned p_seconds )
+{
+    const std::vector<uint8_t> frames = buildFrames();
+    std::vector<SimRadio> radios( p_radios );
+    std::vector<std::thread> writers;
+    std::atomic<bool> running( true );
+    XBeeApiGateway gateway( p_workers );
+    unsigned long total = 0;
+
+    for( size_t r = 0; r < p_radios; r++ )
+    {
+        int slave;
+        struct termios tio;
+
+        if( openpty( &( radios[ r ].m_master ), &slave, NULL, NULL, NULL ) != 0 )
+        {
+            perror( "openpty" );
+            exit( 1 );
+        }
+        tcgetattr( radios[ r ].m_master, &tio );
+        cfmakeraw( &tio );
+        tcsetattr( radios[ r ].m_master, TCSANOW, &tio );
+        /* The writer waits for space with a timeout, so that it notices being stopped */
+        fcntl( radios[ r ].m_master, F_SETFL, fcntl( radios[ r ].m_master, F_GETFL ) | O_NONBLOCK );
+
+        radios[ r ].m_transport = new XBeeApiTransportTermios( slave, true );
+        radios[ r ].m_transport->configure( 115200 );
+        radios[ r ].m_device = new XBeeDevice( radios[ r ].m_transport );
+        radios[ r ].m_counter = new FrameCounter( radios[ r ].m_device );
+        gateway.addDevice( radios[ r ].m_device, radios[ r ].m_transport );
+    }
+
+    gateway.start();
+
+    for( size_t r = 0; r < p_radios; r++ )
+    {
+        const int fd = radios[ r ].m_master;
+        writers.push_back( std::thread( [ fd, &frames, &running ]( void ) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            size_t offset = 0;
+
+            while( running )
+            {
+                const ssize_t written = write( fd, &( frames[ offset ] ), frames.size() - offset );
+
+                if( written > 0 )
+                {
+                    offset = ( offset + written ) % frames.size();
+                }
+                else if( errno == EAGAIN )
+                {
+                    poll( &pfd, 1, 10 );
+                }
+                else
+                {
+                    break;
+                }
+            }
+        } ));
+    }
+
+    std::this_thread::sleep_for( std::chrono::seconds( p_seconds ));
+    for( size_t r = 0; r < p_radios; r++ )
+    {
+        total += radios[ r ].m_counter->m_count;
+    }
+
+    running = false;
+    for( size_t r = 0; r < p_radios; r++ )
+    {
+        writers[ r ].join();
+        close( radios[ r ].m_master );
+    }
+    gateway.stop();
+
+    for( size_t r = 0; r < p_radios; r++ )
+    {
+        delete( radios[ r ].m_counter );
+        delete( radios[ r ].m_device );
+        delete( radios[ r ].m_transport );
+    }
+
+    return (double)total / p_seconds;
+}
+
+int main( int argc, char** argv )
+{
+    const unsigned seconds = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 2U;
+    const size_t maxWorkers = ( argc > 2 ) ? atoi( argv[ 2 ] ) : std::thread::hardware_concurrency();
+    const size_t fixedRadios = ( argc > 3 ) ? atoi( argv[ 3 ] ) : XBEEAPI_CONFIG_GATEWAY_MAX_DEVICES;
+    static const size_t radioCounts[] = { 1U, 2U, 4U, 8U, 16U };
+    double oneWorker = 0;
+
+    printf( "radios workers     frames/s  frames/s/radio\r\n" );
+
+    for( size_t i = 0; i < ( sizeof( radioCounts ) / sizeof( radioCounts[ 0 ] )); i++ )
+    {
+        const size_t radios = radioCounts[ i ];
+        const size_t workers = (( maxWorkers > 0 ) && ( maxWorkers < radios )) ? maxWorkers : radios;
+        const double rate = runBenchmark( radios, workers, seconds );
+
+        printf( "%6u %7u %12.0f %15.0f\r\n", (unsigned)radios, (unsigned)workers, rate, rate / radios );
+    }
+
+    /* Devices are independent of each other, so the aggregate rate should grow with the
+       number of workers until the host runs out of cores */
+    printf( "\r\nradios workers     frames/s  vs 1 worker\r\n" );
+
+    for( size_t workers = 1; workers <= (( maxWorkers > 0 ) ? maxWorkers : 1U ); workers *= 2U )
+    {
+        const double rate = runBenchmark( fixedRadios, workers, seconds );
+
+        if( workers == 1 )
+        {
+            oneWorker = rate;
+        }
+
+        printf( "%6u %7u %12.0f %11.2fx\r\n", (unsigned)fixedRadios, (unsigned)workers, rate, rate / oneWorker );
+    }
+
+    return 0;
+}
@@ -0,0 +1,484 @@
+/**
+   @file
+   @brief Example of XBeeApiRemotePush pushing a configuration profile out to
+          a network of remote XBees.  The local XBee & the remote nodes are
+          simulated by a thread on the far side of a pseudo-terminal, so no
+          hardware is needed.
+
+          The simulated nodes queue parameter changes until told to apply
+          them, respond after a fixed latency and can be made to lose a
+          proportion of commands, exercising the push's re-tries.  A number
+          of nodes never respond at all and should be reported as failed.
+          Once each push is complete, the parameters held by the simulated
+          nodes are checked against the profile.
+
+          This example runs on a POSIX host rather than mbed.  Build with
+          XBEEAPI_CONFIG_POSIX and XBEEAPI_CONFIG_USING_STD_THREAD defined,
+          e.g.:
+
+          g++ -O2 -std=c++11 -pthread -DXBEEAPI_CONFIG_POSIX
+              -DXBEEAPI_CONFIG_USING_STD_THREAD -I<each src directory>
+              main.cpp <all src .cpp files> -lutil
+
+          Usage: example [nodes] [percentage of commands lost]
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "xbeeapi.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* 64-bit address of the first simulated node.  The others follow on sequentially */
+#define SIM_ADDR64_BASE 0x0013A20040000000ULL
+
+/* Time taken for a simulated node to respond to a command */
+#define SIM_LATENCY_MS 2U
+
+/* Every SIM_ABSENT_EVERY'th node never responds */
+#define SIM_ABSENT_EVERY 16U
+
+/* Time the push waits for a response before re-sending a command */
+#define PUSH_TIMEOUT_MS 50U
+
+/* Status values used in remote AT command responses */
+#define SIM_STATUS_OK              0U
+#define SIM_STATUS_INVALID_COMMAND 2U
+#define SIM_STATUS_INVALID_PARAM   3U
+
+/* Remote command option: apply changes on the remote node immediately */
+#define SIM_OPT_APPLY_CHANGES 0x02U
+
+#define SIM_PARAM( _field, _name, _var, _type, _mnemonic, _width ) { _mnemonic, _width },
+
+/* Command & parameter length for each parameter the simulated nodes support, indexed by
+   XBeeApiCmdAtProfile::XBeeApiProfileField_e */
+static const struct {
+    uint16_t m_mnemonic;
+    uint8_t  m_width;
+} sim_params[ XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ] = {
+    XBEE_PROFILE_FIELD_LIST( SIM_PARAM )
+};
+
+/* State of a simulated remote node */
+struct SimNode
+{
+    /* Values currently in use */
+    uint16_t m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ];
+    /* Values which have been set but not yet applied */
+    uint16_t m_queued[ XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ];
+    /* Bit n is set when m_queued[ n ] holds a change */
+    uint16_t m_queuedMask;
+    /* Set for nodes which never respond */
+    bool     m_absent;
+};
+
+/* Add a byte to a buffer of data being sent to the XBeeDevice, escaping it as needed */
+static void addEscaped( std::vector<uint8_t>& p_buff, const uint8_t p_byte )
+{
+    if(( p_byte == 0x7E ) || ( p_byte == 0x7D ) || ( p_byte == 0x11 ) || ( p_byte == 0x13 ))
+    {
+        p_buff.push_back( 0x7D );
+        p_buff.push_back( p_byte ^ 0x20 );
+    }
+    else
+    {
+        p_buff.push_back( p_byte );
+    }
+}
+
+/* The far side of the pseudo-terminal: a local XBee and the remote nodes it talks to */
+class SimPeer
+{
+    protected:
+        typedef std::chrono::steady_clock clock;
+
+        int                  m_fd;
+        std::vector<SimNode> m_nodes;
+        unsigned             m_lossPercent;
+        std::atomic<bool>    m_running;
+        std::thread          m_thread;
+
+        /* Frame being received, from the length onwards, un-escaped */
+        std::vector<uint8_t> m_rx;
+        bool                 m_rxEsc;
+
+        /* Responses waiting for their latency to expire, keyed by the time they're due */
+        std::multimap<clock::time_point, std::vector<uint8_t> > m_responses;
+
+        /* Queue a response frame with the given body */
+        void respond( const std::vector<uint8_t>& p_body )
+        {
+            std::vector<uint8_t> frame;
+            uint8_t sum = 0;
+
+            frame.push_back( 0x7E );
+            addEscaped( frame, (uint8_t)( p_body.size() >> 8 ));
+            addEscaped( frame, (uint8_t)( p_body.size() & 0xFF ));
+            for( size_t i = 0; i < p_body.size(); i++ )
+            {
+                addEscaped( frame, p_body[ i ] );
+                sum += p_body[ i ];
+            }
+            addEscaped( frame, 0xFF - sum );
+
+            m_responses.insert( std::make_pair( clock::now() + std::chrono::milliseconds( SIM_LATENCY_MS ), frame ));
+        }
+
+        /* Deal with a complete frame body (API identifier onwards, without the checksum) */
+        void handleFrame( const uint8_t* const p_body, const size_t p_len )
+        {
+            /* API identifier, frame ID, 64-bit address, 16-bit address, options & command */
+            if(( p_len < 15U ) ||
+               ( p_body[ 0 ] != XBEE_CMD_REMOTE_AT_CMD ))
+            {
+                return;
+            }
+
+            uint64_t addr64 = 0;
+            for( size_t i = 0; i < 8U; i++ )
+            {
+                addr64 = ( addr64 << 8 ) | p_body[ 2U + i ];
+            }
+
+            const size_t node = (size_t)( addr64 - SIM_ADDR64_BASE );
+            const uint8_t options = p_body[ 12 ];
+            const uint16_t mnemonic = XBEE_AT_MNEMONIC( p_body[ 13 ], p_body[ 14 ] );
+            const uint8_t* const param = &( p_body[ 15 ] );
+            const size_t paramLen = p_len - 15U;
+
+            if(( node >= m_nodes.size() ) ||
+               ( m_nodes[ node ].m_absent ) ||
+               (( rand() % 100 ) < (int)m_lossPercent ))
+            {
+                return;
+            }
+
+            SimNode* const n = &( m_nodes[ node ] );
+            std::vector<uint8_t> resp( p_body, p_body + 12 );
+            uint8_t status = SIM_STATUS_INVALID_COMMAND;
+            size_t p;
+
+            resp[ 0 ] = XBEE_CMD_REMOTE_AT_RESPONSE;
+            resp.push_back( p_body[ 13 ] );
+            resp.push_back( p_body[ 14 ] );
+
+            for( p = 0; p < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT; p++ )
+            {
+                if( sim_params[ p ].m_mnemonic == mnemonic )
+                {
+                    break;
+                }
+            }
+
+            if( p < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT )
+            {
+                if( paramLen == 0 )
+                {
+                    status = SIM_STATUS_OK;
+                }
+                else if( paramLen == sim_params[ p ].m_width )
+                {
+                    n->m_queued[ p ] = ( paramLen == 2U ) ? (uint16_t)(( param[ 0 ] << 8 ) | param[ 1 ] ) : param[ 0 ];
+                    n->m_queuedMask |= (uint16_t)( 1U << p );
+                    status = SIM_STATUS_OK;
+                }
+                else
+                {
+                    status = SIM_STATUS_INVALID_PARAM;
+                }
+            }
+            else if( mnemonic == XBEE_AT_MNEMONIC( 'A', 'C' ))
+            {
+                status = SIM_STATUS_OK;
+            }
+
+            if(( status == SIM_STATUS_OK ) &&
+               (( options & SIM_OPT_APPLY_CHANGES ) ||
+                ( mnemonic == XBEE_AT_MNEMONIC( 'A', 'C' ))))
+            {
+                for( size_t q = 0; q < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT; q++ )
+                {
+                    if( n->m_queuedMask & ( 1U << q ))
+                    {
+                        n->m_value[ q ] = n->m_queued[ q ];
+                    }
+                }
+                n->m_queuedMask = 0;
+            }
+
+            resp.push_back( status );
+
+            /* A query returns the current value */
+            if(( status == SIM_STATUS_OK ) &&
+               ( p < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ) &&
+               ( paramLen == 0 ))
+            {
+                if( sim_params[ p ].m_width == 2U )
+                {
+                    resp.push_back( (uint8_t)( n->m_value[ p ] >> 8 ));
+                }
+                resp.push_back( (uint8_t)( n->m_value[ p ] ));
+            }
+
+            respond( resp );
+        }
+
+        /* Process bytes received from the XBeeDevice */
+        void receive( const uint8_t* p_data, size_t p_len )
+        {
+            while( p_len-- )
+            {
+                uint8_t b = *(p_data++);
+
+                if( b == 0x7E )
+                {
+                    m_rx.clear();
+                    m_rxEsc = false;
+                    continue;
+                }
+                if( b == 0x7D )
+                {
+                    m_rxEsc = true;
+                    continue;
+                }
+                if( m_rxEsc )
+                {
+                    b ^= 0x20;
+                    m_rxEsc = false;
+                }
+
+                m_rx.push_back( b );
+
+                /* Length, body & checksum */
+                if(( m_rx.size() >= 2U ) &&
+                   ( m_rx.size() == ((size_t)( m_rx[ 0 ] << 8 ) | m_rx[ 1 ] ) + 3U ))
+                {
+                    uint8_t sum = 0;
+
+                    for( size_t i = 2; i < m_rx.size(); i++ )
+                    {
+                        sum += m_rx[ i ];
+                    }
+                    if( sum == 0xFF )
+                    {
+                        handleFrame( &( m_rx[ 2 ] ), m_rx.size() - 3U );
+                    }
+                    m_rx.clear();
+                }
+            }
+        }
+
+        void run( void )
+        {
+            while( m_running )
+            {
+                struct pollfd pfd;
+                int timeout = 10;
+                uint8_t buff[ 256 ];
+
+                if( !m_responses.empty() )
+                {
+                    const long due = (long)std::chrono::duration_cast<std::chrono::milliseconds>( m_responses.begin()->first - clock::now() ).count();
+                    timeout = ( due < 0 ) ? 0 : (( due < timeout ) ? (int)due : timeout );
+                }
+
+                pfd.fd = m_fd;
+                pfd.events = POLLIN;
+
+                if( poll( &pfd, 1, timeout ) > 0 )
+                {
+                    const ssize_t len = read( m_fd, buff, sizeof( buff ));
+
+                    if( len > 0 )
+                    {
+                        receive( buff, (size_t)len );
+                    }
+                }
+
+                while(( !m_responses.empty() ) &&
+                      ( m_responses.begin()->first <= clock::now() ))
+                {
+                    const std::vector<uint8_t>& frame = m_responses.begin()->second;
+
+                    if( write( m_fd, &( frame[ 0 ] ), frame.size() ) < 0 )
+                    {
+                        perror( "write" );
+                    }
+                    m_responses.erase( m_responses.begin() );
+                }
+            }
+        }
+
+    public:
+        SimPeer( const int p_fd, const size_t p_nodes, const unsigned p_lossPercent ) : m_fd( p_fd ),
+                                                                                        m_nodes( p_nodes ),
+                                                                                        m_lossPercent( p_lossPercent ),
+                                                                                        m_running( false ),
+                                                                                        m_rxEsc( false )
+        {
+            for( size_t i = 0; i < p_nodes; i++ )
+            {
+                SimNode* const n = &( m_nodes[ i ] );
+
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_CHANNEL ] = 0x0C;
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_COORDINATOR_ENABLED ] = 0;
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_END_DEVICE_ASSOCIATION_ENABLED ] = 0;
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_PAN_ID ] = 0x3332;
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_SOURCE_ADDRESS ] = (uint16_t)i;
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_RETRIES ] = 10;
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_RANDOM_DELAY_SLOTS ] = 0;
+                n->m_value[ XBeeApiCmdAtProfile::XBEE_PROFILE_MAC_MODE ] = 0;
+                n->m_queuedMask = 0;
+                n->m_absent = (( i % SIM_ABSENT_EVERY ) == ( SIM_ABSENT_EVERY - 1U ));
+            }
+        }
+
+        void start( void )
+        {
+            m_running = true;
+            m_thread = std::thread( &SimPeer::run, this );
+        }
+
+        void stop( void )
+        {
+            m_running = false;
+            m_thread.join();
+        }
+
+        const SimNode& getNode( const size_t p_node ) const
+        {
+            return m_nodes[ p_node ];
+        }
+};
+
+/* Push a profile to p_nodes simulated nodes, returning false in the case that the end
+   result isn't as expected */
+static bool runPush( const XBeeApiCmdAtProfile& p_profile, const size_t p_nodes, const uint8_t p_window, const unsigned p_lossPercent )
+{
+    int master;
+    int slave;
+    struct termios tio;
+    bool ret_val = true;
+
+    if( openpty( &master, &slave, NULL, NULL, NULL ) != 0 )
+    {
+        perror( "openpty" );
+        exit( 1 );
+    }
+    tcgetattr( master, &tio );
+    cfmakeraw( &tio );
+    tcsetattr( master, TCSANOW, &tio );
+
+    XBeeApiTransportTermios transport( slave, true );
+    transport.configure( 115200 );
+
+    XBeeDevice device( &transport );
+    XBeeApiGateway gateway( 1U );
+    XBeeApiCmdAtRemote remote( p_nodes, &device );
+    XBeeApiRemotePush push( &remote, p_window, PUSH_TIMEOUT_MS );
+    XBeeApiRemotePush::XBeeApiRemotePushProgress_t progress;
+    SimPeer peer( master, p_nodes, p_lossPercent );
+
+    for( size_t i = 0; i < p_nodes; i++ )
+    {
+        remote.addNode( SIM_ADDR64_BASE + i, XBEE_REMOTE_ADDR16_UNKNOWN );
+    }
+
+    gateway.addDevice( &device, &transport );
+    gateway.start();
+    peer.start();
+
+    push.start( &p_profile );
+    push.run();
+    push.getProgress( &progress );
+
+    gateway.stop();
+    peer.stop();
+    close( master );
+
+    /* Nodes which responded should have been configured, the others should have failed */
+    for( size_t i = 0; i < p_nodes; i++ )
+    {
+        const SimNode& node = peer.getNode( i );
+        bool matches = true;
+
+        for( uint8_t p = 0; p < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT; p++ )
+        {
+            const XBeeApiCmdAtProfile::XBeeApiProfileField_e field = (XBeeApiCmdAtProfile::XBeeApiProfileField_e)p;
+
+            if(( p_profile.isSpecified( field )) &&
+               ( node.m_value[ p ] != p_profile.getValue( field )))
+            {
+                matches = false;
+            }
+        }
+
+        if( node.m_absent ?
+            ( push.getNodeState( i ) != XBeeApiRemotePush::XBEE_REMOTE_PUSH_NODE_FAILED ) :
+            (( push.getNodeState( i ) != XBeeApiRemotePush::XBEE_REMOTE_PUSH_NODE_DONE ) || !matches ))
+        {
+            printf( "node %u: unexpected state %u\r\n", (unsigned)i, (unsigned)push.getNodeState( i ));
+            ret_val = false;
+        }
+    }
+
+    printf( "%6u %6u %6u %6u %8u %7u %8u\r\n", (unsigned)p_window, (unsigned)progress.m_total,
+            (unsigned)progress.m_done, (unsigned)progress.m_failed, (unsigned)progress.m_commands,
+            (unsigned)progress.m_retries, (unsigned)progress.m_elapsedMs );
+
+    return ret_val;
+}
+
+int main( int argc, char** argv )
+{
+    const size_t nodes = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 64U;
+    const unsigned lossPercent = ( argc > 2 ) ? atoi( argv[ 2 ] ) : 5U;
+    static const uint8_t windows[] = { 1U, 4U, 8U };
+    XBeeApiCmdAtProfile profile;
+    bool ok = true;
+
+    profile.setChannel( 0x0F );
+    profile.setPanId( 0x1234 );
+    profile.setRetries( 3 );
+    profile.setMacMode( XBeeApiCmdAt::XBEE_API_MAC_MODE_802_15_4_ACK );
+
+    srand( 1 );
+
+    printf( "window  nodes   done failed commands retries       ms\r\n" );
+
+    for( size_t i = 0; i < ( sizeof( windows ) / sizeof( windows[ 0 ] )); i++ )
+    {
+        ok &= runPush( profile, nodes, windows[ i ], lossPercent );
+    }
+
+    return ok ? 0 : 1;
+}
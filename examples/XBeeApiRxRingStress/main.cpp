@@ -0,0 +1,230 @@
+/**
+   @file
+   @brief Stress test of XBeeApiRxFrameCircularBuffer, with frames being added
+          by one thread and retrieved & removed by another, as they would be
+          by the serial RX interrupt and the main loop.  The content of every
+          frame retrieved is checked.
+
+          Two runs are made:
+            - XBEE_API_RX_OVERFLOW_DROP_NEWEST.  The producer re-tries any frame
+              which didn't fit, so every frame must arrive intact and in order.
+            - XBEE_API_RX_OVERFLOW_DROP_OLDEST.  Frames may be lost, but those
+              which arrive must do so in order, and every frame sent must be
+              accounted for as either received or dropped.  A batch of frames
+              in which one or more was dropped while being read is skipped, as
+              its content may have been overwritten (see
+              XBeeApiRxFrameCircularBuffer::setOverflowPolicy()).
+
+          This example runs on a POSIX host rather than mbed.  Build with
+          XBEEAPI_CONFIG_POSIX and XBEEAPI_CONFIG_USING_STD_THREAD defined,
+          e.g.:
+
+          g++ -O2 -std=c++11 -pthread -DXBEEAPI_CONFIG_POSIX
+              -DXBEEAPI_CONFIG_USING_STD_THREAD -I<each src directory>
+              main.cpp <all src .cpp files> -lutil
+
+          Adding -fsanitize=thread checks the buffer for data races.
+
+          Usage: stress [frames per run] [buffer size]
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "xbeeapi.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Largest number of frames retrieved by the consumer in one go */
+#define STRESS_MAX_BATCH 7U
+
+/* Largest frame payload.  Each payload starts with the frame's sequence number, with
+   the remaining bytes derived from it */
+#define STRESS_MAX_PAYLOAD 40U
+
+/* Length of the payload of frame p_seq.  Varying the length exercises the wrap-around
+   markers left at the end of the ring */
+static size_t payloadLen( const uint32_t p_seq )
+{
+    return sizeof( p_seq ) + ( p_seq % ( STRESS_MAX_PAYLOAD - sizeof( p_seq ) + 1U ));
+}
+
+static void buildPayload( const uint32_t p_seq, uint8_t* const p_buff )
+{
+    memcpy( p_buff, &p_seq, sizeof( p_seq ));
+    for( size_t i = sizeof( p_seq ); i < payloadLen( p_seq ); i++ )
+    {
+        p_buff[ i ] = (uint8_t)( p_seq + i );
+    }
+}
+
+/* Check a retrieved frame, returning its sequence number via p_seq */
+static bool checkFrame( const XBeeApiRxFrame& p_frame, uint32_t* const p_seq )
+{
+    const uint8_t* data;
+    uint16_t len;
+    uint8_t expected[ STRESS_MAX_PAYLOAD ];
+    bool ret_val = false;
+
+    p_frame.getDataPtr( 0, &data, &len );
+
+    if( len >= sizeof( *p_seq ))
+    {
+        memcpy( p_seq, data, sizeof( *p_seq ));
+        buildPayload( *p_seq, expected );
+
+        ret_val = ( len == payloadLen( *p_seq )) &&
+                  ( p_frame.getApiId() == (( *p_seq & 1U ) ? XBEE_CMD_RX_64B_ADDR : XBEE_CMD_RX_16B_ADDR )) &&
+                  ( memcmp( data, expected, len ) == 0 );
+    }
+
+    return ret_val;
+}
+
+/* Pass p_frames frames through a buffer of p_size bytes, returning false in the case
+   that a frame arrives corrupted or out of order */
+static bool runStress( const XBeeApiRxFrameCircularBuffer::XBeeApiRxOverflowPolicy_e p_policy,
+                       const uint32_t p_frames, const size_t p_size )
+{
+    const bool lossless = ( p_policy == XBeeApiRxFrameCircularBuffer::XBEE_API_RX_OVERFLOW_DROP_NEWEST );
+    XBeeApiRxFrameCircularBuffer ring( XBeeApiRxBufferBytes( p_size ), NULL, p_policy );
+    std::atomic<bool> done( false );
+    uint32_t received = 0;
+    uint32_t skipped = 0;
+    uint32_t skippedFrames = 0;
+    int64_t last = -1;
+    bool ok = true;
+    unsigned seed = 1;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    /* The producer stands in for the serial RX interrupt */
+    std::thread producer( [ & ]( void ) {
+        uint8_t payload[ STRESS_MAX_PAYLOAD ];
+        uint32_t seq = 0;
+
+        while( seq < p_frames )
+        {
+            const size_t droppedBefore = ring.getDroppedFrames();
+
+            buildPayload( seq, payload );
+
+            XBeeApiRxFrame frame(( seq & 1U ) ? XBEE_CMD_RX_64B_ADDR : XBEE_CMD_RX_16B_ADDR,
+                                 payload, (uint16_t)payloadLen( seq ));
+            ring.frameRxCallback( &frame );
+
+            if( lossless && ( ring.getDroppedFrames() != droppedBefore ))
+            {
+                /* Didn't fit - wait for the consumer to make some space */
+                std::this_thread::yield();
+            }
+            else
+            {
+                seq++;
+            }
+        }
+        done = true;
+    } );
+
+    while( ok &&
+           (( !done ) || ( ring.getFrameCount() > 0 )))
+    {
+        XBeeApiRxFrame frames[ STRESS_MAX_BATCH ];
+        uint32_t seqs[ STRESS_MAX_BATCH ];
+        bool intact[ STRESS_MAX_BATCH ];
+        const size_t droppedBefore = ring.getDroppedFrames();
+        size_t count;
+
+        seed = seed * 1103515245U + 12345U;
+        count = ring.getFrames( frames, 1U + (( seed >> 16 ) % STRESS_MAX_BATCH ));
+
+        for( size_t i = 0; i < count; i++ )
+        {
+            intact[ i ] = checkFrame( frames[ i ], &( seqs[ i ] ));
+        }
+
+        if(( !lossless ) &&
+           ( ring.getDroppedFrames() != droppedBefore ))
+        {
+            /* Frames in the batch may have been overwritten while being checked */
+            skipped++;
+            skippedFrames += count;
+        }
+        else
+        {
+            for( size_t i = 0; ok && ( i < count ); i++ )
+            {
+                if(( !intact[ i ] ) ||
+                   ( lossless ? ( seqs[ i ] != (uint32_t)( last + 1 )) : ( seqs[ i ] <= last )))
+                {
+                    printf( "frame %u corrupted or out of order (last good %lld)\r\n", (unsigned)seqs[ i ], (long long)last );
+                    ok = false;
+                }
+                last = seqs[ i ];
+                received++;
+            }
+        }
+
+        ring.pop( count );
+
+        if( count == 0 )
+        {
+            ring.waitForFrame( 1U );
+        }
+    }
+
+    producer.join();
+
+    const double secs = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    if( ok )
+    {
+        /* With the drop newest policy, frames which were dropped were sent again.  With the
+           drop oldest policy, frames in skipped batches may or may not have been dropped */
+        ok = lossless ? ( received == p_frames ) :
+                        (( received + ring.getDroppedFrames() <= p_frames ) &&
+                         ( received + ring.getDroppedFrames() + skippedFrames >= p_frames ));
+    }
+
+    printf( "%-11s %10u %10u %10u %8u %12.0f %s\r\n", lossless ? "drop newest" : "drop oldest",
+            (unsigned)p_frames, (unsigned)received, (unsigned)ring.getDroppedFrames(), (unsigned)skipped,
+            p_frames / secs, ok ? "ok" : "FAILED" );
+
+    return ok;
+}
+
+int main( int argc, char** argv )
+{
+    const uint32_t frames = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 10 ) : 2000000U;
+    const size_t size = ( argc > 2 ) ? strtoul( argv[ 2 ], NULL, 10 ) : 257U;
+    bool ok = true;
+
+    printf( "%-11s %10s %10s %10s %8s %12s\r\n", "policy", "sent", "received", "dropped", "skipped", "frames/s" );
+
+    ok &= runStress( XBeeApiRxFrameCircularBuffer::XBEE_API_RX_OVERFLOW_DROP_NEWEST, frames, size );
+    ok &= runStress( XBeeApiRxFrameCircularBuffer::XBEE_API_RX_OVERFLOW_DROP_OLDEST, frames, size );
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+/**
+   @file
+   @brief Check of the time taken for a thread blocked in
+          XBeeApiRxFrameCircularBuffer::waitForFrame() to wake up once a frame
+          arrives from the XBee, and of the CPU used while it waits.  The
+          XBee is simulated by a thread on the far side of a pseudo-terminal
+          which sends an RX frame at random intervals, timestamping each one
+          just before writing it, so no hardware is needed.  Received data
+          is handled by an XBeeApiGateway, as it would be on a Linux gateway.
+
+          The latency measured covers the whole path from the serial port:
+          the gateway's worker waking up, decoding the frame & adding it to
+          the buffer, and the waiting thread being signalled.  The check
+          fails in the case that the 99th percentile latency exceeds the
+          limit, or that the process uses more than a few percent of a CPU
+          while waiting (i.e. the wait is polling rather than blocking).
+
+          This example runs on a POSIX host rather than mbed.  Build with
+          XBEEAPI_CONFIG_POSIX and XBEEAPI_CONFIG_USING_STD_THREAD defined,
+          e.g.:
+
+          g++ -O2 -std=c++11 -pthread -DXBEEAPI_CONFIG_POSIX
+              -DXBEEAPI_CONFIG_USING_STD_THREAD -I<each src directory>
+              main.cpp <all src .cpp files> -lutil
+
+          Usage: latency [frames] [latency limit in microseconds]
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "xbeeapi.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Shortest & longest gaps between the frames sent by the simulated XBee, in microseconds.
+   Long enough that the waiting thread is always blocked when a frame arrives */
+#define LATENCY_MIN_GAP_US 2000U
+#define LATENCY_MAX_GAP_US 5000U
+
+/* Time to wait for each frame before giving up, in milliseconds */
+#define LATENCY_TIMEOUT_MS 1000U
+
+/* Largest share of a CPU the process may use while waiting for frames, in percent */
+#define LATENCY_MAX_CPU_PERCENT 5.0
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* Add a byte to a buffer of data being sent to the XBeeDevice, escaping it as needed */
+static void addEscaped( std::vector<uint8_t>& p_buff, const uint8_t p_byte )
+{
+    if(( p_byte == 0x7E ) || ( p_byte == 0x7D ) || ( p_byte == 0x11 ) || ( p_byte == 0x13 ))
+    {
+        p_buff.push_back( 0x7D );
+        p_buff.push_back( p_byte ^ 0x20 );
+    }
+    else
+    {
+        p_buff.push_back( p_byte );
+    }
+}
+
+/* Build a 16-bit addressed RX frame carrying a sequence number */
+static std::vector<uint8_t> buildFrame( const uint32_t p_seq )
+{
+    const uint8_t body[] = { XBEE_CMD_RX_16B_ADDR, 0x12, 0x34, 40U, 0U,
+                             (uint8_t)( p_seq >> 24 ), (uint8_t)( p_seq >> 16 ),
+                             (uint8_t)( p_seq >> 8 ), (uint8_t)p_seq };
+    std::vector<uint8_t> frame;
+    uint8_t sum = 0;
+
+    frame.push_back( 0x7E );
+    addEscaped( frame, 0 );
+    addEscaped( frame, sizeof( body ));
+    for( size_t i = 0; i < sizeof( body ); i++ )
+    {
+        addEscaped( frame, body[ i ] );
+        sum += body[ i ];
+    }
+    addEscaped( frame, 0xFF - sum );
+
+    return frame;
+}
+
+/* Total CPU time used by the process, in seconds */
+static double cpuTime( void )
+{
+    struct rusage usage;
+
+    getrusage( RUSAGE_SELF, &usage );
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) / 1e6 );
+}
+
+int main( int argc, char** argv )
+{
+    const uint32_t frames = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 10 ) : 1000U;
+    const double limitUs = ( argc > 2 ) ? strtod( argv[ 2 ], NULL ) : 1000.0;
+    int master;
+    int slave;
+    struct termios tio;
+
+    if( openpty( &master, &slave, NULL, NULL, NULL ) != 0 )
+    {
+        perror( "openpty" );
+        return 1;
+    }
+    tcgetattr( master, &tio );
+    cfmakeraw( &tio );
+    tcsetattr( master, TCSANOW, &tio );
+
+    XBeeApiTransportTermios transport( slave, true );
+    transport.configure( 115200 );
+
+    XBeeDevice device( &transport );
+    XBeeApiRxFrameCircularBuffer ring( XBeeApiRxBufferBytes( 1024 ), &device );
+    XBeeApiGateway gateway( 1U );
+
+    /* Time at which each frame was written, in nanoseconds since the clock's epoch */
+    std::vector<std::atomic<int64_t> > sentAt( frames );
+    std::vector<double> latencies;
+    uint32_t lost = 0;
+
+    gateway.addDevice( &device, &transport );
+    gateway.start();
+
+    /* The simulated XBee */
+    std::thread peer( [ & ]( void ) {
+        unsigned seed = 1;
+
+        for( uint32_t seq = 0; seq < frames; seq++ )
+        {
+            const std::vector<uint8_t> frame = buildFrame( seq );
+
+            seed = seed * 1103515245U + 12345U;
+            std::this_thread::sleep_for( std::chrono::microseconds( LATENCY_MIN_GAP_US +
+                                         (( seed >> 16 ) % ( LATENCY_MAX_GAP_US - LATENCY_MIN_GAP_US ))));
+
+            sentAt[ seq ] = std::chrono::duration_cast<std::chrono::nanoseconds>( bench_clock::now().time_since_epoch() ).count();
+            if( write( master, &( frame[ 0 ] ), frame.size() ) < 0 )
+            {
+                perror( "write" );
+            }
+        }
+    } );
+
+    const double cpuStart = cpuTime();
+    const bench_clock::time_point start = bench_clock::now();
+
+    while( latencies.size() + lost < frames )
+    {
+        const XBeeApiRxFrame* frame;
+        const size_t before = latencies.size();
+
+        ring.waitForFrame( LATENCY_TIMEOUT_MS );
+
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>( bench_clock::now().time_since_epoch() ).count();
+
+        while( NULL != ( frame = ring.getTailPtr() ))
+        {
+            const uint8_t* data;
+            uint16_t len;
+
+            frame->getDataPtr( 0, &data, &len );
+            if( len == sizeof( uint32_t ))
+            {
+                const uint32_t seq = ((uint32_t)data[ 0 ] << 24 ) | ((uint32_t)data[ 1 ] << 16 ) |
+                                     ((uint32_t)data[ 2 ] << 8 ) | data[ 3 ];
+
+                if( seq < frames )
+                {
+                    latencies.push_back(( now - sentAt[ seq ] ) / 1000.0 );
+                }
+            }
+            ring.pop();
+        }
+
+        if( latencies.size() == before )
+        {
+            /* Nothing arrived in time - the frame must have been lost */
+            lost++;
+        }
+    }
+
+    const double cpuPercent = 100.0 * ( cpuTime() - cpuStart ) /
+                              std::chrono::duration<double>( bench_clock::now() - start ).count();
+
+    peer.join();
+    gateway.stop();
+    close( master );
+
+    bool ok = ( lost == 0 ) && ( !latencies.empty() );
+
+    printf( "frames %u, lost %u, CPU %.1f%%\r\n", (unsigned)frames, (unsigned)lost, cpuPercent );
+
+    if( !latencies.empty() )
+    {
+        std::sort( latencies.begin(), latencies.end() );
+
+        const double p99 = latencies[( latencies.size() * 99U ) / 100U ];
+
+        printf( "wake-up latency (us): min %.1f median %.1f 99%% %.1f max %.1f\r\n",
+                latencies.front(), latencies[ latencies.size() / 2U ], p99, latencies.back() );
+
+        ok &= ( p99 <= limitUs );
+    }
+
+    ok &= ( cpuPercent <= LATENCY_MAX_CPU_PERCENT );
+
+    printf( "%s\r\n", ok ? "ok" : "FAILED" );
+
+    return ok ? 0 : 1;
+}
@@ -54,8 +54,9 @@ const uint16_t frameDestinationAddress = 0x01;
 XBeeDevice xbeeDevice( XBEE_TX_PIN, XBEE_RX_PIN, NC, NC );
 
 /** Circular buffer to receive the data frames from the XBee.  Any frames
-    that won't fit in the buffer when they are received will be lost */
-XBeeApiRxFrameCircularBuffer rxBuffer( 10, &xbeeDevice );
+    that won't fit in the buffer when they are received will be lost.  The
+    size is in bytes - the number of frames held depends on their length */
+XBeeApiRxFrameCircularBuffer rxBuffer( XBeeApiRxBufferBytes( 1024 ), &xbeeDevice );
   
 void dumpFrame( const XBeeApiRxFrame* const p_frame )
 {
@@ -92,9 +93,10 @@ int main() {
 		const XBeeApiRxFrame* frameP;
 		while( 1 )
 		{
-			/* Wait for a while, report how many frames are in the buffer then clear
-			   clear the buffer out for the next loop around */
-			wait(10);
+			/* Wait for frames to arrive (giving up after a while), report how many
+			   frames are in the buffer then clear the buffer out for the next loop 
+			   around */
+			rxBuffer.waitForFrame( 10000 );
 
 			pc.printf("Received frames: %d\r\n",rxBuffer.getFrameCount() );
 
@@ -0,0 +1,440 @@
+/**
+   @file
+   @brief Check of XBeeApiTxFramePooled, the fire-and-forget TX frames which
+          return to their pool once the XBee reports the status of the
+          transmission.  The XBee is simulated by a thread on the far side of
+          a pseudo-terminal which reports the status of each transmission
+          after a delay, so no hardware is needed.  Received data is handled
+          by an XBeeApiGateway, as it would be on a Linux gateway.
+
+          Each run sends enough frames to exhaust the pool, building every
+          payload in a buffer on the stack which is overwritten as soon as
+          the frame has been sent, then checks that:
+            - A further send fails while the pool is exhausted.
+            - The simulated XBee received every payload intact.
+            - Every frame's call-back was called with the status reported.
+            - Every frame has returned to the pool.
+
+          Runs are made with the XBee reporting success and failure, as the
+          frames must return to the pool either way.  A frame with an
+          over-long payload must be refused without using up the pool.
+
+          This example runs on a POSIX host rather than mbed.  Build with
+          XBEEAPI_CONFIG_POSIX and XBEEAPI_CONFIG_USING_STD_THREAD defined,
+          e.g.:
+
+          g++ -O2 -std=c++11 -pthread -DXBEEAPI_CONFIG_POSIX
+              -DXBEEAPI_CONFIG_USING_STD_THREAD -I<each src directory>
+              main.cpp <all src .cpp files> -lutil
+
+          Usage: check [rounds]
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "xbeeapi.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Delay before the simulated XBee reports the status of each transmission.  Long enough
+   for the pool to be exhausted before the first status arrives */
+#define CHECK_STATUS_DELAY_MS 100U
+
+/* Time allowed for all of the statuses to arrive */
+#define CHECK_TIMEOUT_MS 2000U
+
+/* Length of the payload of each frame sent */
+#define CHECK_PAYLOAD_LEN 40U
+
+/* Add a byte to a buffer of data being sent to the XBeeDevice, escaping it as needed */
+static void addEscaped( std::vector<uint8_t>& p_buff, const uint8_t p_byte )
+{
+    if(( p_byte == 0x7E ) || ( p_byte == 0x7D ) || ( p_byte == 0x11 ) || ( p_byte == 0x13 ))
+    {
+        p_buff.push_back( 0x7D );
+        p_buff.push_back( p_byte ^ 0x20 );
+    }
+    else
+    {
+        p_buff.push_back( p_byte );
+    }
+}
+
+/* Fill in the payload of frame p_seq of a run */
+static void buildPayload( const uint8_t p_seq, uint8_t* const p_buff )
+{
+    for( size_t i = 0; i < CHECK_PAYLOAD_LEN; i++ )
+    {
+        p_buff[ i ] = (uint8_t)( p_seq * 31U + i );
+    }
+}
+
+/* The far side of the pseudo-terminal: an XBee which reports the status of each TX
+   request after a delay, keeping a copy of the payloads it has received */
+class SimPeer
+{
+    protected:
+        typedef std::chrono::steady_clock clock;
+
+        int                  m_fd;
+        std::atomic<uint8_t> m_status;
+        std::atomic<bool>    m_running;
+        std::thread          m_thread;
+
+        /* Frame being received, from the length onwards, un-escaped */
+        std::vector<uint8_t> m_rx;
+        bool                 m_rxEsc;
+
+        /* TX statuses waiting for their delay to expire, keyed by the time they're due */
+        std::multimap<clock::time_point, std::vector<uint8_t> > m_responses;
+
+        /* Payloads of the TX requests received */
+        std::mutex                         m_payloadsLock;
+        std::vector<std::vector<uint8_t> > m_payloads;
+
+        /* Deal with a complete frame body (API identifier onwards, without the checksum) */
+        void handleFrame( const uint8_t* const p_body, const size_t p_len )
+        {
+            /* API identifier, frame identifier, 16-bit address & options precede the data */
+            if(( p_len >= 5U ) && ( p_body[ 0 ] == XBEE_CMD_TX_16B_ADDR ))
+            {
+                std::vector<uint8_t> frame;
+                const uint8_t body[] = { XBEE_CMD_TX_STATUS, p_body[ 1 ], m_status };
+                uint8_t sum = 0;
+
+                frame.push_back( 0x7E );
+                addEscaped( frame, 0 );
+                addEscaped( frame, sizeof( body ));
+                for( size_t i = 0; i < sizeof( body ); i++ )
+                {
+                    addEscaped( frame, body[ i ] );
+                    sum += body[ i ];
+                }
+                addEscaped( frame, 0xFF - sum );
+
+                m_responses.insert( std::make_pair( clock::now() + std::chrono::milliseconds( CHECK_STATUS_DELAY_MS ), frame ));
+
+                std::lock_guard<std::mutex> lock( m_payloadsLock );
+                m_payloads.push_back( std::vector<uint8_t>( p_body + 5U, p_body + p_len ));
+            }
+        }
+
+        /* Process bytes received from the XBeeDevice */
+        void receive( const uint8_t* p_data, size_t p_len )
+        {
+            while( p_len-- )
+            {
+                uint8_t b = *(p_data++);
+
+                if( b == 0x7E )
+                {
+                    m_rx.clear();
+                    m_rxEsc = false;
+                    continue;
+                }
+                if( b == 0x7D )
+                {
+                    m_rxEsc = true;
+                    continue;
+                }
+                if( m_rxEsc )
+                {
+                    b ^= 0x20;
+                    m_rxEsc = false;
+                }
+
+                m_rx.push_back( b );
+
+                /* Length, body & checksum */
+                if(( m_rx.size() >= 2U ) &&
+                   ( m_rx.size() == ((size_t)( m_rx[ 0 ] << 8 ) | m_rx[ 1 ] ) + 3U ))
+                {
+                    uint8_t sum = 0;
+
+                    for( size_t i = 2; i < m_rx.size(); i++ )
+                    {
+                        sum += m_rx[ i ];
+                    }
+                    if( sum == 0xFF )
+                    {
+                        handleFrame( &( m_rx[ 2 ] ), m_rx.size() - 3U );
+                    }
+                    m_rx.clear();
+                }
+            }
+        }
+
+        void run( void )
+        {
+            while( m_running )
+            {
+                struct pollfd pfd;
+                int timeout = 10;
+                uint8_t buff[ 256 ];
+
+                if( !m_responses.empty() )
+                {
+                    const long due = (long)std::chrono::duration_cast<std::chrono::milliseconds>( m_responses.begin()->first - clock::now() ).count();
+                    timeout = ( due < 0 ) ? 0 : (( due < timeout ) ? (int)due : timeout );
+                }
+
+                pfd.fd = m_fd;
+                pfd.events = POLLIN;
+
+                if( poll( &pfd, 1, timeout ) > 0 )
+                {
+                    const ssize_t len = read( m_fd, buff, sizeof( buff ));
+
+                    if( len > 0 )
+                    {
+                        receive( buff, (size_t)len );
+                    }
+                }
+
+                while(( !m_responses.empty() ) &&
+                      ( m_responses.begin()->first <= clock::now() ))
+                {
+                    const std::vector<uint8_t>& frame = m_responses.begin()->second;
+
+                    if( write( m_fd, &( frame[ 0 ] ), frame.size() ) < 0 )
+                    {
+                        perror( "write" );
+                    }
+                    m_responses.erase( m_responses.begin() );
+                }
+            }
+        }
+
+    public:
+        SimPeer( const int p_fd ) : m_fd( p_fd ),
+                                    m_status( 0 ),
+                                    m_running( false ),
+                                    m_rxEsc( false )
+        {
+        }
+
+        void start( void )
+        {
+            m_running = true;
+            m_thread = std::thread( &SimPeer::run, this );
+        }
+
+        void stop( void )
+        {
+            m_running = false;
+            m_thread.join();
+        }
+
+        /* Set the status reported for subsequent TX requests */
+        void setStatus( const uint8_t p_status )
+        {
+            m_status = p_status;
+        }
+
+        /* Retrieve & clear the payloads received so far */
+        std::vector<std::vector<uint8_t> > takePayloads( void )
+        {
+            std::lock_guard<std::mutex> lock( m_payloadsLock );
+            std::vector<std::vector<uint8_t> > ret_val;
+
+            ret_val.swap( m_payloads );
+
+            return ret_val;
+        }
+};
+
+/* Statuses received by txCallback() */
+struct CheckState
+{
+    std::atomic<unsigned> m_ok;
+    std::atomic<unsigned> m_failed;
+};
+
+/* Called from the gateway's worker as each TX status arrives, before the frame returns to
+   the pool */
+static void txCallback( XBeeApiTxFrame* const p_frame, const XBeeApiTxFrame::XBeeApiTxStatus_e p_status, void* const p_ctx )
+{
+    CheckState* const state = (CheckState*)p_ctx;
+
+    (void)p_frame;
+
+    if( p_status == XBeeApiTxFrame::XBEE_API_TX_STATUS_OK )
+    {
+        state->m_ok++;
+    }
+    else
+    {
+        state->m_failed++;
+    }
+}
+
+/* Exhaust the pool with the XBee reporting p_status for each frame, returning false in
+   the case that any of the checks fail */
+static bool runCheck( XBeeDevice* const p_device, SimPeer* const p_peer, const XBeeApiTxFrame::XBeeApiTxStatus_e p_status )
+{
+    const unsigned frames = XBEEAPI_CONFIG_TX_POOL_FRAMES;
+    CheckState state;
+    bool ok = true;
+
+    state.m_ok = 0;
+    state.m_failed = 0;
+    p_peer->setStatus( (uint8_t)p_status );
+
+    for( unsigned i = 0; ok && ( i < frames ); i++ )
+    {
+        uint8_t payload[ CHECK_PAYLOAD_LEN ];
+
+        buildPayload( (uint8_t)i, payload );
+        ok = XBeeApiTxFramePooled::send( p_device, 0x1234, payload, sizeof( payload ),
+                                         XBeeDevice::XBEE_API_ADDR_TYPE_16BIT, txCallback, &state );
+        /* The frame must have its own copy of the payload */
+        memset( payload, 0, sizeof( payload ));
+    }
+
+    if( !ok )
+    {
+        printf( "send failed with %u frames free\r\n", (unsigned)XBeeApiTxFramePooled::getFreeCount() );
+    }
+    else if( XBeeApiTxFramePooled::getFreeCount() != 0 )
+    {
+        printf( "%u frames free after exhausting the pool\r\n", (unsigned)XBeeApiTxFramePooled::getFreeCount() );
+        ok = false;
+    }
+    else
+    {
+        uint8_t payload[ CHECK_PAYLOAD_LEN ] = { 0 };
+
+        if( XBeeApiTxFramePooled::send( p_device, 0x1234, payload, sizeof( payload )))
+        {
+            printf( "send succeeded with the pool exhausted\r\n" );
+            ok = false;
+        }
+    }
+
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+                                                           std::chrono::milliseconds( CHECK_TIMEOUT_MS );
+
+    while((( state.m_ok + state.m_failed ) < frames ) &&
+          ( std::chrono::steady_clock::now() < deadline ))
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ));
+    }
+
+    /* Statuses for any extra frames would arrive after the delay */
+    std::this_thread::sleep_for( std::chrono::milliseconds( CHECK_STATUS_DELAY_MS ));
+
+    const std::vector<std::vector<uint8_t> > payloads = p_peer->takePayloads();
+
+    for( size_t i = 0; ok && ( i < payloads.size() ); i++ )
+    {
+        uint8_t expected[ CHECK_PAYLOAD_LEN ];
+
+        buildPayload( (uint8_t)i, expected );
+        if(( payloads[ i ].size() != sizeof( expected )) ||
+           ( memcmp( &( payloads[ i ][ 0 ] ), expected, sizeof( expected )) != 0 ))
+        {
+            printf( "payload %u corrupted\r\n", (unsigned)i );
+            ok = false;
+        }
+    }
+
+    const unsigned expectedOk = ( p_status == XBeeApiTxFrame::XBEE_API_TX_STATUS_OK ) ? frames : 0U;
+
+    if(( payloads.size() != frames ) ||
+       ( state.m_ok != expectedOk ) ||
+       ( state.m_failed != ( frames - expectedOk )) ||
+       ( XBeeApiTxFramePooled::getFreeCount() != frames ))
+    {
+        printf( "sent %u received %u ok %u failed %u free %u\r\n", frames, (unsigned)payloads.size(),
+                (unsigned)state.m_ok, (unsigned)state.m_failed, (unsigned)XBeeApiTxFramePooled::getFreeCount() );
+        ok = false;
+    }
+
+    return ok;
+}
+
+int main( int argc, char** argv )
+{
+    const unsigned rounds = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 3U;
+    static const uint8_t oversize[ XBEE_API_MAX_TX_PAYLOAD_LEN + 1U ] = { 0 };
+    int master;
+    int slave;
+    struct termios tio;
+    bool ok = true;
+
+    if( openpty( &master, &slave, NULL, NULL, NULL ) != 0 )
+    {
+        perror( "openpty" );
+        return 1;
+    }
+    tcgetattr( master, &tio );
+    cfmakeraw( &tio );
+    tcsetattr( master, TCSANOW, &tio );
+
+    XBeeApiTransportTermios transport( slave, true );
+    transport.configure( 115200 );
+
+    XBeeDevice device( &transport );
+    XBeeApiGateway gateway( 1U );
+    SimPeer peer( master );
+
+    gateway.addDevice( &device, &transport );
+    gateway.start();
+    peer.start();
+
+    if( XBeeApiTxFramePooled::send( &device, 0x1234, oversize, sizeof( oversize )) ||
+        ( XBeeApiTxFramePooled::getFreeCount() != XBEEAPI_CONFIG_TX_POOL_FRAMES ))
+    {
+        printf( "over-long payload: FAILED\r\n" );
+        ok = false;
+    }
+
+    for( unsigned i = 0; i < rounds; i++ )
+    {
+        const bool succeed = (( i & 1U ) == 0 );
+        const bool roundOk = runCheck( &device, &peer, succeed ? XBeeApiTxFrame::XBEE_API_TX_STATUS_OK :
+                                                                 XBeeApiTxFrame::XBEE_API_TX_STATUS_NO_ACK );
+
+        printf( "round %u (%s): %s\r\n", i, succeed ? "success" : "no ACK", roundOk ? "ok" : "FAILED" );
+        ok &= roundOk;
+    }
+
+    gateway.stop();
+    peer.stop();
+    close( master );
+
+    printf( "pool low water %u of %u\r\n", (unsigned)XBeeApiTxFramePooled::getFreeLowWater(), (unsigned)XBEEAPI_CONFIG_TX_POOL_FRAMES );
+    printf( "%s\r\n", ok ? "ok" : "FAILED" );
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,361 @@
+/**
+   @file
+   @brief Benchmark of XBeeDevice's TX queue, measuring the rate at which
+          frames are transmitted as the TX window (the number of frames
+          which may await a TX status at once - see
+          XBeeDevice::setTxWindow()) increases.  The XBee is simulated by a
+          thread on the far side of a pseudo-terminal which reports the
+          status of each transmission after a fixed latency, standing in for
+          the time taken to deliver the frame over the air, so no hardware
+          is needed.
+
+          With a window of 1 each frame has to wait for the status of the
+          previous one, so the rate is limited to one frame per latency
+          period.  Larger windows should scale the rate up until the link
+          or the CPU becomes the limit.
+
+          This example runs on a POSIX host rather than mbed.  Build with
+          XBEEAPI_CONFIG_POSIX and XBEEAPI_CONFIG_USING_STD_THREAD defined,
+          e.g.:
+
+          g++ -O2 -std=c++11 -pthread -DXBEEAPI_CONFIG_POSIX
+              -DXBEEAPI_CONFIG_USING_STD_THREAD -I<each src directory>
+              main.cpp <all src .cpp files> -lutil
+
+          Usage: benchmark [seconds per run] [TX status latency in milliseconds]
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "xbeeapi.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Number of bytes of data in each frame transmitted */
+#define BENCH_PAYLOAD_LEN 20U
+
+/* Number of frames kept circulating through the TX queue - enough to fill the largest
+   window with the rest waiting in the queue */
+#define BENCH_FRAMES XBEEAPI_CONFIG_TX_QUEUE_SIZE
+
+/* TX status reported by the simulated XBee: success */
+#define SIM_TX_STATUS_SUCCESS 0U
+
+/* Add a byte to a buffer of data being sent to the XBeeDevice, escaping it as needed */
+static void addEscaped( std::vector<uint8_t>& p_buff, const uint8_t p_byte )
+{
+    if(( p_byte == 0x7E ) || ( p_byte == 0x7D ) || ( p_byte == 0x11 ) || ( p_byte == 0x13 ))
+    {
+        p_buff.push_back( 0x7D );
+        p_buff.push_back( p_byte ^ 0x20 );
+    }
+    else
+    {
+        p_buff.push_back( p_byte );
+    }
+}
+
+/* The far side of the pseudo-terminal: an XBee which reports the status of each TX
+   request after a fixed latency */
+class SimPeer
+{
+    protected:
+        typedef std::chrono::steady_clock clock;
+
+        int                  m_fd;
+        unsigned             m_latencyMs;
+        std::atomic<bool>    m_running;
+        std::thread          m_thread;
+
+        /* Frame being received, from the length onwards, un-escaped */
+        std::vector<uint8_t> m_rx;
+        bool                 m_rxEsc;
+
+        /* TX statuses waiting for their latency to expire, keyed by the time they're due */
+        std::multimap<clock::time_point, std::vector<uint8_t> > m_responses;
+
+        /* Deal with a complete frame body (API identifier onwards, without the checksum) */
+        void handleFrame( const uint8_t* const p_body, const size_t p_len )
+        {
+            if(( p_len >= 2U ) &&
+               (( p_body[ 0 ] == XBEE_CMD_TX_16B_ADDR ) || ( p_body[ 0 ] == XBEE_CMD_TX_64B_ADDR )))
+            {
+                std::vector<uint8_t> frame;
+                const uint8_t body[] = { XBEE_CMD_TX_STATUS, p_body[ 1 ], SIM_TX_STATUS_SUCCESS };
+                uint8_t sum = 0;
+
+                frame.push_back( 0x7E );
+                addEscaped( frame, 0 );
+                addEscaped( frame, sizeof( body ));
+                for( size_t i = 0; i < sizeof( body ); i++ )
+                {
+                    addEscaped( frame, body[ i ] );
+                    sum += body[ i ];
+                }
+                addEscaped( frame, 0xFF - sum );
+
+                m_responses.insert( std::make_pair( clock::now() + std::chrono::milliseconds( m_latencyMs ), frame ));
+            }
+        }
+
+        /* Process bytes received from the XBeeDevice */
+        void receive( const uint8_t* p_data, size_t p_len )
+        {
+            while( p_len-- )
+            {
+                uint8_t b = *(p_data++);
+
+                if( b == 0x7E )
+                {
+                    m_rx.clear();
+                    m_rxEsc = false;
+                    continue;
+                }
+                if( b == 0x7D )
+                {
+                    m_rxEsc = true;
+                    continue;
+                }
+                if( m_rxEsc )
+                {
+                    b ^= 0x20;
+                    m_rxEsc = false;
+                }
+
+                m_rx.push_back( b );
+
+                /* Length, body & checksum */
+                if(( m_rx.size() >= 2U ) &&
+                   ( m_rx.size() == ((size_t)( m_rx[ 0 ] << 8 ) | m_rx[ 1 ] ) + 3U ))
+                {
+                    uint8_t sum = 0;
+
+                    for( size_t i = 2; i < m_rx.size(); i++ )
+                    {
+                        sum += m_rx[ i ];
+                    }
+                    if( sum == 0xFF )
+                    {
+                        handleFrame( &( m_rx[ 2 ] ), m_rx.size() - 3U );
+                    }
+                    m_rx.clear();
+                }
+            }
+        }
+
+        void run( void )
+        {
+            while( m_running )
+            {
+                struct pollfd pfd;
+                int timeout = 10;
+                uint8_t buff[ 256 ];
+
+                if( !m_responses.empty() )
+                {
+                    const long due = (long)std::chrono::duration_cast<std::chrono::milliseconds>( m_responses.begin()->first - clock::now() ).count();
+                    timeout = ( due < 0 ) ? 0 : (( due < timeout ) ? (int)due : timeout );
+                }
+
+                pfd.fd = m_fd;
+                pfd.events = POLLIN;
+
+                if( poll( &pfd, 1, timeout ) > 0 )
+                {
+                    const ssize_t len = read( m_fd, buff, sizeof( buff ));
+
+                    if( len > 0 )
+                    {
+                        receive( buff, (size_t)len );
+                    }
+                }
+
+                while(( !m_responses.empty() ) &&
+                      ( m_responses.begin()->first <= clock::now() ))
+                {
+                    const std::vector<uint8_t>& frame = m_responses.begin()->second;
+
+                    if( write( m_fd, &( frame[ 0 ] ), frame.size() ) < 0 )
+                    {
+                        perror( "write" );
+                    }
+                    m_responses.erase( m_responses.begin() );
+                }
+            }
+        }
+
+    public:
+        SimPeer( const int p_fd, const unsigned p_latencyMs ) : m_fd( p_fd ),
+                                                                m_latencyMs( p_latencyMs ),
+                                                                m_running( false ),
+                                                                m_rxEsc( false )
+        {
+        }
+
+        void start( void )
+        {
+            m_running = true;
+            m_thread = std::thread( &SimPeer::run, this );
+        }
+
+        void stop( void )
+        {
+            m_running = false;
+            m_thread.join();
+        }
+};
+
+/* State shared with the TX status call-back */
+struct BenchState
+{
+    XBeeDevice*                m_device;
+    std::atomic<bool>          m_running;
+    std::atomic<unsigned long> m_sent;
+    std::atomic<unsigned long> m_failed;
+};
+
+/* Called from the gateway's worker as each TX status arrives.  The frame is put straight
+   back on the queue, keeping the queue topped up for as long as the run lasts */
+static void txCallback( XBeeApiTxFrame* const p_frame, const XBeeApiTxFrame::XBeeApiTxStatus_e p_status, void* const p_ctx )
+{
+    BenchState* const state = (BenchState*)p_ctx;
+
+    if( p_status == XBeeApiTxFrame::XBEE_API_TX_STATUS_OK )
+    {
+        state->m_sent++;
+    }
+    else
+    {
+        state->m_failed++;
+    }
+
+    if( state->m_running )
+    {
+        state->m_device->queueFrame( p_frame );
+    }
+}
+
+/* Measure the rate at which frames are transmitted with a TX window of p_window, returning
+   the rate in frames per second */
+static double runWindow( const size_t p_window, const unsigned p_seconds, const unsigned p_latencyMs )
+{
+    static const uint8_t payload[ BENCH_PAYLOAD_LEN ] = { 0 };
+    int master;
+    int slave;
+    struct termios tio;
+    BenchState state;
+
+    if( openpty( &master, &slave, NULL, NULL, NULL ) != 0 )
+    {
+        perror( "openpty" );
+        exit( 1 );
+    }
+    tcgetattr( master, &tio );
+    cfmakeraw( &tio );
+    tcsetattr( master, TCSANOW, &tio );
+
+    XBeeApiTransportTermios transport( slave, true );
+    transport.configure( 115200 );
+
+    XBeeDevice device( &transport );
+    XBeeApiGateway gateway( 1U );
+    SimPeer peer( master, p_latencyMs );
+    XBeeApiTxFrame frames[ BENCH_FRAMES ];
+
+    state.m_device = &device;
+    state.m_running = true;
+    state.m_sent = 0;
+    state.m_failed = 0;
+
+    device.setTxWindow( p_window );
+    gateway.addDevice( &device, &transport );
+    gateway.start();
+    peer.start();
+
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    for( size_t i = 0; i < BENCH_FRAMES; i++ )
+    {
+        frames[ i ].setDestAddr( 0x1234 );
+        frames[ i ].setDataPtr( payload, sizeof( payload ));
+        frames[ i ].setTxCallback( txCallback, &state );
+        device.queueFrame( &( frames[ i ] ));
+    }
+
+    std::this_thread::sleep_for( std::chrono::seconds( p_seconds ));
+    state.m_running = false;
+
+    const unsigned long sent = state.m_sent;
+    const double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+
+    /* The frames must not be transmitted (or receive a status) once they've gone out of
+       scope */
+    gateway.stop();
+    peer.stop();
+    for( size_t i = 0; i < BENCH_FRAMES; i++ )
+    {
+        device.cancelFrame( &( frames[ i ] ));
+    }
+    close( master );
+
+    if( state.m_failed != 0 )
+    {
+        printf( "window %u: %lu frames failed\r\n", (unsigned)p_window, (unsigned long)state.m_failed );
+    }
+
+    return sent / elapsed;
+}
+
+int main( int argc, char** argv )
+{
+    const unsigned seconds = ( argc > 1 ) ? atoi( argv[ 1 ] ) : 2U;
+    const unsigned latencyMs = ( argc > 2 ) ? atoi( argv[ 2 ] ) : 5U;
+    double baseline = 0;
+
+    printf( "TX status latency %u ms\r\n", latencyMs );
+    printf( "window   frames/s   ideal/s  vs window 1\r\n" );
+
+    for( size_t window = 1; window <= XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; window *= 2U )
+    {
+        const double rate = runWindow( window, seconds, latencyMs );
+
+        if( window == 1U )
+        {
+            baseline = rate;
+        }
+
+        printf( "%6u %10.0f %9.0f %11.2fx\r\n", (unsigned)window, rate,
+                ( latencyMs > 0 ) ? ( window * 1000.0 / latencyMs ) : 0.0,
+                ( baseline > 0 ) ? ( rate / baseline ) : 0.0 );
+    }
+
+    return 0;
+}
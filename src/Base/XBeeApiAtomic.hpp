@@ -0,0 +1,145 @@
+/**
+   @file
+   @brief Class to share an index between a single writer and a single
+          reader running in different contexts, without locking
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIATOMIC_HPP
+#define      XBEEAPIATOMIC_HPP
+
+#include <stddef.h>
+
+#if __cplusplus >= 201103L
+#include <atomic>
+#else
+#include "mbed.h" // For __DMB()
+#include "XBeeApiCriticalSection.hpp"
+#endif
+
+/** Index (or counter) which is written by one context and read by another.  Writes
+    have release semantics & reads acquire semantics, meaning that any data written
+    before the index is updated is visible to a reader which sees the new index value.
+    Only the context which owns the index may write it using store(); an index which
+    is written by more than one context must only be updated using compareExchange().
+
+    Where the compiler supports C++11 std::atomic is used.  Otherwise, the index is
+    a volatile word (which Cortex-M cores read & write atomically) with a data memory
+    barrier providing the ordering. */
+class XBeeApiAtomicIndex
+{
+    protected:
+#if __cplusplus >= 201103L
+        /** The value of the index */
+        std::atomic<size_t> m_value;
+#else
+        /** The value of the index */
+        volatile size_t     m_value;
+#endif
+
+    public:
+        /** Constructor
+
+            \param p_value Initial value */
+        XBeeApiAtomicIndex( const size_t p_value = 0 ) : m_value( p_value )
+        {
+        }
+
+        /** Read the index, as written by another context */
+        size_t load( void ) const
+        {
+#if __cplusplus >= 201103L
+            return m_value.load( std::memory_order_acquire );
+#else
+            const size_t ret_val = m_value;
+            __DMB();
+            return ret_val;
+#endif
+        }
+
+        /** Read the index from the context which owns it.  No ordering is required as
+            the value can only have been written by the same context */
+        size_t loadOwn( void ) const
+        {
+#if __cplusplus >= 201103L
+            return m_value.load( std::memory_order_relaxed );
+#else
+            return m_value;
+#endif
+        }
+
+        /** Update the index, publishing any data written beforehand to the reader */
+        void store( const size_t p_value )
+        {
+#if __cplusplus >= 201103L
+            m_value.store( p_value, std::memory_order_release );
+#else
+            __DMB();
+            m_value = p_value;
+#endif
+        }
+
+        /** Update the index only if it still holds an expected value.  Used in the (rare)
+            cases where an index needs to be written by more than one context
+
+            \param p_expected Value which the index is expected to hold.  Updated with the
+                              value actually held in the case that it differs
+            \param p_value New value for the index
+            \returns true in the case that the index was updated */
+        bool compareExchange( size_t& p_expected, const size_t p_value )
+        {
+#if __cplusplus >= 201103L
+            return m_value.compare_exchange_strong( p_expected, p_value, std::memory_order_acq_rel );
+#else
+            XBeeApiCriticalSection cs;
+            bool ret_val = false;
+
+            if( m_value == p_expected )
+            {
+                __DMB();
+                m_value = p_value;
+                ret_val = true;
+            }
+            else
+            {
+                p_expected = m_value;
+                __DMB();
+            }
+
+            return ret_val;
+#endif
+        }
+
+        /** Full memory barrier - stores before the barrier are visible to other contexts 
+            before any loads after it are performed.  Needed where each of two contexts 
+            updates one index and then checks the other, to be sure that at least one of 
+            them sees the other's update */
+        static void fence( void )
+        {
+#if __cplusplus >= 201103L
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+#else
+            __DMB();
+#endif
+        }
+};
+
+#endif
@@ -0,0 +1,131 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiBlockPool.hpp"
+
+XBeeApiBlockPool::XBeeApiBlockPool( void** const p_storage, const size_t p_blockSize, const size_t p_blockCount ) :
+    m_free( NULL ),
+    m_storage( p_storage ),
+    m_blockWords( XBEE_API_BLOCK_POOL_BLOCK_WORDS( p_blockSize ) ),
+    m_blockSize( p_blockSize ),
+    m_blockCount( p_blockCount ),
+    m_freeCount( p_blockCount ),
+    m_freeLowWater( p_blockCount )
+{
+    if( m_blockWords == 0 )
+    {
+        m_blockWords = 1;
+    }
+
+    /* Thread all of the blocks onto the free list, lowest address first */
+    for( size_t i = p_blockCount;
+         i > 0;
+         i-- )
+    {
+        void** const block = m_storage + (( i - 1U ) * m_blockWords );
+        *block = m_free;
+        m_free = block;
+    }
+}
+
+void* XBeeApiBlockPool::alloc( void )
+{
+    XBeeApiCriticalSection cs( m_lock );
+    void** const ret_val = m_free;
+
+    if( ret_val != NULL )
+    {
+        m_free = (void**)*ret_val;
+        m_freeCount--;
+
+        if( m_freeCount < m_freeLowWater )
+        {
+            m_freeLowWater = m_freeCount;
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiBlockPool::free( void* const p_block )
+{
+    bool ret_val = ( p_block == NULL );
+
+    if( owns( p_block ))
+    {
+        XBeeApiCriticalSection cs( m_lock );
+        void** const block = (void**)p_block;
+
+        ret_val = true;
+
+#if defined XBEEAPI_CONFIG_DEBUG
+        /* Adding a block which is already on the free list would allow it to be allocated
+           twice */
+        for( const void* const* free = m_free;
+             free != NULL;
+             free = (const void* const*)*free )
+        {
+            if( free == block )
+            {
+                ret_val = false;
+                break;
+            }
+        }
+
+        if( ret_val )
+#endif
+        {
+            *block = m_free;
+            m_free = block;
+            m_freeCount++;
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiBlockPool::owns( const void* const p_ptr ) const
+{
+    const uint8_t* const ptr = (const uint8_t*)p_ptr;
+    const uint8_t* const start = (const uint8_t*)m_storage;
+    const size_t blockBytes = m_blockWords * sizeof( void* );
+
+    return(( ptr >= start ) &&
+           ( ptr < ( start + ( m_blockCount * blockBytes ))) &&
+           ((( ptr - start ) % blockBytes ) == 0 ));
+}
+
+size_t XBeeApiBlockPool::getBlockSize( void ) const
+{
+    return m_blockSize;
+}
+
+size_t XBeeApiBlockPool::getBlockCount( void ) const
+{
+    return m_blockCount;
+}
+
+size_t XBeeApiBlockPool::getFreeCount( void ) const
+{
+    return m_freeCount;
+}
+
+size_t XBeeApiBlockPool::getFreeLowWater( void ) const
+{
+    return m_freeLowWater;
+}
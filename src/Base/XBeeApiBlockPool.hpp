@@ -0,0 +1,113 @@
+/**
+   @file
+   @brief Pool of fixed-size memory blocks, allowing memory to be allocated
+          & released without using the heap
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIBLOCKPOOL_HPP
+#define      XBEEAPIBLOCKPOOL_HPP
+
+#include "XBeeApiCriticalSection.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Number of pointer-sized words required to hold a block of _size bytes.  Blocks are
+    rounded up to a whole number of words so that each one is suitably aligned to hold
+    the free list link */
+#define XBEE_API_BLOCK_POOL_BLOCK_WORDS( _size ) ((( _size ) + sizeof( void* ) - 1U ) / sizeof( void* ))
+
+/** Number of pointer-sized words of storage required by a pool of _count blocks of _size
+    bytes - see XBeeApiBlockPool::XBeeApiBlockPool() */
+#define XBEE_API_BLOCK_POOL_STORAGE_WORDS( _size, _count ) ( XBEE_API_BLOCK_POOL_BLOCK_WORDS( _size ) * ( _count ))
+
+/** Class to manage a pool of fixed-size blocks of memory.  Free blocks are kept on a
+    linked list threaded through the blocks themselves, so allocation & release are O(1)
+    and the pool has no memory overhead beyond the storage itself.  The pool may be used
+    from interrupt context.
+
+    Example:
+
+        static void* storage[ XBEE_API_BLOCK_POOL_STORAGE_WORDS( 100, 8 ) ];
+        static XBeeApiBlockPool pool( storage, 100, 8 );
+*/
+class XBeeApiBlockPool
+{
+    protected:
+        /** Head of the list of free blocks.  The first word of each free block points to
+            the next free block */
+        void**  m_free;
+        /** Start of the memory used for the blocks */
+        void**  m_storage;
+        /** Size of each block in words */
+        size_t  m_blockWords;
+        /** Size of each block in bytes, as requested by the user */
+        size_t  m_blockSize;
+        /** Total number of blocks in the pool */
+        size_t  m_blockCount;
+        /** Number of blocks currently free */
+        size_t  m_freeCount;
+        /** Lowest value m_freeCount has had */
+        size_t  m_freeLowWater;
+        /** Lock guarding the free list */
+        XBeeApiCriticalSectionLock m_lock;
+
+    public:
+        /** Constructor
+
+            \param p_storage Memory to be used for the blocks.  Must be at least
+                             XBEE_API_BLOCK_POOL_STORAGE_WORDS( p_blockSize, p_blockCount ) words
+            \param p_blockSize Size of each block in bytes
+            \param p_blockCount Number of blocks */
+        XBeeApiBlockPool( void** const p_storage, const size_t p_blockSize, const size_t p_blockCount );
+
+        /** Allocate a block
+
+            \returns Pointer to the block, or NULL in the case that no blocks are free */
+        void* alloc( void );
+
+        /** Return a block to the pool
+
+            \param p_block Block previously returned by alloc().  NULL is ignored
+            \returns false in the case that p_block does not belong to the pool or, when 
+                     built with XBEEAPI_CONFIG_DEBUG, is already free.  In either case the 
+                     pool is left unchanged */
+        bool free( void* const p_block );
+
+        /** Determine whether or not a pointer refers to a block within the pool */
+        bool owns( const void* const p_ptr ) const;
+
+        /** Retrieve the size of each block, in bytes */
+        size_t getBlockSize( void ) const;
+
+        /** Retrieve the total number of blocks in the pool */
+        size_t getBlockCount( void ) const;
+
+        /** Retrieve the number of blocks currently free */
+        size_t getFreeCount( void ) const;
+
+        /** Retrieve the lowest number of blocks which have been free at any one time.  Useful
+            for tuning the size of the pool */
+        size_t getFreeLowWater( void ) const;
+};
+
+#endif
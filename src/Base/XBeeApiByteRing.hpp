@@ -0,0 +1,251 @@
+/**
+   @file
+   @brief Circular byte buffer used to hold data received from the XBee
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIBYTERING_HPP
+#define      XBEEAPIBYTERING_HPP
+
+#include "XBeeApiFrameView.hpp"
+#include "XBeeApiAtomic.hpp"
+
+#include <stdint.h>
+#include <stddef.h> // for size_t
+#include <string.h> // for memcpy
+
+/** Fixed size circular buffer of bytes.
+
+    In addition to the usual read/write/peek operations, the buffer is able to
+    provide an XBeeApiFrameView of the data it contains, allowing that data to
+    be examined in place rather than being copied out of the buffer.
+
+    Data may also be added to the buffer provisionally using append().  Such
+    data is not visible to readers of the buffer until commit() is called and
+    may be thrown away using discard().  This allows a frame to be built up in
+    the buffer as it's received and only made available once it's known to be
+    complete and valid.
+
+    Data may be added from one context (the writer, e.g. the serial RX interrupt) while it
+    is read & removed from another (the reader).  The two contexts only share a count of
+    the bytes each has passed through the buffer (see XBeeApiAtomicIndex), so no locking 
+    is needed.
+
+    \tparam T Size of the buffer in bytes */
+template < size_t T >
+class XBeeApiByteRing
+{
+    protected:
+        /** Storage for the buffer content */
+        uint8_t m_buffer[ T ];
+
+        /** Index within m_buffer of the oldest byte.  Only used by the reader */
+        size_t  m_start;
+
+        /** Index within m_buffer following the newest committed byte.  Only used by the
+            writer */
+        size_t  m_end;
+
+        /** Number of bytes which have been appended but not yet committed.  These
+            follow on from the committed bytes.  Only used by the writer */
+        size_t  m_pending;
+
+        /** Total number of bytes committed, modulo the range of size_t.  Written by the
+            writer */
+        XBeeApiAtomicIndex m_committed;
+
+        /** Total number of bytes removed, modulo the range of size_t.  Written by the
+            reader */
+        XBeeApiAtomicIndex m_removed;
+
+    public:
+        /** Constructor */
+        XBeeApiByteRing( void ) : m_start( 0 ), m_end( 0 ), m_pending( 0 )
+        {
+        }
+
+        /** Number of (committed) bytes currently held in the buffer */
+        size_t getSize( void ) const
+        {
+            return m_committed.load() - m_removed.load();
+        }
+
+        /** Total number of bytes which the buffer is able to hold */
+        size_t getCapacity( void ) const
+        {
+            return T;
+        }
+
+        /** Number of bytes which can be written before the buffer is full.  Only to be
+            called by the writer */
+        size_t getFree( void ) const
+        {
+            return T - ( m_committed.loadOwn() - m_removed.load() ) - m_pending;
+        }
+
+        /** Retrieve a byte from the buffer without removing it
+
+            \param p_posn Offset of the byte relative to the oldest byte in the buffer.
+                          Must be less than getSize().  Only to be called by the reader */
+        uint8_t operator[]( const size_t p_posn ) const
+        {
+            return m_buffer[ ( m_start + p_posn ) % T ];
+        }
+
+        /** Provisionally add data to the buffer.  The data will not be visible to readers 
+            until commit() is called.
+
+            \param p_src Data to be added
+            \param p_len Length of the data pointed to by p_src
+            \returns true in the case that the data was added, false in the case that there
+                     was insufficient space (in which case none of the data is added) */
+        bool append( const uint8_t* const p_src, const size_t p_len )
+        {
+            bool ret_val = false;
+
+            if( p_len <= getFree() )
+            {
+                const size_t end = ( m_end + m_pending ) % T;
+                size_t first = T - end;
+
+                /* Copy in up to two chunks - up to the end of the storage and then
+                   from the start */
+                if( first > p_len )
+                {
+                    first = p_len;
+                }
+                memcpy( &( m_buffer[ end ] ), p_src, first );
+                memcpy( m_buffer, &( p_src[ first ] ), p_len - first );
+
+                m_pending += p_len;
+                ret_val = true;
+            }
+
+            return ret_val;
+        }
+
+        /** Make any data previously added via append() visible to readers of the buffer */
+        void commit( void )
+        {
+            m_end = ( m_end + m_pending ) % T;
+            m_committed.store( m_committed.loadOwn() + m_pending );
+            m_pending = 0;
+        }
+
+        /** Throw away any data added via append() which has not been committed */
+        void discard( void )
+        {
+            m_pending = 0;
+        }
+
+        /** Add data to the buffer.  Any data which will not fit is discarded.  Note that any
+            uncommitted data previously added via append() is committed along with this data.
+
+            \param p_src Data to be added
+            \param p_len Length of the data pointed to by p_src
+            \returns The number of bytes actually added */
+        size_t write( const uint8_t* const p_src, size_t p_len )
+        {
+            if( p_len > getFree() )
+            {
+                p_len = getFree();
+            }
+
+            append( p_src, p_len );
+            commit();
+
+            return p_len;
+        }
+
+        /** Copy data out of the buffer without removing it
+
+            \param p_dest Buffer to receive the data
+            \param p_len Maximum number of bytes to be copied
+            \returns The number of bytes actually copied */
+        size_t peek( uint8_t* const p_dest, const size_t p_len ) const
+        {
+            XBeeApiFrameView view;
+            getView( getSize(), &view );
+            return view.copy( 0, p_dest, p_len );
+        }
+
+        /** Copy data out of the buffer and remove it
+
+            \param p_dest Buffer to receive the data
+            \param p_len Maximum number of bytes to be read
+            \returns The number of bytes actually read */
+        size_t read( uint8_t* const p_dest, const size_t p_len )
+        {
+            return chomp( peek( p_dest, p_len ) );
+        }
+
+        /** Discard data from the buffer
+
+            \param p_len Number of bytes to discard (oldest first)
+            \returns The number of bytes actually discarded */
+        size_t chomp( size_t p_len )
+        {
+            const size_t used = getSize();
+
+            if( p_len > used )
+            {
+                p_len = used;
+            }
+            m_start = ( m_start + p_len ) % T;
+
+            /* Hand the space back to the writer only once the data has been finished with */
+            m_removed.store( m_removed.loadOwn() + p_len );
+
+            return p_len;
+        }
+
+        /** Create a view of the data held in the buffer.  The view remains valid until
+            the data it references is removed from the buffer.
+
+            \param p_len Number of bytes (oldest first) to be included in the view
+            \param p_view View to be populated
+            \returns true in the case that the buffer held at least p_len bytes,
+                     false otherwise */
+        bool getView( const size_t p_len, XBeeApiFrameView* const p_view ) const
+        {
+            bool ret_val = false;
+
+            if( p_len <= getSize() )
+            {
+                const size_t first = T - m_start;
+
+                if( p_len <= first )
+                {
+                    *p_view = XBeeApiFrameView( &( m_buffer[ m_start ] ), p_len );
+                }
+                else
+                {
+                    *p_view = XBeeApiFrameView( &( m_buffer[ m_start ] ), first,
+                                                m_buffer, p_len - first );
+                }
+                ret_val = true;
+            }
+
+            return ret_val;
+        }
+};
+
+#endif
@@ -0,0 +1,125 @@
+/**
+   @file
+   @brief Class to protect short sections of code against concurrent access
+          from interrupt context
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPICRITICALSECTION_HPP
+#define      XBEEAPICRITICALSECTION_HPP
+
+#include "XBeeApiCfg.hpp"
+
+#if defined XBEEAPI_CONFIG_POSIX
+
+#include <mutex>
+
+/** Lock guarding the state of one object (e.g. an XBeeDevice) which is shared with the
+    context handling received data.  On a POSIX host this is a (recursive) mutex, so that
+    threads servicing different objects don't contend with each other */
+class XBeeApiCriticalSectionLock
+{
+    protected:
+        /** The mutex */
+        std::recursive_mutex m_mutex;
+
+    /** XBeeApiCriticalSection is a friend so that it can lock & unlock m_mutex */
+    friend class XBeeApiCriticalSection;
+};
+
+/** Class which holds an XBeeApiCriticalSectionLock for the duration of its lifetime.  On a 
+    POSIX host there are no interrupts - state shared with the context handling received 
+    data is instead guarded against other threads.  Critical sections may be nested.
+
+    The section of code protected should be kept as short as possible. */
+class XBeeApiCriticalSection
+{
+    protected:
+        /** The lock held */
+        XBeeApiCriticalSectionLock& m_lock;
+
+    public:
+        /** Constructor - enters the critical section
+
+            \param p_lock Lock belonging to the object whose state is being protected */
+        explicit XBeeApiCriticalSection( XBeeApiCriticalSectionLock& p_lock ) : m_lock( p_lock )
+        {
+            m_lock.m_mutex.lock();
+        }
+
+        /** Destructor - leaves the critical section */
+        ~XBeeApiCriticalSection( void )
+        {
+            m_lock.m_mutex.unlock();
+        }
+};
+
+#else
+
+#include "mbed.h" // For interrupt control
+
+/** Lock guarding the state of one object (e.g. an XBeeDevice) which is shared with the
+    context handling received data.  On mbed the critical section disables interrupts, so 
+    there's nothing to hold */
+class XBeeApiCriticalSectionLock
+{
+};
+
+/** Class which disables interrupts for the duration of its lifetime.  Intended to be
+    used as a local object guarding a small amount of state which is shared with code
+    running in interrupt context (e.g. decoder call-backs invoked from the serial RX
+    interrupt).  Critical sections may be nested.
+
+    The section of code protected should be kept as short as possible. */
+class XBeeApiCriticalSection
+{
+    protected:
+        /** Interrupt mask at the time the critical section was entered */
+        uint32_t m_primask;
+
+    public:
+        /** Constructor - enters the critical section */
+        XBeeApiCriticalSection( void ) : m_primask( __get_PRIMASK() )
+        {
+            __disable_irq();
+        }
+
+        /** Constructor - enters the critical section.  Provided for compatibility with
+            POSIX builds, in which each object has its own lock */
+        explicit XBeeApiCriticalSection( XBeeApiCriticalSectionLock& ) : m_primask( __get_PRIMASK() )
+        {
+            __disable_irq();
+        }
+
+        /** Destructor - leaves the critical section.  Interrupts are only re-enabled
+            if they were enabled when the critical section was entered */
+        ~XBeeApiCriticalSection( void )
+        {
+            if( m_primask == 0 )
+            {
+                __enable_irq();
+            }
+        }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,278 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiEscape.hpp"
+#include "XBeeApiCfg.hpp"
+
+#include <string.h>
+
+#if defined __SSE2__ && !defined XBEEAPI_CONFIG_DISABLE_SIMD
+#include <emmintrin.h>
+#define XBEE_ESCAPE_USE_SSE2
+#endif
+
+/** Word type used for processing several bytes at once */
+typedef size_t xbeeWord_t;
+
+/** Buffers shorter than this are processed a byte at a time.  Below this length the set-up
+    of the word-at-a-time & SSE2 loops (and the memmove() of each run when un-escaping) costs
+    more than it saves - see examples/XBeeApiEscapeBenchmark */
+#define XBEE_ESCAPE_MIN_KERNEL_LEN 16U
+
+/** Word with every byte set to 0x01 */
+#define WORD_ONES         ((xbeeWord_t)-1 / 0xFFU)
+/** Word with every byte set to _b */
+#define WORD_REPEAT( _b ) ( WORD_ONES * (uint8_t)( _b ))
+/** Word with every 16-bit lane set to 0x0001 */
+#define WORD_LANE_ONES    ((xbeeWord_t)-1 / 0xFFFFU)
+/** Non-zero in the case that any byte in the word _w is zero */
+#define WORD_HAS_ZERO_BYTE( _w ) ((( _w ) - WORD_ONES ) & ~( _w ) & WORD_REPEAT( 0x80U ))
+
+/** Read a word from a potentially unaligned address */
+static inline xbeeWord_t loadWord( const uint8_t* const p_data )
+{
+    xbeeWord_t ret_val;
+    memcpy( &ret_val, p_data, sizeof( ret_val ));
+    return ret_val;
+}
+
+/** Sum the bytes in a word, modulo 256 */
+static inline uint8_t wordSum( const xbeeWord_t p_word )
+{
+    /* Add adjacent bytes into 16-bit lanes, then use a multiply to sum the lanes into the
+       top lane.  Each lane is at most 510, so there's no risk of carries between lanes */
+    const xbeeWord_t lanes = ( p_word & ( WORD_LANE_ONES * 0xFFU )) +
+                             (( p_word >> 8U ) & ( WORD_LANE_ONES * 0xFFU ));
+    return (uint8_t)(( lanes * WORD_LANE_ONES ) >> (( sizeof( xbeeWord_t ) - 2U ) * 8U ));
+}
+
+/** Determine whether a word contains any bytes which need escaping for transmission */
+static inline bool wordNeedsEscape( const xbeeWord_t p_word )
+{
+    return ( WORD_HAS_ZERO_BYTE( p_word ^ WORD_REPEAT( XBEE_SB_FRAME_DELIMITER )) |
+             WORD_HAS_ZERO_BYTE( p_word ^ WORD_REPEAT( XBEE_SB_ESCAPE )) |
+             /* XON & XOFF differ only in bit 1, so can be checked for together */
+             WORD_HAS_ZERO_BYTE(( p_word | WORD_REPEAT( XBEE_SB_XON ^ XBEE_SB_XOFF )) ^ WORD_REPEAT( XBEE_SB_XOFF ))) != 0;
+}
+
+/** Determine whether a word contains any bytes which are significant when un-escaping received data */
+static inline bool wordNeedsUnescape( const xbeeWord_t p_word )
+{
+    return ( WORD_HAS_ZERO_BYTE( p_word ^ WORD_REPEAT( XBEE_SB_FRAME_DELIMITER )) |
+             WORD_HAS_ZERO_BYTE( p_word ^ WORD_REPEAT( XBEE_SB_ESCAPE ))) != 0;
+}
+
+static inline bool byteNeedsEscape( const uint8_t p_byte )
+{
+    return ( p_byte == XBEE_SB_FRAME_DELIMITER ) ||
+           ( p_byte == XBEE_SB_ESCAPE ) ||
+           ( p_byte == XBEE_SB_XON ) ||
+           ( p_byte == XBEE_SB_XOFF );
+}
+
+static inline bool byteNeedsUnescape( const uint8_t p_byte )
+{
+    return ( p_byte == XBEE_SB_FRAME_DELIMITER ) ||
+           ( p_byte == XBEE_SB_ESCAPE );
+}
+
+/** Determine the length of the run of bytes at the start of p_data which don't need escaping,
+    adding them to the checksum as we go */
+static size_t escapeCleanRun( const uint8_t* const p_data, const size_t p_len, uint8_t* const p_sum )
+{
+    size_t run = 0;
+    uint8_t sum = *p_sum;
+
+    if( p_len >= XBEE_ESCAPE_MIN_KERNEL_LEN )
+    {
+#if defined XBEE_ESCAPE_USE_SSE2
+        const __m128i delim = _mm_set1_epi8( XBEE_SB_FRAME_DELIMITER );
+        const __m128i esc   = _mm_set1_epi8( XBEE_SB_ESCAPE );
+        const __m128i xoff  = _mm_set1_epi8( XBEE_SB_XOFF );
+        const __m128i xmask = _mm_set1_epi8( XBEE_SB_XON ^ XBEE_SB_XOFF );
+
+        while(( p_len - run ) >= sizeof( __m128i ))
+        {
+            const __m128i v = _mm_loadu_si128( (const __m128i*)&( p_data[ run ] ));
+            const __m128i special = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, delim ),
+                                                                _mm_cmpeq_epi8( v, esc )),
+                                                  _mm_cmpeq_epi8( _mm_or_si128( v, xmask ), xoff ));
+            if( _mm_movemask_epi8( special ))
+            {
+                break;
+            }
+            /* Sum of absolute differences against zero gives the sum of each 8-byte half */
+            const __m128i sad = _mm_sad_epu8( v, _mm_setzero_si128() );
+            sum += (uint8_t)( _mm_cvtsi128_si32( sad ) + _mm_extract_epi16( sad, 4 ));
+            run += sizeof( __m128i );
+        }
+#endif
+
+        while((( p_len - run ) >= sizeof( xbeeWord_t )) &&
+              ( !wordNeedsEscape( loadWord( &( p_data[ run ] )))))
+        {
+            sum += wordSum( loadWord( &( p_data[ run ] )));
+            run += sizeof( xbeeWord_t );
+        }
+    }
+
+    /* Deal with the word containing the special byte (or the trailing bytes) one at a time */
+    while(( run < p_len ) &&
+          ( !byteNeedsEscape( p_data[ run ] )))
+    {
+        sum += p_data[ run ];
+        run++;
+    }
+
+    *p_sum = sum;
+    return run;
+}
+
+/** Determine the length of the run of bytes at the start of p_data which don't need un-escaping */
+static size_t unescapeCleanRun( const uint8_t* const p_data, const size_t p_len )
+{
+    size_t run = 0;
+
+    if( p_len >= XBEE_ESCAPE_MIN_KERNEL_LEN )
+    {
+#if defined XBEE_ESCAPE_USE_SSE2
+        const __m128i delim = _mm_set1_epi8( XBEE_SB_FRAME_DELIMITER );
+        const __m128i esc   = _mm_set1_epi8( XBEE_SB_ESCAPE );
+
+        while(( p_len - run ) >= sizeof( __m128i ))
+        {
+            const __m128i v = _mm_loadu_si128( (const __m128i*)&( p_data[ run ] ));
+            if( _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( v, delim ),
+                                                 _mm_cmpeq_epi8( v, esc ))))
+            {
+                break;
+            }
+            run += sizeof( __m128i );
+        }
+#endif
+
+        while((( p_len - run ) >= sizeof( xbeeWord_t )) &&
+              ( !wordNeedsUnescape( loadWord( &( p_data[ run ] )))))
+        {
+            run += sizeof( xbeeWord_t );
+        }
+    }
+
+    while(( run < p_len ) &&
+          ( !byteNeedsUnescape( p_data[ run ] )))
+    {
+        run++;
+    }
+
+    return run;
+}
+
+size_t xbeeApiEscapeRun( const uint8_t* p_data, size_t p_len, uint8_t* const p_sum )
+{
+    return escapeCleanRun( p_data, p_len, p_sum );
+}
+
+uint8_t xbeeApiChecksum( const uint8_t* p_data, size_t p_len, uint8_t p_sum )
+{
+#if defined XBEE_ESCAPE_USE_SSE2
+    while( p_len >= sizeof( __m128i ))
+    {
+        const __m128i sad = _mm_sad_epu8( _mm_loadu_si128( (const __m128i*)p_data ), _mm_setzero_si128() );
+        p_sum += (uint8_t)( _mm_cvtsi128_si32( sad ) + _mm_extract_epi16( sad, 4 ));
+        p_data += sizeof( __m128i );
+        p_len -= sizeof( __m128i );
+    }
+#endif
+
+    while( p_len >= sizeof( xbeeWord_t ))
+    {
+        p_sum += wordSum( loadWord( p_data ));
+        p_data += sizeof( xbeeWord_t );
+        p_len -= sizeof( xbeeWord_t );
+    }
+
+    while( p_len-- )
+    {
+        p_sum += *(p_data++);
+    }
+
+    return p_sum;
+}
+
+size_t xbeeApiUnescape( const uint8_t* p_src, size_t p_len, uint8_t* p_dest, size_t* const p_destLen, bool* const p_esc )
+{
+    size_t consumed = 0;
+    size_t written = 0;
+
+    while( consumed < p_len )
+    {
+        if( *p_esc )
+        {
+            /* A delimiter can't be escaped - it indicates that the frame was cut short */
+            if( p_src[ consumed ] == XBEE_SB_FRAME_DELIMITER )
+            {
+                break;
+            }
+            p_dest[ written++ ] = p_src[ consumed++ ] ^ XBEE_SB_ESCAPE_XOR;
+            *p_esc = false;
+        }
+        else if(( p_len - consumed ) < XBEE_ESCAPE_MIN_KERNEL_LEN )
+        {
+            /* Too short to be worth looking for a run - copy a byte at a time */
+            if( p_src[ consumed ] == XBEE_SB_FRAME_DELIMITER )
+            {
+                break;
+            }
+            else if( p_src[ consumed ] == XBEE_SB_ESCAPE )
+            {
+                *p_esc = true;
+                consumed++;
+            }
+            else
+            {
+                p_dest[ written++ ] = p_src[ consumed++ ];
+            }
+        }
+        else
+        {
+            const size_t run = unescapeCleanRun( &( p_src[ consumed ] ), p_len - consumed );
+
+            /* May be operating in-place, in which case the source and destination overlap */
+            if( &( p_dest[ written ] ) != &( p_src[ consumed ] ))
+            {
+                memmove( &( p_dest[ written ] ), &( p_src[ consumed ] ), run );
+            }
+            written += run;
+            consumed += run;
+
+            if( consumed < p_len )
+            {
+                if( p_src[ consumed ] == XBEE_SB_FRAME_DELIMITER )
+                {
+                    break;
+                }
+                /* Must be an escape - the next byte needs un-escaping */
+                *p_esc = true;
+                consumed++;
+            }
+        }
+    }
+
+    *p_destLen = written;
+    return consumed;
+}
@@ -0,0 +1,93 @@
+/**
+   @file
+   @brief Functions to escape, un-escape and checksum data exchanged with the XBee
+          in API mode 2
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIESCAPE_HPP
+#define      XBEEAPIESCAPE_HPP
+
+#include <stdint.h>
+#include <stddef.h> // for size_t
+
+/** Enum of bytes with a special meaning when communicating with the XBee in API
+    mode.  In escaped mode, these are the bytes that need to be escaped */
+typedef enum
+{
+    XBEE_SB_XON             = 0x11,
+    XBEE_SB_XOFF            = 0x13,
+    XBEE_SB_FRAME_DELIMITER = 0x7E,
+    XBEE_SB_ESCAPE          = 0x7D
+} XBeeSerialSpecialBytes_e;
+
+/** Value which is XOR'd with a special byte in order to escape it */
+#define XBEE_SB_ESCAPE_XOR 0x20U
+
+/* The functions below examine the data a machine word (or, where SSE2 is available, 16 bytes)
+   at a time, looking for special bytes.  Runs of data which don't contain any special bytes are
+   copied with memcpy().  Byte-at-a-time processing is only used for the special bytes themselves,
+   for any data at the end of the buffer which doesn't fill a word and for buffers of less than
+   16 bytes, where looking for runs costs more than it saves.  The same code serves both MCU and
+   host builds.
+
+   Below 16 bytes (and 8 bytes in the case of xbeeApiChecksum()) these functions are slower than
+   an inlined byte-at-a-time loop, by up to 3 times for a single byte, as the cost of the call
+   itself dominates.  XBeeDevice makes only a handful of such short calls per frame (for the
+   header & checksum), so the cost is a few tens of nanoseconds per frame on a host - see
+   examples/XBeeApiEscapeBenchmark. */
+
+/** Calculate the 8-bit sum of a buffer of data
+
+    \param p_data Data to be summed
+    \param p_len Length of the data pointed to by p_data
+    \param p_sum Initial value of the sum
+    \returns p_sum plus the sum of the bytes in p_data, modulo 256 */
+extern uint8_t xbeeApiChecksum( const uint8_t* p_data, size_t p_len, uint8_t p_sum );
+
+/** Determine the length of the run of bytes at the start of a buffer of data which don't
+    need escaping, summing them in the same pass.  Allows data which doesn't need escaping
+    to be transmitted from where it is rather than being copied into an escaped buffer
+
+    \param p_data Data to be examined
+    \param p_len Length of the data pointed to by p_data
+    \param p_sum Running checksum, to which the bytes in the run are added
+    \returns The number of bytes at the start of p_data which don't need escaping.  In the 
+             case that this is less than p_len, p_data[ return value ] needs escaping */
+extern size_t xbeeApiEscapeRun( const uint8_t* p_data, size_t p_len, uint8_t* const p_sum );
+
+/** Un-escape a buffer of data received from the XBee.  Processing stops at an (un-escaped)
+    frame delimiter, which always indicates the start of a new frame.
+
+    \param p_src Data to be un-escaped
+    \param p_len Length of the data pointed to by p_src
+    \param p_dest Buffer to receive the un-escaped data.  Must be at least p_len bytes long.
+                  May be the same as p_src (i.e. in-place un-escaping is supported)
+    \param p_destLen Receives the number of bytes written to p_dest
+    \param p_esc Escape state, carried between calls.  Set in the case that the last byte
+                 processed was an escape character, meaning that the next byte needs to be
+                 un-escaped
+    \returns The number of bytes of p_src which were processed.  This will be less than
+             p_len in the case that a frame delimiter was encountered, in which case
+             p_src[ return value ] is the delimiter */
+extern size_t xbeeApiUnescape( const uint8_t* p_src, size_t p_len, uint8_t* p_dest, size_t* const p_destLen, bool* const p_esc );
+
+#endif
@@ -0,0 +1,154 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiEvent.hpp"
+
+#if !defined XBEEAPI_CONFIG_USING_STD_THREAD && !defined XBEEAPI_CONFIG_USING_RTOS
+/** Interval at which XBeeApiEvent::wait() checks for the event having been signalled when
+    there's no OS support to block on */
+#define XBEE_EVENT_POLL_US (100U)
+#endif
+
+void xbeeApiWaitMs( const uint32_t p_ms )
+{
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+    std::this_thread::sleep_for( std::chrono::milliseconds( p_ms ));
+#else
+    wait_ms( p_ms );
+#endif
+}
+
+XBeeApiTimeout::XBeeApiTimeout( const uint32_t p_timeout_ms ) : m_timeout( p_timeout_ms )
+{
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+    m_start = std::chrono::steady_clock::now();
+#else
+    m_timer.start();
+#endif
+}
+
+uint32_t XBeeApiTimeout::getElapsed( void )
+{
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - m_start ).count();
+#else
+    return (uint32_t)m_timer.read_ms();
+#endif
+}
+
+uint32_t XBeeApiTimeout::getRemaining( void )
+{
+    uint32_t ret_val = 0;
+    const uint32_t elapsed = getElapsed();
+
+    if( elapsed < m_timeout )
+    {
+        ret_val = m_timeout - elapsed;
+    }
+
+    return ret_val;
+}
+
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+
+XBeeApiEvent::XBeeApiEvent( void ) : m_signalled( false )
+{
+}
+
+void XBeeApiEvent::signal( void )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_signalled = true;
+    }
+    m_cond.notify_all();
+}
+
+void XBeeApiEvent::clear( void )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_signalled = false;
+}
+
+bool XBeeApiEvent::wait( const uint32_t p_timeout_ms )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    const bool ret_val = m_cond.wait_for( lock, std::chrono::milliseconds( p_timeout_ms ), 
+                                          [this]{ return m_signalled; } );
+    m_signalled = false;
+    return ret_val;
+}
+
+#elif defined XBEEAPI_CONFIG_USING_RTOS
+
+XBeeApiEvent::XBeeApiEvent( void ) : m_sem( 0 )
+{
+}
+
+void XBeeApiEvent::signal( void )
+{
+    m_sem.release();
+}
+
+void XBeeApiEvent::clear( void )
+{
+    /* Consume any outstanding tokens */
+    while( m_sem.wait( 0 ) > 0 )
+    {
+    }
+}
+
+bool XBeeApiEvent::wait( const uint32_t p_timeout_ms )
+{
+    return( m_sem.wait( p_timeout_ms ) > 0 );
+}
+
+#else
+
+XBeeApiEvent::XBeeApiEvent( void ) : m_signalled( false )
+{
+}
+
+void XBeeApiEvent::signal( void )
+{
+    m_signalled = true;
+}
+
+void XBeeApiEvent::clear( void )
+{
+    m_signalled = false;
+}
+
+bool XBeeApiEvent::wait( const uint32_t p_timeout_ms )
+{
+    XBeeApiTimeout timeout( p_timeout_ms );
+
+    /* No OS to block on, so poll the flag (set from the RX interrupt) at a much finer 
+       granularity than the timeout */
+    while(( !m_signalled ) &&
+          ( timeout.getRemaining() > 0 ))
+    {
+        wait_us( XBEE_EVENT_POLL_US );
+    }
+
+    const bool ret_val = m_signalled;
+    m_signalled = false;
+    return ret_val;
+}
+
+#endif
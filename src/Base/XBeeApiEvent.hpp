@@ -0,0 +1,132 @@
+/**
+   @file
+   @brief Classes used to wait for events signalled by the XBee
+          receive path
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIEVENT_HPP
+#define      XBEEAPIEVENT_HPP
+
+#include "XBeeApiCfg.hpp"
+
+#include <stdint.h>
+
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#else
+#include "mbed.h" // For Timer & wait_us()
+#if defined  XBEEAPI_CONFIG_USING_RTOS
+#include "rtos.h" // Semaphore support
+#endif
+#endif
+
+#if defined XBEEAPI_CONFIG_POSIX && !defined XBEEAPI_CONFIG_USING_STD_THREAD
+#error "XBEEAPI_CONFIG_POSIX requires XBEEAPI_CONFIG_USING_STD_THREAD"
+#endif
+
+/** Block the calling thread for a period of time
+
+    \param p_ms Time to wait, in milliseconds */
+void xbeeApiWaitMs( const uint32_t p_ms );
+
+/** Class to keep track of the time remaining before a timeout expires.
+    The timeout starts running when the object is constructed */
+class XBeeApiTimeout
+{
+    protected:
+        /** Length of the timeout in milliseconds */
+        uint32_t m_timeout;
+
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+        /** Time at which the timeout started running */
+        std::chrono::steady_clock::time_point m_start;
+#else
+        /** Timer measuring the time since the timeout started running */
+        Timer m_timer;
+#endif
+
+    public:
+        /** Constructor
+
+            \param p_timeout_ms Length of the timeout in milliseconds */
+        XBeeApiTimeout( const uint32_t p_timeout_ms );
+
+        /** Determine the time remaining before the timeout expires
+
+            \returns Remaining time in milliseconds, 0 in the case that the timeout has expired */
+        uint32_t getRemaining( void );
+
+        /** Determine the time since the timeout started running
+
+            \returns Elapsed time in milliseconds */
+        uint32_t getElapsed( void );
+};
+
+/** Class to allow a thread to wait for something to happen in another context (e.g. for
+    a response to be received from the XBee).  The event is auto-resetting - each call to
+    wait() consumes any signal given by signal().
+
+    The implementation depends upon the configuration:
+      - XBEEAPI_CONFIG_USING_STD_THREAD: std::condition_variable
+      - XBEEAPI_CONFIG_USING_RTOS: rtos::Semaphore
+      - Otherwise: a flag set from interrupt context, which wait() polls */
+class XBeeApiEvent
+{
+    protected:
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+        /** Mutex protecting m_signalled */
+        std::mutex              m_mutex;
+        /** Condition variable notified by signal() */
+        std::condition_variable m_cond;
+        /** Set by signal(), cleared by wait() */
+        bool                    m_signalled;
+#elif defined XBEEAPI_CONFIG_USING_RTOS
+        /** Semaphore released by signal() */
+        rtos::Semaphore         m_sem;
+#else
+        /** Set by signal(), cleared by wait() */
+        volatile bool           m_signalled;
+#endif
+
+    public:
+        /** Constructor */
+        XBeeApiEvent( void );
+
+        /** Signal the event, waking any thread blocked in wait().  May be called from
+            interrupt context */
+        void signal( void );
+
+        /** Discard any signal which has not yet been consumed by wait() */
+        void clear( void );
+
+        /** Wait for the event to be signalled
+
+            \param p_timeout_ms Maximum time to wait, in milliseconds
+            \returns true in the case that the event was signalled, false in the case that
+                     the timeout expired */
+        bool wait( const uint32_t p_timeout_ms );
+};
+
+#endif
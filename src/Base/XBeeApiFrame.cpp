@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "XBeeApiFrame.hpp"
 #include "XBeeDevice.hpp"
+#include "XBeeApiSharedFrame.hpp"
 
 #include <stdlib.h>
 
@@ -40,14 +41,62 @@ XBeeApiIdentifier_e XBeeApiFrame::getApiId( void ) const
 {
     return m_apiId;
 }
+
+bool XBeeApiFrame::prepareForTx( XBeeDevice* const )
+{
+    return true;
+}
+
+void XBeeApiFrame::frameTxDropped( void )
+{
+}
         
+size_t XBeeApiFrame::getSegments( XBeeApiFrameSegment_t* const p_segs ) const
+{
+    p_segs[ 0 ].m_data = m_data;
+    p_segs[ 0 ].m_len = m_dataLen;
+    return 1U;
+}
+
 void XBeeApiFrame::getDataPtr( const uint16_t p_start, const uint8_t**  p_buff, uint16_t* const p_len ) const
 {
-    *p_len = m_dataLen;
-    (*p_buff) = m_data;
+    XBeeApiFrameSegment_t segs[ XBEE_API_FRAME_MAX_SEGMENTS ];
+    const size_t segCount = getSegments( segs );
+    uint16_t start = p_start;
+
+    *p_buff = NULL;
+    *p_len = 0;
+
+    for( size_t i = 0; i < segCount; i++ )
+    {
+        if( start < segs[ i ].m_len )
+        {
+            *p_buff = &( segs[ i ].m_data[ start ] );
+            *p_len = segs[ i ].m_len - start;
+            break;
+        }
+        start -= segs[ i ].m_len;
+    }
 }
 
-XBeeApiFrameDecoder::XBeeApiFrameDecoder( XBeeDevice* const p_device ) : m_device( NULL )
+XBeeApiFrameDecoder::XBeeApiFrameDecoder( XBeeDevice* const p_device, const bool p_fanOut ) : m_device( NULL ),
+                                                                                              m_apiIds( NULL ),
+                                                                                              m_apiIdCount( 0 ),
+                                                                                              m_fanOut( p_fanOut )
+{
+    if( p_device != NULL )
+    {
+        p_device->registerDecoder( this );
+    } 
+}
+
+XBeeApiFrameDecoder::XBeeApiFrameDecoder( XBeeDevice* const p_device,
+                                          const XBeeApiIdentifier_e* const p_apiIds,
+                                          const size_t p_apiIdCount,
+                                          const bool p_fanOut ) : m_device( NULL ),
+                                                                  m_apiIds( p_apiIds ),
+                                                                  m_apiIdCount( p_apiIdCount ),
+                                                                  m_fanOut( p_fanOut )
 {
     if( p_device != NULL )
     {
@@ -63,6 +112,12 @@ XBeeApiFrameDecoder::~XBeeApiFrameDecoder()
     }    
 }
 
+size_t XBeeApiFrameDecoder::getApiIds( const XBeeApiIdentifier_e** const p_ids ) const
+{
+    *p_ids = m_apiIds;
+    return m_apiIdCount;
+}
+
 void XBeeApiFrameDecoder::registerCallback( XBeeDevice* const p_device )
 {
     m_device = p_device;
@@ -72,3 +127,8 @@ void XBeeApiFrameDecoder::unregisterCallback( void )
 {
     m_device = NULL;
 }
+
+void XBeeApiFrameDecoder::sharedFrameCallback( XBeeApiSharedFrame* const p_frame )
+{
+    decodeCallback( p_frame->getView() );
+}
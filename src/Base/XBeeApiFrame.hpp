@@ -25,6 +25,8 @@ limitations under the License.
 #if !defined XBEEAPICMD_HPP
 #define      XBEEAPICMD_HPP
 
+#include "XBeeApiFrameView.hpp"
+
 #include <stdint.h>
 #include <stddef.h> // for size_t
 
@@ -45,6 +47,9 @@ typedef enum
     XBEE_CMD_INVALID            = 0xFFF   
 } XBeeApiIdentifier_e; 
 
+/** Number of distinct values which the API identifier byte can take */
+#define XBEE_API_ID_COUNT 256U
+
 /** Position of fixed meaning bytes within the API frame, relative to the start of the frame */
 enum
 {
@@ -57,9 +62,18 @@ enum
     /** API identifier for the data which follows - see XBeeApiIdentifier_e */
     XBEE_CMD_POSN_API_ID = 0x03,
     /** Start of API identifier specific data */
-    XBEE_CMD_POSN_ID_SPECIFIC_DATA = 0x04
+    XBEE_CMD_POSN_ID_SPECIFIC_DATA = 0x04,
+    /** Frame identifier, for those types of frame which have one (it's always the first
+        byte of the API identifier specific data) */
+    XBEE_CMD_POSN_FRAME_ID = 0x04
 };
 
+/** Number of distinct values which a frame identifier can take */
+#define XBEE_FRAME_ID_COUNT 256U
+
+/** Frame identifier value which indicates that no response is required from the XBee */
+#define XBEE_FRAME_ID_NONE 0U
+
 /** Helper macro to retrieve the frame payload length (i.e. excluding overhead - see XBEE_API_FRAME_OVERHEAD) from a buffer.
 
     \param _b Pointer to a buffer containing a received API frame.
@@ -69,8 +83,22 @@ enum
 /** The number of 'overhead' bytes in an API frame (i.e. those not included in the frame payload, namely the start delimiter, 2 length bytes & checksum */
 #define XBEE_API_FRAME_OVERHEAD 4U
 
+/** Maximum number of segments which XBeeApiFrame::getSegments() may return */
+#define XBEE_API_FRAME_MAX_SEGMENTS 3U
+
+/** A contiguous piece of data, e.g. part of the API-specific data of a frame - see 
+    XBeeApiFrame::getSegments() */
+typedef struct
+{
+    /** Start of the data */
+    const uint8_t* m_data;
+    /** Length of the data pointed to by m_data */
+    uint16_t       m_len;
+} XBeeApiFrameSegment_t;
+
 /* Forward declare this as XBeeDevice is dependent upon XBeeApiFrameDecoder */
 class XBeeDevice;
+class XBeeApiSharedFrame;
 
 /** Class which represents an API frame, exchanged with the XBee.
     This class in itself will not create a valid API frame and needs to be sub-classed.
@@ -105,27 +133,52 @@ class XBeeApiFrame
     
         /** Retrieve the API identifier for this frame */
         XBeeApiIdentifier_e getApiId( void ) const;
+
+        /** Called by XBeeDevice immediately before the frame is transmitted, giving the frame the
+            opportunity to perform any last-minute preparation (e.g. allocating a frame identifier).
+            The default implementation does nothing.
+
+            \param p_device The device via which the frame is being transmitted
+            \returns true in the case that the frame is ready to be transmitted, false in the case
+                     that it should not be transmitted */
+        virtual bool prepareForTx( XBeeDevice* const p_device );
+
+        /** Called by XBeeDevice in the case that the frame is removed from the TX queue 
+            without being transmitted because it can never be sent (see 
+            XBeeDevice::pumpTxQueue()).  Not called for frames removed via 
+            XBeeDevice::cancelFrame().  The default implementation does nothing. */
+        virtual void frameTxDropped( void );
         
-        /** Retrieve a pointer to the API-specific data (i.e. that which follows the API identifier in 
-            the frame).  In *total*, getDataPtr will return sufficient data to match getCmdLen(), however
-            it may be done in chunks using p_start and *p_len to control the fragmentation process.  
-            For example:
-            
-                getCmdLen() == 5;
-                getDataPtr( 0, &b, &l );
-                l == 2; b[0] == 'a'; b[1] == 'b'; 
-                getDataPtr( 2, &b, &l );
-                l == 1; b[2] == 'c';
-                getDataPtr( 3, &b, &l );
-                l == 2; b[0] == 'd'; b[1] == 'e';
-            
-            \param[in]  p_start The start point within the buffer.  It is only meaningful to use a non-zero
-                                value in the case that a previous call to getDataPtr did not return a buffer
-                                of length getCmdLen(), in which case p_start should be set to be the next
-                                byte that is required.
-            \param[out] p_buff  Pointer to a pointer to receive the buffer pointer 
+        /** Describe the API-specific data (i.e. that which follows the API identifier in the 
+            frame) as a list of segments, e.g. a header held by the frame object followed by a 
+            payload supplied by the user.  XBeeDevice checksums, escapes & transmits the 
+            segments in order without first copying them into a single buffer.  The total 
+            length of the segments must be one less than getCmdLen().  The default 
+            implementation returns a single segment describing m_data.
+
+            Sub-classes which need to prepare data for transmission (e.g. a header containing
+            a frame identifier) should do so in prepareForTx(), as this method may be called
+            more than once for each transmission.
+
+            \param[out] p_segs Array of XBEE_API_FRAME_MAX_SEGMENTS entries to receive the 
+                               segments.  Segments may be of zero length
+            \returns The number of entries of p_segs which were filled in */
+        virtual size_t getSegments( XBeeApiFrameSegment_t* const p_segs ) const;
+
+        /** Retrieve a pointer to part of the API-specific data.  The data described by 
+            getSegments() isn't necessarily contiguous, so this provides the data from p_start
+            to the end of the segment containing it.  For example, with a 3-byte header 
+            segment followed by a 5-byte payload:
+
+                getDataPtr( 0, &b, &l );   // b points to the header, l == 3
+                getDataPtr( 3, &b, &l );   // b points to the payload, l == 5
+                getDataPtr( 4, &b, &l );   // b points to the 2nd byte of the payload, l == 4
+
+            \param[in]  p_start Offset of the first byte required within the API-specific data
+            \param[out] p_buff  Pointer to a pointer to receive the buffer pointer.  NULL in the
+                                case that p_start is beyond the end of the data
             \param[out] p_len   Pointer to receive the length of the data pointed to by *p_buff */
-        virtual void getDataPtr( const uint16_t p_start, const uint8_t**  p_buff, uint16_t* const p_len ) const;
+        void getDataPtr( const uint16_t p_start, const uint8_t**  p_buff, uint16_t* const p_len ) const;
 };
 
 /** Class which acts as a receiver for data from the XBee and takes care of decoding it.
@@ -142,11 +195,43 @@ class XBeeApiFrameDecoder
             so that we know where to go at time of destruction and the XBeeDevice isn't
             left with a pointer to an invalidated object */
         XBeeDevice* m_device;
+
+        /** API identifiers of the frames the decoder is interested in - see XBeeApiFrameDecoder() */
+        const XBeeApiIdentifier_e* m_apiIds;
+
+        /** Number of entries in m_apiIds.  0 indicates that the decoder is interested in all frames */
+        size_t m_apiIdCount;
+
+        /** Indicate whether or not the decoder is offered frames via fan-out - see
+            sharedFrameCallback() */
+        bool m_fanOut;
         
     public:
         
-        /** Constructor */
-        XBeeApiFrameDecoder( XBeeDevice* const p_device = NULL );
+        /** Constructor - creates a decoder which is offered all received frames
+
+            \param p_device Device with which to register the decoder, or NULL
+            \param p_fanOut true in the case that the decoder should be offered every frame
+                            it's interested in via sharedFrameCallback(), regardless of
+                            whether or not other decoders also decode it.  Used for decoders
+                            which monitor traffic (loggers, etc) alongside those which
+                            consume it */
+        XBeeApiFrameDecoder( XBeeDevice* const p_device = NULL, const bool p_fanOut = false );
+
+        /** Constructor - creates a decoder which is only offered frames with particular API
+            identifiers.  The identifiers are passed in rather than being retrieved via a virtual
+            function as the decoder is registered with p_device before the constructor of any
+            inheriting class has run
+
+            \param p_device Device with which to register the decoder, or NULL
+            \param p_apiIds API identifiers of the frames the decoder is interested in.  The array
+                            must remain valid for the life of the decoder
+            \param p_apiIdCount Number of entries in p_apiIds
+            \param p_fanOut See XBeeApiFrameDecoder( XBeeDevice* const, const bool ) */
+        XBeeApiFrameDecoder( XBeeDevice* const p_device,
+                             const XBeeApiIdentifier_e* const p_apiIds,
+                             const size_t p_apiIdCount,
+                             const bool p_fanOut = false );
         
         /** Destructor.  Un-registers the decoder from any XBeeDevice object with which it is registered */
         virtual ~XBeeApiFrameDecoder();
@@ -162,6 +247,14 @@ class XBeeApiFrameDecoder
         /** Called by an XBeeDevice object to let this object know that it's no longer associated with the device */ 
         void unregisterCallback( void );
 
+        /** Called by an XBeeDevice at the time this object is registered in order to determine which types of
+            frame the object is interested in.  The object will only be offered frames with one of the returned API
+            identifiers.  An empty list means that the object is offered all frames.
+
+            \param p_ids Receives a pointer to the array of API identifiers passed to the constructor
+            \returns The number of entries in the array pointed to by *p_ids */
+        size_t getApiIds( const XBeeApiIdentifier_e** const p_ids ) const;
+
         /** Called by an XBeeDevice in order to give this object the opportunity to examine and decode data received
             from the XBee
             
@@ -169,14 +262,27 @@ class XBeeApiFrameDecoder
                   the data was intended for and was decoded by this class.  Returning true in other cases may result in
                   other decoders being denied the opportunity to examine the data
             
-            \param p_data Pointer to the first byte of the data buffer (i.e. XBEE_CMD_POSN_SDELIM).  The implementation
-                          of any over-riding function should not expect that the data referenced by this pointer will
-                          remain valid after the call-back has completed.
-            \param p_len  Size of the data pointed to by p_data
+            \param p_data View of the received frame, starting with the first byte (i.e. XBEE_CMD_POSN_SDELIM).  The
+                          view references the XBeeDevice's receive buffer directly and the data is not guaranteed to
+                          be contiguous - see XBeeApiFrameView.  The implementation of any over-riding function should
+                          not expect that the data referenced by the view will remain valid after the call-back has
+                          completed.
             \returns true in the case that the data was examined and decoded successfully
                      false in the case that the data was not of interest or was not decoded successfully
         */
-        virtual bool decodeCallback( const uint8_t* const p_data, size_t p_len ) = 0;    
+        virtual bool decodeCallback( const XBeeApiFrameView& p_data ) = 0;    
+
+        /** Called by an XBeeDevice in order to offer a received frame to a decoder registered for fan-out (see
+            XBeeApiFrameDecoder()).  Each fan-out decoder interested in the frame is offered the same copy of it,
+            after which the frame is also offered to the other decoders as normal.  The default implementation
+            passes a view of the frame to decodeCallback().
+
+            In the case that no shared frame is available (see XBEEAPI_CONFIG_SHARED_FRAMES) the fan-out decoders
+            are offered the frame via decodeCallback() instead.
+
+            \param p_frame The received frame.  Only valid for the duration of the call unless the implementation
+                           takes a reference via XBeeApiSharedFrame::acquire() */
+        virtual void sharedFrameCallback( XBeeApiSharedFrame* const p_frame );
 };
 
 /** Value which represents the broadcast address */
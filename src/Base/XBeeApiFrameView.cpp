@@ -0,0 +1,96 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiFrameView.hpp"
+
+#include <string.h>
+
+XBeeApiFrameView::XBeeApiFrameView( void ) : m_seg1( NULL ), m_seg1Len( 0 ),
+                                             m_seg2( NULL ), m_seg2Len( 0 )
+{
+}
+
+XBeeApiFrameView::XBeeApiFrameView( const uint8_t* const p_data, const size_t p_len ) : m_seg1( p_data ), m_seg1Len( p_len ),
+                                                                                        m_seg2( NULL ), m_seg2Len( 0 )
+{
+}
+
+XBeeApiFrameView::XBeeApiFrameView( const uint8_t* const p_seg1, const size_t p_seg1Len,
+                                    const uint8_t* const p_seg2, const size_t p_seg2Len ) : m_seg1( p_seg1 ), m_seg1Len( p_seg1Len ),
+                                                                                            m_seg2( p_seg2 ), m_seg2Len( p_seg2Len )
+{
+}
+
+size_t XBeeApiFrameView::copy( const size_t p_start, uint8_t* const p_dest, size_t p_len ) const
+{
+    size_t copied = 0;
+
+    if( p_start < getLen() )
+    {
+        if( p_len > ( getLen() - p_start ))
+        {
+            p_len = getLen() - p_start;
+        }
+
+        /* Portion of the requested data which is in the first segment */
+        if( p_start < m_seg1Len )
+        {
+            copied = m_seg1Len - p_start;
+            if( copied > p_len )
+            {
+                copied = p_len;
+            }
+            memcpy( p_dest, &( m_seg1[ p_start ] ), copied );
+        }
+
+        /* Remainder comes from the second segment */
+        if( copied < p_len )
+        {
+            memcpy( &( p_dest[ copied ] ), &( m_seg2[ p_start + copied - m_seg1Len ] ), p_len - copied );
+            copied = p_len;
+        }
+    }
+
+    return copied;
+}
+
+const uint8_t* XBeeApiFrameView::getPtr( const size_t p_start, const size_t p_len, uint8_t* const p_scratch ) const
+{
+    const uint8_t* ret_val = NULL;
+
+    if(( p_start <= getLen() ) &&
+       ( p_len <= ( getLen() - p_start )))
+    {
+        if(( p_start + p_len ) <= m_seg1Len )
+        {
+            ret_val = &( m_seg1[ p_start ] );
+        }
+        else if( p_start >= m_seg1Len )
+        {
+            ret_val = &( m_seg2[ p_start - m_seg1Len ] );
+        }
+        else if( p_scratch != NULL )
+        {
+            /* Data straddles the two segments - only option is to copy it */
+            copy( p_start, p_scratch, p_len );
+            ret_val = p_scratch;
+        }
+    }
+
+    return ret_val;
+}
@@ -0,0 +1,108 @@
+/**
+   @file
+   @brief Class providing a read-only view of a received API frame
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIFRAMEVIEW_HPP
+#define      XBEEAPIFRAMEVIEW_HPP
+
+#include <stdint.h>
+#include <stddef.h> // for size_t
+
+/** Class which provides read-only access to a frame of data held elsewhere
+    (typically in the XBeeDevice's receive buffer) without copying it.
+
+    As the receive buffer is circular, a frame may straddle the end of the
+    buffer, in which case the view is made up of two segments.  Individual
+    bytes are accessed via operator[] regardless of whether or not the
+    frame is split.  getPtr() can be used to get a contiguous pointer to
+    a portion of the frame, with a copy only being made in the case that
+    the portion is split */
+class XBeeApiFrameView
+{
+    protected:
+        /** Pointer to the first segment of the frame */
+        const uint8_t* m_seg1;
+        /** Length of the data pointed to by m_seg1 */
+        size_t         m_seg1Len;
+        /** Pointer to the second segment of the frame, NULL if the frame is contiguous */
+        const uint8_t* m_seg2;
+        /** Length of the data pointed to by m_seg2 */
+        size_t         m_seg2Len;
+
+    public:
+        /** Constructor - creates an empty view */
+        XBeeApiFrameView( void );
+
+        /** Constructor - creates a view of a contiguous buffer
+
+            \param p_data Pointer to the data.  Must remain valid for as long as the view is used
+            \param p_len Length of the data pointed to by p_data */
+        XBeeApiFrameView( const uint8_t* const p_data, const size_t p_len );
+
+        /** Constructor - creates a view of a buffer split into two segments
+
+            \param p_seg1 Pointer to the first part of the data
+            \param p_seg1Len Length of the data pointed to by p_seg1
+            \param p_seg2 Pointer to the remainder of the data
+            \param p_seg2Len Length of the data pointed to by p_seg2 */
+        XBeeApiFrameView( const uint8_t* const p_seg1, const size_t p_seg1Len,
+                          const uint8_t* const p_seg2, const size_t p_seg2Len );
+
+        /** Total length of the data in the view */
+        size_t getLen( void ) const { return m_seg1Len + m_seg2Len; }
+
+        /** Indicate whether or not the data in the view is held in a single segment */
+        bool isContiguous( void ) const { return m_seg2Len == 0; }
+
+        /** Retrieve a byte from the view
+
+            \param p_posn Offset of the byte within the view
+            \returns The byte, or 0 in the case that p_posn is not less than getLen() */
+        uint8_t operator[]( const size_t p_posn ) const
+        {
+            return ( p_posn < m_seg1Len ) ? m_seg1[ p_posn ] :
+                   ( p_posn < getLen() )  ? m_seg2[ p_posn - m_seg1Len ] : 0U;
+        }
+
+        /** Copy a portion of the view into a buffer
+
+            \param p_start Offset within the view of the first byte to be copied
+            \param p_dest Buffer to receive the data
+            \param p_len Number of bytes to copy
+            \returns The number of bytes actually copied, which may be less than p_len in the case
+                     that the view does not contain sufficient data */
+        size_t copy( const size_t p_start, uint8_t* const p_dest, size_t p_len ) const;
+
+        /** Retrieve a pointer to a contiguous portion of the view.  In the case that the requested
+            portion does not straddle the segment boundary a pointer directly into the viewed data
+            is returned, otherwise the data is copied into p_scratch.
+
+            \param p_start Offset within the view of the first byte required
+            \param p_len Number of bytes required
+            \param p_scratch Buffer of at least p_len bytes to be used in the case that the data is
+                             split.  May be NULL, in which case split data is not retrievable
+            \returns Pointer to the data or NULL in the case that the data could not be retrieved */
+        const uint8_t* getPtr( const size_t p_start, const size_t p_len, uint8_t* const p_scratch ) const;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiSharedFrame.hpp"
+
+#include <new>
+
+/** Storage for the frames in XBeeApiSharedFrame::s_pool */
+static void* shared_pool_storage[ XBEE_API_BLOCK_POOL_STORAGE_WORDS( sizeof( XBeeApiSharedFrame ),
+                                                                     XBEEAPI_CONFIG_SHARED_FRAMES ) ];
+
+XBeeApiBlockPool XBeeApiSharedFrame::s_pool( shared_pool_storage, sizeof( XBeeApiSharedFrame ), XBEEAPI_CONFIG_SHARED_FRAMES );
+
+XBeeApiSharedFrame::XBeeApiSharedFrame( void ) : m_refs( 1U ),
+                                                 m_len( 0 )
+{
+}
+
+XBeeApiSharedFrame::~XBeeApiSharedFrame( void )
+{
+}
+
+XBeeApiSharedFrame* XBeeApiSharedFrame::alloc( const XBeeApiFrameView& p_frame )
+{
+    XBeeApiSharedFrame* ret_val = NULL;
+
+    if( p_frame.getLen() <= XBEEAPI_CONFIG_SHARED_FRAME_SIZE )
+    {
+        void* const block = s_pool.alloc();
+
+        if( block != NULL )
+        {
+            ret_val = new( block ) XBeeApiSharedFrame();
+            ret_val->m_len = (uint16_t)p_frame.copy( 0, ret_val->m_data, p_frame.getLen() );
+        }
+    }
+
+    return ret_val;
+}
+
+void XBeeApiSharedFrame::acquire( void )
+{
+    size_t refs = m_refs.load();
+
+    while( !m_refs.compareExchange( refs, refs + 1U ))
+    {
+    }
+}
+
+void XBeeApiSharedFrame::release( void )
+{
+    size_t refs = m_refs.load();
+
+    while( !m_refs.compareExchange( refs, refs - 1U ))
+    {
+    }
+
+    /* refs holds the count prior to the update, so if it was 1 there are now no
+       references left & nothing else can be looking at the frame */
+    if( refs == 1U )
+    {
+        this->~XBeeApiSharedFrame();
+        s_pool.free( this );
+    }
+}
+
+XBeeApiFrameView XBeeApiSharedFrame::getView( void ) const
+{
+    return XBeeApiFrameView( m_data, m_len );
+}
+
+size_t XBeeApiSharedFrame::getRefCount( void ) const
+{
+    return m_refs.load();
+}
+
+size_t XBeeApiSharedFrame::getFreeCount( void )
+{
+    return s_pool.getFreeCount();
+}
+
+size_t XBeeApiSharedFrame::getFreeLowWater( void )
+{
+    return s_pool.getFreeLowWater();
+}
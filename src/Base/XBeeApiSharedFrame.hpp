@@ -0,0 +1,107 @@
+/**
+   @file
+   @brief Class holding a pooled, reference-counted copy of a received frame
+          which can be shared between several decoders
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPISHAREDFRAME_HPP
+#define      XBEEAPISHAREDFRAME_HPP
+
+#include "XBeeApiCfg.hpp"
+#include "XBeeApiFrameView.hpp"
+#include "XBeeApiBlockPool.hpp"
+#include "XBeeApiAtomic.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Immutable copy of a complete received frame (from XBEE_CMD_POSN_SDELIM to the checksum),
+    held in a block from a fixed-size pool (see XBEEAPI_CONFIG_SHARED_FRAMES) and shared by
+    reference counting.
+
+    XBeeDevice copies a frame into a shared frame once & hands the same copy to each of the
+    decoders registered for fan-out (see XBeeApiFrameDecoder::sharedFrameCallback()), rather
+    than each decoder which wants to keep the frame having to copy it for itself.  A decoder
+    which needs the frame after its call-back has returned calls acquire() and later
+    release().  The frame returns to the pool when the last reference is released.
+
+    acquire() & release() may be called from any context, including interrupt context */
+class XBeeApiSharedFrame
+{
+    protected:
+        /** Number of references held to the frame */
+        XBeeApiAtomicIndex m_refs;
+
+        /** Length of the frame held in m_data */
+        uint16_t m_len;
+
+        /** The frame content */
+        uint8_t m_data[ XBEEAPI_CONFIG_SHARED_FRAME_SIZE ];
+
+        /** Pool from which the frames are allocated */
+        static XBeeApiBlockPool s_pool;
+
+        /** Constructor.  Frames are only constructed by alloc() */
+        XBeeApiSharedFrame( void );
+
+        /** Destructor.  Frames are only destroyed by release() */
+        ~XBeeApiSharedFrame( void );
+
+    public:
+        /** Allocate a frame from the pool & copy a received frame into it.  The caller holds
+            the only reference to the returned frame.  May be called from interrupt context.
+
+            \param p_frame View of the frame to be copied
+            \returns The frame, or NULL in the case that the pool is exhausted or p_frame is
+                     longer than XBEEAPI_CONFIG_SHARED_FRAME_SIZE */
+        static XBeeApiSharedFrame* alloc( const XBeeApiFrameView& p_frame );
+
+        /** Take an additional reference to the frame, keeping it valid until a matching
+            call to release() */
+        void acquire( void );
+
+        /** Give up a reference to the frame.  The frame (and any pointers into it) must not
+            be used by the caller after this has been called.  The frame is returned to the
+            pool when its last reference is released */
+        void release( void );
+
+        /** Retrieve a view of the frame.  The view is always contiguous */
+        XBeeApiFrameView getView( void ) const;
+
+        /** Retrieve a pointer to the frame content, starting with XBEE_CMD_POSN_SDELIM */
+        const uint8_t* getData( void ) const { return m_data; }
+
+        /** Retrieve the length of the frame, including the delimiter, length & checksum */
+        size_t getLen( void ) const { return m_len; }
+
+        /** Retrieve the number of references currently held to the frame */
+        size_t getRefCount( void ) const;
+
+        /** Retrieve the number of frames currently free in the pool */
+        static size_t getFreeCount( void );
+
+        /** Retrieve the lowest number of frames which have been free in the pool at any one
+            time.  Useful for tuning XBEEAPI_CONFIG_SHARED_FRAMES */
+        static size_t getFreeLowWater( void );
+};
+
+#endif
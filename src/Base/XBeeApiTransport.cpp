@@ -0,0 +1,57 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiTransport.hpp"
+
+XBeeApiTransport::~XBeeApiTransport( void )
+{
+}
+
+size_t XBeeApiTransport::writeSegments( const XBeeApiFrameSegment_t* const p_segs, const size_t p_count )
+{
+    size_t ret_val = 0;
+
+    for( size_t i = 0; i < p_count; i++ )
+    {
+        const size_t written = write( p_segs[ i ].m_data, p_segs[ i ].m_len );
+
+        ret_val += written;
+
+        if( written < p_segs[ i ].m_len )
+        {
+            break;
+        }
+    }
+
+    return ret_val;
+}
+
+void XBeeApiTransport::flush( void )
+{
+}
+
+bool XBeeApiTransport::attachRx( const XBeeApiTransportRxCallback_t, void* const )
+{
+    /* By default, received data must be polled for */
+    return false;
+}
+
+int XBeeApiTransport::getFd( void ) const
+{
+    return XBEE_TRANSPORT_FD_INVALID;
+}
@@ -0,0 +1,114 @@
+/**
+   @file
+   @brief Interface to the serial link connecting an XBeeDevice to its XBee
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPITRANSPORT_HPP
+#define      XBEEAPITRANSPORT_HPP
+
+#include "XBeeApiFrame.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Value returned by XBeeApiTransport::getFd() for a transport with no file descriptor */
+#define XBEE_TRANSPORT_FD_INVALID (-1)
+
+/** Abstract class representing the serial link to the XBee.  XBeeDevice performs all of
+    its I/O through an object derived from this class, allowing the same protocol stack
+    to be used on different platforms:
+      - XBeeApiTransportMbed: an mbed Serial object, with received data signalled from
+                              the serial RX interrupt
+      - XBeeApiTransportTermios: a POSIX serial device (or pty), which the application
+                                 polls for received data (see XBeeDevice::pollRx())
+
+    Data is transferred in blocks rather than byte-by-byte, allowing implementations to
+    make the most of any buffering provided by the platform. */
+class XBeeApiTransport
+{
+    public:
+        /** Type of function which the transport calls when data has been received
+
+            \param p_ctx Context pointer, as passed to attachRx() */
+        typedef void (*XBeeApiTransportRxCallback_t)( void* const p_ctx );
+
+        /** Destructor */
+        virtual ~XBeeApiTransport( void );
+
+        /** Read any data which has been received, without blocking
+
+            \param p_buff Buffer to receive the data
+            \param p_len Size of p_buff in bytes
+            \returns The number of bytes read, 0 in the case that no data was available */
+        virtual size_t read( uint8_t* const p_buff, const size_t p_len ) = 0;
+
+        /** Write data to the XBee.  Blocks until all of the data has been accepted by the
+            platform
+
+            \param p_buff Data to be written
+            \param p_len Length of the data pointed to by p_buff
+            \returns The number of bytes written, which is less than p_len only in the case
+                     of an error */
+        virtual size_t write( const uint8_t* const p_buff, const size_t p_len ) = 0;
+
+        /** Write a number of separate pieces of data to the XBee, in order, as though they
+            were a single buffer.  The default implementation calls write() for each 
+            segment; transports which support gathered writes (e.g. writev()) should 
+            over-ride it.  Blocks until all of the data has been accepted by the platform
+
+            \param p_segs Segments to be written
+            \param p_count Number of entries in p_segs
+            \returns The total number of bytes written, which is less than the total length
+                     of the segments only in the case of an error */
+        virtual size_t writeSegments( const XBeeApiFrameSegment_t* const p_segs, const size_t p_count );
+
+        /** Ensure that any data buffered by write() is sent on to the XBee */
+        virtual void flush( void );
+
+        /** Wait for data to be available to read()
+
+            \param p_timeout_ms Maximum time to wait, in milliseconds.  0 to check without
+                                waiting
+            \returns true in the case that data is available, false in the case that the
+                     timeout expired */
+        virtual bool waitReadable( const uint32_t p_timeout_ms ) = 0;
+
+        /** Request that a function be called whenever data is received.  The function may
+            be called from interrupt context.
+
+            \param p_callback Function to be called
+            \param p_ctx Context pointer to be passed to the function
+            \returns true in the case that the transport is able to make the call-backs,
+                     false in the case that it isn't, in which case received data must be
+                     polled for (see XBeeDevice::pollRx()) */
+        virtual bool attachRx( const XBeeApiTransportRxCallback_t p_callback, void* const p_ctx );
+
+        /** Retrieve a file descriptor which becomes readable when data is available to
+            read(), allowing the transport to be waited on along with other descriptors
+            (see XBeeDevice::getEventFd())
+
+            \returns The descriptor, or XBEE_TRANSPORT_FD_INVALID in the case that the 
+                     transport doesn't have one */
+        virtual int getFd( void ) const;
+};
+
+#endif
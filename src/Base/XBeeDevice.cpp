@@ -18,21 +18,39 @@ limitations under the License.
 
 #include "XBeeDevice.hpp"
 #include "XBeeApiCfg.hpp"
+#include "XBeeApiEscape.hpp"
+#include "XBeeApiCriticalSection.hpp"
+#include "XBeeApiEvent.hpp"
+#include "XBeeApiSharedFrame.hpp"
+#if !defined XBEEAPI_CONFIG_POSIX
+#include "XBeeApiTransportMbed.hpp"
+#endif
+
+#include <string.h>
+#include <stdio.h>
+
+#if defined XBEEAPI_CONFIG_POSIX
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
 
-/** Number of bytes we need to 'peek' into the receive buffer in order to retrieve the 
+/** Number of bytes we need to have in the receive buffer in order to retrieve the 
     payload length */
 #define INITIAL_PEEK_LEN (3U)
-    
-/** Enum of bytes with a special meaning when communicating with the XBee in API
-    mode.  In escaped mode, these are the bytes that need to be escaped */
-typedef enum
-{
-    XBEE_SB_XON             = 0x11,
-    XBEE_SB_XOFF            = 0x13,
-    XBEE_SB_FRAME_DELIMITER = 0x7E,
-    XBEE_SB_ESCAPE          = 0x7D
-} XBeeSerialSpecialBytes_e;
 
+/** Number of bytes read from the serial interface by if_rx() before they're un-escaped
+    and passed to the parser */
+#define RX_CHUNK_LEN (XBEEAPI_CONFIG_RX_CHUNK_SIZE)
+
+/** Value which the sum of the API identifier, API-specific data & checksum should
+    have in a valid frame */
+#define XBEE_CHECKSUM_VALID (0xFFU)
+
+/** Runs of data to be transmitted which are shorter than this are copied into the TX buffer
+    rather than being written from where they are as a separate segment */
+#define XBEE_TX_MIN_SEGMENT_LEN (16U)
+    
 /** ASCII command to the XBee to request API mode 2 */
 const char api_mode2_cmd[] = { 'A', 'T', 'A', 'P', ' ', '2', '\r' };
 
@@ -45,42 +63,117 @@ void XBeeDevice::init()
     m_inAtCmdMode = false;
     m_rxMsgLastWasEsc = false;
     m_escape = true;
+    resetRx();
+
+    for( size_t i = 0; i < XBEEAPI_CONFIG_DECODER_LIST_SIZE; i++ )
+    {
+        m_decoders[ i ] = NULL;
+    }
+    memset( m_dispatch, 0, sizeof( m_dispatch ));
+    m_fanOut = 0;
+
+    for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        m_inFlight[ i ].m_owner = NULL;
+        m_inFlight[ i ].m_frameId = XBEE_FRAME_ID_NONE;
+    }
+    m_nextFrameId = XBEE_FRAME_ID_NONE + 1U;
+    m_inFlightCount = 0;
+
+    m_txQueueHead = 0;
+    m_txQueueCount = 0;
+    m_txWindow = XBEEAPI_CONFIG_TX_WINDOW;
+    m_txPumping = false;
+
+    m_rxDroppedFrames = 0;
+    m_rxDroppedBytes = 0;
+    m_rxDecodedFrames = 0;
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+    m_rxInline = false;
+#endif
 }
 
-XBeeDevice::XBeeDevice( PinName p_tx, PinName p_rx, PinName p_rts, PinName p_cts ):  m_serialNeedsDelete( true )
+#if !defined XBEEAPI_CONFIG_POSIX
+XBeeDevice::XBeeDevice( PinName p_tx, PinName p_rx, PinName p_rts, PinName p_cts ):  m_transportNeedsDelete( true )
 {    
     init();
     
-    m_if = new Serial( p_tx, p_rx ), 
+    m_if = new XBeeApiTransportMbed( p_tx, p_rx, p_rts, p_cts );
+    attachTransport();
+}
 
-    /* Can only do flow control on devices which support it */
-#if defined ( DEVICE_SERIAL_FC )
-    /* TODO: need rts and cts both set? */
-    m_if->set_flow_control( mbed::SerialBase::Flow.RTSCTS, p_rts, p_cts );
-#endif
+XBeeDevice::XBeeDevice( Serial* p_serialIf ): m_transportNeedsDelete( true )
+{    
+    init();
 
-    /* Attach RX call-back to the serial interface */
-    m_if->attach( this, &XBeeDevice::if_rx, Serial::RxIrq); 
+    m_if = new XBeeApiTransportMbed( p_serialIf );
+    attachTransport();
 }
+#endif
 
-XBeeDevice::XBeeDevice( Serial* p_serialIf ): m_if( p_serialIf ),
-                                              m_serialNeedsDelete( true )
+XBeeDevice::XBeeDevice( XBeeApiTransport* p_transport ): m_if( p_transport ),
+                                                         m_transportNeedsDelete( false )
 {    
     init();
+    attachTransport();
+#if defined XBEEAPI_CONFIG_POSIX
+    initEventFd();
+#endif
+}
+
+void XBeeDevice::attachTransport( void )
+{
+    /* Ask the transport to tell us when data's received.  If it can't, it'll need to 
+       be polled for */
+    m_rxAttached = m_if->attachRx( &XBeeDevice::transportRx, this );
+}
+
+void XBeeDevice::transportRx( void* const p_ctx )
+{
+    ((XBeeDevice*)p_ctx)->if_rx();
 }
 
+#if defined XBEEAPI_CONFIG_POSIX
+void XBeeDevice::initEventFd( void )
+{
+    struct epoll_event ev;
+    const int transportFd = m_if->getFd();
+
+    m_eventFd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+    m_pollFd = epoll_create1( EPOLL_CLOEXEC );
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl( m_pollFd, EPOLL_CTL_ADD, m_eventFd, &ev );
+
+    /* A transport which signals received data itself will do so via if_rx(), which 
+       signals m_eventFd as required */
+    if(( !m_rxAttached ) &&
+       ( transportFd != XBEE_TRANSPORT_FD_INVALID ))
+    {
+        epoll_ctl( m_pollFd, EPOLL_CTL_ADD, transportFd, &ev );
+    }
+}
+#endif
+
 XBeeDevice::~XBeeDevice( void )
 {
     /* Iterate all of the decoders and un-register them */
-    for( FixedLengthList<XBeeApiFrameDecoder*, XBEEAPI_CONFIG_DECODER_LIST_SIZE>::iterator it = m_decoders.begin() ;
-         it != m_decoders.end();
-         ++it ) {
-        (*it)->unregisterCallback();
+    for( size_t i = 0; i < XBEEAPI_CONFIG_DECODER_LIST_SIZE; i++ )
+    {
+        if( m_decoders[ i ] != NULL )
+        {
+            m_decoders[ i ]->unregisterCallback();
+        }
     }
-    if( m_serialNeedsDelete )
+    if( m_transportNeedsDelete )
     {
         delete( m_if );
     }
+#if defined XBEEAPI_CONFIG_POSIX
+    close( m_pollFd );
+    close( m_eventFd );
+#endif
 }
 
 XBeeDevice::XBeeDeviceModel_t XBeeDevice::getXBeeModel() const
@@ -95,101 +188,494 @@ void XBeeDevice::setXBeeModel( const XBeeDevice::XBeeDeviceModel_t p_model )
 
 void XBeeDevice::if_rx( void )
 {
-    /* Keep going while there are bytes to be read */
-    while(m_if->readable()) {
-        
-        uint8_t c = m_if->getc();
-        
-        /* Sanity check that if we're starting from an empty buffer the byte that we're
-           receiving is a frame delimiter */
-        if(( m_inAtCmdMode ) ||
-           (( c == XBEE_SB_FRAME_DELIMITER ) ||
-            ( m_rxBuff.getSize() ))) 
-        {
-            /* If it's an escape character we want to de-code the escape, so flag
-               that we have a pending escape but don't modify the rx buffer */
-            if( m_escape &&
-               ( c == XBEE_SB_ESCAPE ))
-            {
-                m_rxMsgLastWasEsc = true;
-            }
-            else
-            {
-                if( m_rxMsgLastWasEsc ) {
-                    c = c ^ 0x20;  
-                    m_rxMsgLastWasEsc = false;
-                }
-                m_rxBuff.write( &c, 1 );
-            }
-        } else {
-            /* TODO */    
+    uint8_t chunk[ RX_CHUNK_LEN ];
+    size_t chunkLen;
+
+    /* Keep going while there are bytes to be read, processing them in chunks */
+    do {
+        chunkLen = m_if->read( chunk, sizeof( chunk ));
+
+        if( m_inAtCmdMode )
+        {
+            /* ASCII responses go straight into the buffer for SendFrame() to examine */
+            m_rxDroppedBytes += chunkLen - m_rxBuff.write( chunk, chunkLen );
         }
-    }
+        else
+        {
+            unescapeRx( chunk, chunkLen );
+        }
+    } while( chunkLen == sizeof( chunk ));
     
     if( m_inAtCmdMode ) 
     {
         /* Safeguard - if we're in cmd mode, clear out status associated with API mode */
         m_rxMsgLastWasEsc = false;
+        resetRx();
     } 
     else 
     {
-        /* Check to see if there's API data to decode */
-        checkRxDecode();
+        if( canDecodeRx() )
+        {
+            /* Check to see if there's API data to decode */
+            checkRxDecode();
+        }
+        else if( m_rxBuff.getSize() )
+        {
+            /* Leave the decoding to processRx(), outside of interrupt context */
+            signalPending();
+        }
+    }
+}
+
+void XBeeDevice::signalPending( void )
+{
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+    m_rxEvent.signal();
+#endif
+#if defined XBEEAPI_CONFIG_POSIX
+    /* No need to signal again if the last signal hasn't been cleared yet.  The flag is 
+       only set after the descriptor has been written so that processPendingIo() can't 
+       clear the flag without also clearing the descriptor */
+    if( m_eventPending.load() == 0 )
+    {
+        const uint64_t inc = 1U;
+        size_t expected = 0;
+
+        if( write( m_eventFd, &inc, sizeof( inc )) < 0 )
+        {
+            /* Counter can only be full if it's already readable */
+        }
+        m_eventPending.compareExchange( expected, 1U );
     }
+#endif
 }
-    
-void XBeeDevice::checkRxDecode( void )
+
+void XBeeDevice::unescapeRx( uint8_t* const p_data, const size_t p_len )
+{
+    if( m_escape )
+    {
+        size_t pos = 0;
+
+        while( pos < p_len )
+        {
+            uint8_t* const start = &( p_data[ pos ] );
+            size_t unescapedLen;
+
+            /* Un-escape in-place, up to the next delimiter */
+            pos += xbeeApiUnescape( start, p_len - pos, start, &unescapedLen, &m_rxMsgLastWasEsc );
+            parseRx( start, unescapedLen );
+
+            if( pos < p_len )
+            {
+                /* When escaping is in use an un-escaped delimiter always marks the start 
+                   of a new frame - anything partially received is incomplete */
+                resetRx();
+                m_rxMsgLastWasEsc = false;
+                parseRx( &( p_data[ pos ] ), 1 );
+                pos++;
+            }
+        }
+    }
+    else
+    {
+        parseRx( p_data, p_len );
+    }
+}
+
+void XBeeDevice::resetRx( void )
+{
+    m_rxBuff.discard();
+    m_rxState = XBEE_RX_STATE_DELIMITER;
+}
+
+void XBeeDevice::parseRx( const uint8_t* p_data, size_t p_len )
 {
-    uint8_t buff[INITIAL_PEEK_LEN];
-    bool cont = false;
+    while( p_len )
+    {
+        size_t used = 1;
+
+        switch( m_rxState )
+        {
+            case XBEE_RX_STATE_DELIMITER:
+                /* Anything other than a delimiter is discarded */
+                if( *p_data == XBEE_SB_FRAME_DELIMITER )
+                {
+                    /* Make sure there's space for the delimiter & length */
+                    if(( m_rxBuff.getFree() < INITIAL_PEEK_LEN ) &&
+                       ( canDecodeRx() ))
+                    {
+                        decodeRx();
+                    }
+                    if( m_rxBuff.append( p_data, 1 ))
+                    {
+                        m_rxState = XBEE_RX_STATE_LEN_HI;
+                    }
+                    else
+                    {
+                        m_rxDroppedFrames++;
+                    }
+                }
+                break;
+            case XBEE_RX_STATE_LEN_HI:
+                m_rxFrameLen = ((uint16_t)*p_data) << 8U;
+                m_rxBuff.append( p_data, 1 );
+                m_rxState = XBEE_RX_STATE_LEN_LO;
+                break;
+            case XBEE_RX_STATE_LEN_LO:
+                m_rxFrameLen |= *p_data;
+                m_rxFrameRemaining = m_rxFrameLen;
+                m_rxChecksum = 0;
+
+                /* Check up-front that there's space for the entire frame - if not, try 
+                   decoding the frames already received to make some.  Failing that, there's
+                   no point in receiving it */
+                if(( m_rxFrameLen > 0 ) && 
+                   ( m_rxBuff.getFree() < ( m_rxFrameLen + XBEE_API_FRAME_OVERHEAD - 2U )) &&
+                   ( canDecodeRx() ))
+                {
+                    decodeRx();
+                }
+                if(( m_rxFrameLen > 0 ) && 
+                   ( m_rxBuff.getFree() >= ( m_rxFrameLen + XBEE_API_FRAME_OVERHEAD - 2U )))
+                {
+                    m_rxBuff.append( p_data, 1 );
+                    m_rxState = XBEE_RX_STATE_PAYLOAD;
+                }
+                else
+                {
+                    if( m_rxFrameLen > 0 )
+                    {
+                        m_rxDroppedFrames++;
+                        m_rxDroppedBytes += m_rxFrameLen + XBEE_API_FRAME_OVERHEAD;
+                    }
+                    m_rxBuff.discard();
+                    m_rxState = XBEE_RX_STATE_DISCARD;
+                }
+                break;
+            case XBEE_RX_STATE_PAYLOAD:
+                /* Take as much of the payload as is available in one go */
+                used = m_rxFrameRemaining;
+                if( used > p_len )
+                {
+                    used = p_len;
+                }
+                m_rxChecksum = xbeeApiChecksum( p_data, used, m_rxChecksum );
+                m_rxBuff.append( p_data, used );
+                m_rxFrameRemaining -= used;
+                if( m_rxFrameRemaining == 0 )
+                {
+                    m_rxState = XBEE_RX_STATE_CHECKSUM;
+                }
+                break;
+            case XBEE_RX_STATE_CHECKSUM:
+                m_rxChecksum += *p_data;
+                if( m_rxChecksum == XBEE_CHECKSUM_VALID )
+                {
+                    /* Frame is complete & valid - make it available for decoding */
+                    m_rxBuff.append( p_data, 1 );
+                    m_rxBuff.commit();
+                }
+                else
+                {
+                    m_rxBuff.discard();
+                }
+                m_rxState = XBEE_RX_STATE_DELIMITER;
+                break;
+            case XBEE_RX_STATE_DISCARD:
+                /* Skip the remainder of the payload plus the checksum */
+                if( m_rxFrameRemaining == 0 )
+                {
+                    m_rxState = XBEE_RX_STATE_DELIMITER;
+                }
+                else
+                {
+                    used = m_rxFrameRemaining;
+                    if( used > p_len )
+                    {
+                        used = p_len;
+                    }
+                    m_rxFrameRemaining -= used;
+                }
+                break;
+        }
+
+        p_data += used;
+        p_len -= used;
+    }
+}
     
-    /* Ensure that we're delimiter aligned - this should allow recovery in the case that
-       we've missed bytes and somehow become unaligned */
+bool XBeeDevice::canDecodeRx( void ) const
+{
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+    return m_rxInline;
+#else
+    return true;
+#endif
+}
+
+size_t XBeeDevice::checkRxDecode( void )
+{
+    const size_t ret_val = decodeRx();
+
+    /* Responses may have opened up the TX window */
+    signalIfTxReady();
+
+    return ret_val;
+}
+
+void XBeeDevice::signalIfTxReady( void )
+{
+    bool txReady;
+
+    {
+        XBeeApiCriticalSection cs( m_csLock );
+        txReady = (( m_txQueueCount > 0 ) &&
+                   ( m_inFlightCount < m_txWindow ));
+    }
+
+    if( txReady )
+    {
+        signalPending();
+    }
+}
+
+size_t XBeeDevice::decodeRx( void )
+{
+    size_t ret_val = 0;
+
+    /* Ensure that we're delimiter aligned - the parser only makes complete frames 
+       available, but there may be residual data left over from AT command mode */
     while( m_rxBuff.getSize() &&
           ( m_rxBuff[0] != XBEE_SB_FRAME_DELIMITER ))
     {
         m_rxBuff.chomp( 1 );
     }
     
-    do {
-        /* Get an initial portion of data from the read buffer so that the message length can be determined */
-        uint16_t len = m_rxBuff.peek( buff, INITIAL_PEEK_LEN );    
-        cont = false;
-        
-        /* Ensure that sufficient data was received - already know that we should be delimiter aligned based on the above */
-        if( len >= INITIAL_PEEK_LEN ) 
+    /* Ensure that sufficient data has been received to determine the message length - already 
+       know that we should be delimiter aligned based on the above */
+    while( m_rxBuff.getSize() >= INITIAL_PEEK_LEN ) 
+    {
+        const size_t cmdLen = MSG_LEN_IN_BUFFER( m_rxBuff ) + XBEE_API_FRAME_OVERHEAD;
+        XBeeApiFrameView cmdView;
+
+        /* The parser only commits complete frames, so this should always succeed */
+        if( !m_rxBuff.getView( cmdLen, &cmdView ))
         {
-            /* Try and get enough data to cover the whole message */
-            const uint16_t cmdLen = MSG_LEN_IN_BUFFER( buff ) + XBEE_API_FRAME_OVERHEAD;
-            uint8_t cmdBuff[cmdLen];
-            uint16_t len = m_rxBuff.peek( cmdBuff, cmdLen );    
-    
-            /* Check that we've received the entire frame */
-            if( len >= cmdLen )
+            break;
+        }
+
+        XBeeDecoderMask_t interested = m_dispatch[ cmdView[ XBEE_CMD_POSN_API_ID ] ];
+
+        /* Fan-out decoders all see the frame, whatever the others do with it - including
+           responses which are routed to the decoder which sent the frame */
+        if( interested & m_fanOut )
+        {
+            fanOutRx( cmdView, interested & m_fanOut );
+            interested &= (XBeeDecoderMask_t)~m_fanOut;
+        }
+
+        /* Responses to frames with an allocated frame identifier go straight to the decoder 
+           which sent the frame.  Anything else is offered to the remaining decoders which are
+           interested in this type of frame, giving them a view of the frame directly within
+           the receive buffer */
+        if( !routeResponse( cmdView ))
+        {
+            for( size_t i = 0;
+                 interested != 0;
+                 i++, interested >>= 1U ) {
+
+                if(( interested & 1U ) &&
+                   ( m_decoders[ i ]->decodeCallback( cmdView )))
+                {
+                    break;
+                }
+            }
+        }
+        /* Remove the data from the receive buffer - either it was decoded (all well and good)
+           or it wasn't, in which case we need to get rid of it to prevent it from jamming
+           up the message queue */
+        m_rxBuff.chomp( cmdLen );
+        ret_val++;
+    }
+
+    m_rxDecodedFrames += ret_val;
+
+    return ret_val;
+}
+
+void XBeeDevice::fanOutRx( const XBeeApiFrameView& p_frame, XBeeDecoderMask_t p_decoders )
+{
+    /* The frame is copied out of the receive buffer once, with each decoder being given
+       the same copy.  If there's no copy to be had, fall back to offering the frame in-place */
+    XBeeApiSharedFrame* const shared = XBeeApiSharedFrame::alloc( p_frame );
+
+    for( size_t i = 0;
+         p_decoders != 0;
+         i++, p_decoders >>= 1U ) 
+    {
+        if( p_decoders & 1U )
+        {
+            if( shared != NULL )
             {
-                /* TODO: Verify checksum */
-                
-                /* Iterate all of the decoders */
-                for( FixedLengthList<XBeeApiFrameDecoder*, XBEEAPI_CONFIG_DECODER_LIST_SIZE>::iterator it = m_decoders.begin() ;
-                     it != m_decoders.end();
-                     ++it ) {
-    
-                    bool processed = (*it)->decodeCallback( cmdBuff, cmdLen );
-                    if( processed )
+                m_decoders[ i ]->sharedFrameCallback( shared );
+            }
+            else
+            {
+                m_decoders[ i ]->decodeCallback( p_frame );
+            }
+        }
+    }
+
+    /* Any decoder which wants to keep the frame will have taken its own reference */
+    if( shared != NULL )
+    {
+        shared->release();
+    }
+}
+
+bool XBeeDevice::routeResponse( const XBeeApiFrameView& p_frame )
+{
+    bool ret_val = false;
+
+    switch( p_frame[ XBEE_CMD_POSN_API_ID ] )
+    {
+        case XBEE_CMD_AT_RESPONSE:
+        case XBEE_CMD_TX_STATUS:
+        case XBEE_CMD_REMOTE_AT_RESPONSE:
+            if( p_frame.getLen() > ( XBEE_CMD_POSN_FRAME_ID + 1U ))
+            {
+                const uint8_t frameId = p_frame[ XBEE_CMD_POSN_FRAME_ID ];
+                XBeeApiFrameDecoder* owner = NULL;
+
+                if( frameId != XBEE_FRAME_ID_NONE )
+                {
+                    XBeeApiCriticalSection cs( m_csLock );
+                    const size_t i = findInFlight( frameId );
+
+                    if( i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT )
                     {
-                        break;
+                        /* Response received - the identifier can be re-used */
+                        owner = m_inFlight[ i ].m_owner;
+                        m_inFlight[ i ].m_owner = NULL;
+                        m_inFlightCount--;
                     }
-                }            
-                /* Remove the data from the receive buffer - either it was decoded (all well and good)
-                   or it wasn't, in which case we need to get rid of it to prevent it from jamming
-                   up the message queue */
-                m_rxBuff.chomp( cmdLen );
-
-                /* Successfully decoded 1 message ... there may be more waiting in the buffer! */                
-                cont = true;
+                }
+
+                if( owner != NULL )
+                {
+                    ret_val = owner->decodeCallback( p_frame );
+                }
             }
+            break;
+        default:
+            break;
+    }
+
+    return ret_val;
+}
+
+size_t XBeeDevice::findInFlight( const uint8_t p_id ) const
+{
+    size_t ret_val = XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+
+    for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        if(( m_inFlight[ i ].m_owner != NULL ) &&
+           ( m_inFlight[ i ].m_frameId == p_id ))
+        {
+            ret_val = i;
+            break;
         }
-    } while( cont );
+    }
+
+    return ret_val;
+}
+
+uint8_t XBeeDevice::allocFrameId( XBeeApiFrameDecoder* const p_owner )
+{
+    uint8_t ret_val = XBEE_FRAME_ID_NONE;
+
+    if( p_owner != NULL )
+    {
+        XBeeApiCriticalSection cs( m_csLock );
+        size_t slot = XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+
+        for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+        {
+            if( m_inFlight[ i ].m_owner == NULL )
+            {
+                slot = i;
+                break;
+            }
+        }
+
+        if( slot < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT )
+        {
+            /* Identifiers are handed out in sequence, skipping any that are still in flight.
+               There's always at least one identifier which isn't, as the table can't hold
+               them all */
+            for( size_t tries = 0; tries < XBEE_FRAME_ID_COUNT; tries++ )
+            {
+                const uint8_t candidate = m_nextFrameId++;
+
+                if(( candidate != XBEE_FRAME_ID_NONE ) &&
+                   ( findInFlight( candidate ) == XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT ))
+                {
+                    m_inFlight[ slot ].m_owner = p_owner;
+                    m_inFlight[ slot ].m_frameId = candidate;
+                    m_inFlightCount++;
+                    ret_val = candidate;
+                    break;
+                }
+            }
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeDevice::releaseFrameId( const uint8_t p_id, const XBeeApiFrameDecoder* const p_owner )
+{
+    bool ret_val = false;
+
+    if( p_id != XBEE_FRAME_ID_NONE )
+    {
+        XBeeApiCriticalSection cs( m_csLock );
+        const size_t i = findInFlight( p_id );
+
+        if(( i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT ) &&
+           ( m_inFlight[ i ].m_owner == p_owner ))
+        {
+            m_inFlight[ i ].m_owner = NULL;
+            m_inFlightCount--;
+            ret_val = true;
+        }
+    }
+
+    if( ret_val )
+    {
+        signalIfTxReady();
+    }
+
+    return ret_val;
+}
+
+void XBeeDevice::releaseFrameIds( const XBeeApiFrameDecoder* const p_owner )
+{
+    {
+        XBeeApiCriticalSection cs( m_csLock );
+
+        for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+        {
+            if( m_inFlight[ i ].m_owner == p_owner )
+            {
+                m_inFlight[ i ].m_owner = NULL;
+                m_inFlightCount--;
+            }
+        }
+    }
+
+    signalIfTxReady();
 }
 
 bool XBeeDevice::registerDecoder( XBeeApiFrameDecoder* const p_decoder )
@@ -197,10 +683,56 @@ bool XBeeDevice::registerDecoder( XBeeApiFrameDecoder* const p_decoder )
     bool ret_val = false;
     if( p_decoder != NULL )
     {
-        /* Check if decoder already registered */
-        if( !m_decoders.inList( p_decoder ) ) 
+        size_t slot = XBEEAPI_CONFIG_DECODER_LIST_SIZE;
+
+        /* Check if decoder already registered & find a free slot at the same time */
+        for( size_t i = 0; i < XBEEAPI_CONFIG_DECODER_LIST_SIZE; i++ )
+        {
+            if( m_decoders[ i ] == p_decoder )
+            {
+                slot = XBEEAPI_CONFIG_DECODER_LIST_SIZE;
+                break;
+            }
+            if(( m_decoders[ i ] == NULL ) &&
+               ( slot == XBEEAPI_CONFIG_DECODER_LIST_SIZE ))
+            {
+                slot = i;
+            }
+        }
+
+        if( slot < XBEEAPI_CONFIG_DECODER_LIST_SIZE ) 
         {
-            m_decoders.push( p_decoder );   
+            const XBeeApiIdentifier_e* ids;
+            const size_t idCount = p_decoder->getApiIds( &ids );
+            const XBeeDecoderMask_t bit = (XBeeDecoderMask_t)( 1U << slot );
+
+            m_decoders[ slot ] = p_decoder;
+
+            if( p_decoder->m_fanOut )
+            {
+                m_fanOut |= bit;
+            }
+
+            /* Add the decoder to the dispatch table entries for the frame types it's
+               interested in */
+            if( idCount == 0 )
+            {
+                for( size_t i = 0; i < XBEE_API_ID_COUNT; i++ )
+                {
+                    m_dispatch[ i ] |= bit;
+                }
+            }
+            else
+            {
+                for( size_t i = 0; i < idCount; i++ )
+                {
+                    if( ids[ i ] < XBEE_API_ID_COUNT )
+                    {
+                        m_dispatch[ ids[ i ] ] |= bit;
+                    }
+                }
+            }
+
             p_decoder->registerCallback( this );
             ret_val = true;
         }
@@ -213,94 +745,442 @@ bool XBeeDevice::unregisterDecoder( XBeeApiFrameDecoder* const p_decoder )
     bool ret_val = false;
     if( p_decoder != NULL )
     {
-        if( m_decoders.remove( p_decoder ) )
+        for( size_t i = 0; i < XBEEAPI_CONFIG_DECODER_LIST_SIZE; i++ )
         {
-            p_decoder->unregisterCallback();
-            ret_val = true;   
+            if( m_decoders[ i ] == p_decoder )
+            {
+                const XBeeDecoderMask_t mask = (XBeeDecoderMask_t)~( 1U << i );
+
+                for( size_t j = 0; j < XBEE_API_ID_COUNT; j++ )
+                {
+                    m_dispatch[ j ] &= mask;
+                }
+                m_fanOut &= mask;
+                m_decoders[ i ] = NULL;
+                releaseFrameIds( p_decoder );
+
+                p_decoder->unregisterCallback();
+                ret_val = true;   
+                break;
+            }
         }
     }
     return ret_val;
 }
 
-void XBeeDevice::SendFrame( XBeeApiFrame* const p_cmd )
+bool XBeeDevice::SendFrame( XBeeApiFrame* const p_cmd )
 {
-    uint8_t sum = 0U;
-    uint16_t len;
-    uint16_t i;
-    const uint8_t* cmdData;
-    uint16_t written = 0;
- 
-#if defined  XBEEAPI_CONFIG_USING_RTOS
-    m_ifMutex.lock();
+    /* Give the frame the chance to allocate a frame identifier, etc */
+    bool ret_val = p_cmd->prepareForTx( this );
+
+    if( ret_val )
+    {
+        writeFrame( p_cmd );
+    }
+
+    return ret_val;
+}
+
+bool XBeeDevice::queueFrame( XBeeApiFrame* const p_cmd )
+{
+    bool ret_val = false;
+
+    if( p_cmd != NULL )
+    {
+        XBeeApiCriticalSection cs( m_csLock );
+
+        if( m_txQueueCount < XBEEAPI_CONFIG_TX_QUEUE_SIZE )
+        {
+            m_txQueue[ ( m_txQueueHead + m_txQueueCount ) % XBEEAPI_CONFIG_TX_QUEUE_SIZE ] = p_cmd;
+            m_txQueueCount++;
+            ret_val = true;
+        }
+    }
+
+    if( ret_val )
+    {
+        pumpTxQueue();
+    }
+
+    return ret_val;
+}
+
+bool XBeeDevice::cancelFrame( const XBeeApiFrame* const p_cmd )
+{
+    bool ret_val = false;
+    XBeeApiCriticalSection cs( m_csLock );
+
+    for( size_t i = 0; i < m_txQueueCount; i++ )
+    {
+        if( m_txQueue[ ( m_txQueueHead + i ) % XBEEAPI_CONFIG_TX_QUEUE_SIZE ] == p_cmd )
+        {
+            /* Close the gap by shuffling the following frames down */
+            for( ; i < ( m_txQueueCount - 1U ); i++ )
+            {
+                m_txQueue[ ( m_txQueueHead + i ) % XBEEAPI_CONFIG_TX_QUEUE_SIZE ] =
+                    m_txQueue[ ( m_txQueueHead + i + 1U ) % XBEEAPI_CONFIG_TX_QUEUE_SIZE ];
+            }
+            m_txQueueCount--;
+            ret_val = true;
+            break;
+        }
+    }
+
+    return ret_val;
+}
+
+void XBeeDevice::pumpTxQueue( void )
+{
+    bool pumping = false;
+
+    {
+        XBeeApiCriticalSection cs( m_csLock );
+        if( !m_txPumping )
+        {
+            m_txPumping = true;
+            pumping = true;
+        }
+    }
+
+    /* If another context is already pumping, it will pick up any change in state */
+    while( pumping )
+    {
+        XBeeApiFrame* frame = NULL;
+
+        {
+            XBeeApiCriticalSection cs( m_csLock );
+
+            /* Deciding to stop and clearing m_txPumping are done together so that a response 
+               arriving in between can't be missed */
+            if(( m_txQueueCount > 0 ) &&
+               ( m_inFlightCount < m_txWindow ))
+            {
+                frame = m_txQueue[ m_txQueueHead ];
+                m_txQueueHead = ( m_txQueueHead + 1U ) % XBEEAPI_CONFIG_TX_QUEUE_SIZE;
+                m_txQueueCount--;
+            }
+            else
+            {
+                m_txPumping = false;
+                pumping = false;
+            }
+        }
+
+        if(( frame != NULL ) &&
+           ( !SendFrame( frame )))
+        {
+            bool dropped = false;
+
+            {
+                XBeeApiCriticalSection cs( m_csLock );
+
+                /* Frame identifiers are being used by something other than the queue - put the 
+                   frame back and wait for a response to free one up.  If nothing is in flight
+                   then the frame can never be sent, so it's dropped rather than jamming the queue */
+                if( m_inFlightCount > 0 )
+                {
+                    m_txQueueHead = ( m_txQueueHead + XBEEAPI_CONFIG_TX_QUEUE_SIZE - 1U ) % XBEEAPI_CONFIG_TX_QUEUE_SIZE;
+                    m_txQueue[ m_txQueueHead ] = frame;
+                    m_txQueueCount++;
+                }
+                else
+                {
+                    dropped = true;
+                }
+                m_txPumping = false;
+                pumping = false;
+            }
+
+            if( dropped )
+            {
+                /* Let the owner know (e.g. so that a pooled frame can be freed) */
+                frame->frameTxDropped();
+            }
+        }
+    }
+}
+
+void XBeeDevice::setTxWindow( const size_t p_window )
+{
+    m_txWindow = p_window;
+
+    if( m_txWindow == 0 )
+    {
+        m_txWindow = 1;
+    }
+    else if( m_txWindow > XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT )
+    {
+        m_txWindow = XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+    }
+
+    /* Window may have opened up */
+    pumpTxQueue();
+}
+
+size_t XBeeDevice::getTxWindow( void ) const
+{
+    return m_txWindow;
+}
+
+size_t XBeeDevice::getTxQueueCount( void ) const
+{
+    return m_txQueueCount;
+}
+
+size_t XBeeDevice::getInFlightCount( void ) const
+{
+    return m_inFlightCount;
+}
+
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+size_t XBeeDevice::processRx( void )
+{
+    size_t ret_val = 0;
+
+    /* Nothing to do while in AT command mode - SendFrame() deals with the received data */
+    if( !m_inAtCmdMode )
+    {
+        ret_val = checkRxDecode();
+    }
+
+    pumpTxQueue();
+
+    return ret_val;
+}
+
+bool XBeeDevice::waitForRx( const uint32_t p_timeout_ms )
+{
+    return m_rxEvent.wait( p_timeout_ms );
+}
 #endif
 
-    xbeeWrite( XBEE_SB_FRAME_DELIMITER, false );
-    
-    len = p_cmd->getCmdLen();
-    xbeeWrite((uint8_t)(len >> 8U));
-    xbeeWrite((uint8_t)(len & 0xFF));
+size_t XBeeDevice::processPendingIo( void )
+{
+    const size_t decodedBefore = m_rxDecodedFrames;
 
-    sum += xbeeWrite((uint8_t)p_cmd->getApiId());
-    len--;
+    if( !m_rxAttached )
+    {
+        /* read() doesn't block, so there's no need to check for data beforehand */
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+        m_rxInline = true;
+        if_rx();
+        m_rxInline = false;
+#else
+        if_rx();
+#endif
+    }
 
-    /* While data still to go out */
-    while( written < len ) 
+#if defined XBEEAPI_CONFIG_POSIX
+    /* Clear the descriptor before doing the work it indicates, so that anything signalled
+       from here on leaves it readable */
     {
-        uint16_t buffer_len;     
-        
-        /* Get the next chunk of data from the frame object */
-        p_cmd->getDataPtr( written, &cmdData, &buffer_len );
+        size_t expected = 1U;
 
-        /* Write the buffer to the XBee */
-        for( i = 0;
-             i < buffer_len;
-             ++i,++written )
+        if( m_eventPending.compareExchange( expected, 0 ))
         {
-            sum += xbeeWrite(cmdData[i]);
+            uint64_t count;
+            if( read( m_eventFd, &count, sizeof( count )) < 0 )
+            {
+                /* Nothing to consume */
+            }
         }
     }
+#endif
+
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+    processRx();
+#endif
+
+    /* The TX queue isn't pumped from the receive path - see pumpTxQueue() */
+    pumpTxQueue();
+
+    return m_rxDecodedFrames - decodedBefore;
+}
+
+#if defined XBEEAPI_CONFIG_POSIX
+int XBeeDevice::getEventFd( void ) const
+{
+    return m_pollFd;
+}
+#endif
+
+bool XBeeDevice::pollRx( const uint32_t p_timeout_ms )
+{
+    const bool ret_val = m_if->waitReadable( p_timeout_ms );
+
+    if( ret_val )
+    {
+        if_rx();
+    }
+
+    return ret_val;
+}
+
+size_t XBeeDevice::getRxDroppedFrames( void ) const
+{
+    return m_rxDroppedFrames;
+}
+
+size_t XBeeDevice::getRxDroppedBytes( void ) const
+{
+    return m_rxDroppedBytes;
+}
+
+void XBeeDevice::writeFrame( XBeeApiFrame* const p_cmd )
+{
+    XBeeTxGather_t gather;
+    XBeeApiFrameSegment_t segs[ XBEE_API_FRAME_MAX_SEGMENTS ];
+    const size_t segCount = p_cmd->getSegments( segs );
+    const uint8_t delim = XBEE_SB_FRAME_DELIMITER;
+    const uint8_t apiId = (uint8_t)p_cmd->getApiId();
+    uint8_t sum = 0U;
+    uint8_t lenSum = 0U;
+    uint8_t lenBuff[ 2 ];
+    uint16_t len = 1U;
+
+    gather.m_segCount = 0;
+    gather.m_buffLen = 0;
+    gather.m_lastInBuff = false;
+    gather.m_locked = false;
+
+    for( size_t i = 0; i < segCount; i++ )
+    {
+        len += segs[ i ].m_len;
+    }
+
+    /* The frame is gathered into a list of segments, then written out in one go.  The 
+       interface mutex is only held while writing */
+    gatherCopy( &gather, &delim, 1U );
+
+    /* Length isn't included in the checksum */
+    lenBuff[ 0 ] = (uint8_t)(len >> 8U);
+    lenBuff[ 1 ] = (uint8_t)(len & 0xFF);
+    gatherTx( &gather, lenBuff, sizeof( lenBuff ), &lenSum );
+
+    gatherTx( &gather, &apiId, 1U, &sum );
+
+    for( size_t i = 0; i < segCount; i++ )
+    {
+        gatherTx( &gather, segs[ i ].m_data, segs[ i ].m_len, &sum );
+    }
      
-    /* Checksum is 0xFF - summation of bytes (excluding delimiter and length) */
-    xbeeWrite( (uint8_t)0xFFU - sum );
-    
-    fflush( *m_if );
+    /* Checksum is 0xFF - summation of bytes (excluding delimiter and length).  Note that
+       the summation is of the un-escaped data */
+    sum = (uint8_t)0xFFU - sum;
+    gatherTx( &gather, &sum, 1U, &lenSum );
+
+    flushTx( &gather );
 #if defined XBEE_DEBUG_DEVICE_DUMP_MESSAGE_DECODE
-    m_if.printf("\r\n");
+    m_if->write( (const uint8_t*)"\r\n", 2U );
 #endif
+    m_if->flush();
     
-#if defined  XBEEAPI_CONFIG_USING_RTOS
+#if defined XBEE_DEVICE_IF_MUTEX
     m_ifMutex.unlock();
 #endif
 }
 
-uint8_t XBeeDevice::xbeeWrite( uint8_t p_byte, bool p_doEscape )
+void XBeeDevice::gatherTx( XBeeTxGather_t* const p_gather, const uint8_t* p_data, size_t p_len, uint8_t* const p_sum )
 {
-    uint8_t c_sum = 0;
-    
-    if (p_doEscape && m_escape && 
-        ((p_byte == XBEE_SB_FRAME_DELIMITER ) ||
-         (p_byte == XBEE_SB_ESCAPE ) || 
-         (p_byte == XBEE_SB_XON ) || 
-         (p_byte == XBEE_SB_XOFF))) 
+    while( p_len > 0 )
     {
-#if defined XBEE_DEBUG_DEVICE_DUMP_MESSAGE_DECODE
-        m_if->printf("%02x ",XBEE_SB_ESCAPE);
-        m_if->printf("%02x ",p_byte ^ 0x20);
-#else
-        m_if->putc(XBEE_SB_ESCAPE);
-        m_if->putc(p_byte ^ 0x20);
+        size_t run;
+
+        if( m_escape )
+        {
+            run = xbeeApiEscapeRun( p_data, p_len, p_sum );
+        }
+        else
+        {
+            run = p_len;
+            *p_sum = xbeeApiChecksum( p_data, p_len, *p_sum );
+        }
+
+        /* Short runs are cheaper to copy than to write as a separate segment */
+        if( run >= XBEE_TX_MIN_SEGMENT_LEN )
+        {
+            if( p_gather->m_segCount == XBEEAPI_CONFIG_TX_SEGMENTS )
+            {
+                flushTx( p_gather );
+            }
+            p_gather->m_segs[ p_gather->m_segCount ].m_data = p_data;
+            p_gather->m_segs[ p_gather->m_segCount ].m_len = (uint16_t)run;
+            p_gather->m_segCount++;
+            p_gather->m_lastInBuff = false;
+        }
+        else if( run > 0 )
+        {
+            gatherCopy( p_gather, p_data, run );
+        }
+
+        p_data += run;
+        p_len -= run;
+
+        if( p_len > 0 )
+        {
+            /* Run was ended by a byte which needs escaping */
+            const uint8_t escaped[ 2 ] = { XBEE_SB_ESCAPE, (uint8_t)( *p_data ^ XBEE_SB_ESCAPE_XOR ) };
+
+            *p_sum += *p_data;
+            gatherCopy( p_gather, escaped, sizeof( escaped ));
+
+            p_data++;
+            p_len--;
+        }
+    }
+}
+
+void XBeeDevice::gatherCopy( XBeeTxGather_t* const p_gather, const uint8_t* const p_data, const size_t p_len )
+{
+    if((( p_gather->m_buffLen + p_len ) > sizeof( p_gather->m_buff )) ||
+       (( !p_gather->m_lastInBuff ) && ( p_gather->m_segCount == XBEEAPI_CONFIG_TX_SEGMENTS )))
+    {
+        flushTx( p_gather );
+    }
+
+    memcpy( &( p_gather->m_buff[ p_gather->m_buffLen ] ), p_data, p_len );
+
+    if( p_gather->m_lastInBuff )
+    {
+        p_gather->m_segs[ p_gather->m_segCount - 1U ].m_len += p_len;
+    }
+    else
+    {
+        p_gather->m_segs[ p_gather->m_segCount ].m_data = &( p_gather->m_buff[ p_gather->m_buffLen ] );
+        p_gather->m_segs[ p_gather->m_segCount ].m_len = p_len;
+        p_gather->m_segCount++;
+        p_gather->m_lastInBuff = true;
+    }
+    p_gather->m_buffLen += p_len;
+}
+
+void XBeeDevice::flushTx( XBeeTxGather_t* const p_gather )
+{
+    if( !p_gather->m_locked )
+    {
+#if defined XBEE_DEVICE_IF_MUTEX
+        m_ifMutex.lock();
 #endif
-        c_sum += XBEE_SB_ESCAPE;
-        c_sum += p_byte ^ 0x20;
-    } else {
+        p_gather->m_locked = true;
+    }
+
 #if defined XBEE_DEBUG_DEVICE_DUMP_MESSAGE_DECODE
-        m_if->printf("%02x ",p_byte);
+    for( size_t i = 0; i < p_gather->m_segCount; i++ )
+    {
+        for( size_t j = 0; j < p_gather->m_segs[ i ].m_len; j++ )
+        {
+            char hex[ 4 ];
+            snprintf( hex, sizeof( hex ), "%02x ", p_gather->m_segs[ i ].m_data[ j ] );
+            m_if->write( (const uint8_t*)hex, 3U );
+        }
+    }
 #else
-        m_if->putc(p_byte);
+    m_if->writeSegments( p_gather->m_segs, p_gather->m_segCount );
 #endif
-        c_sum += p_byte;
-    }
-    return c_sum;
+
+    p_gather->m_segCount = 0;
+    p_gather->m_buffLen = 0;
+    p_gather->m_lastInBuff = false;
 }
 
 #define IS_OK( _b ) (( _b[ 0 ] == 'O' ) && ( _b[ 1 ] == 'K' ) && ( _b[ 2 ] == '\r' ))
@@ -312,18 +1192,19 @@ XBeeDevice::XBeeDeviceReturn_t XBeeDevice::SendFrame( const char* const p_dat, s
 
     if( m_inAtCmdMode )
     {
-#if defined  XBEEAPI_CONFIG_USING_RTOS
+#if defined XBEE_DEVICE_IF_MUTEX
         m_ifMutex.lock();
 #endif
-        for( size_t i = 0;
-             i < p_len;
-             i++ ) {
-            m_if->putc(p_dat[i]);
-        }
-        
-        fflush( *m_if );
+        m_if->write( (const uint8_t*)p_dat, p_len );
+        m_if->flush();
                 
-        wait_ms( p_wait_ms );
+        xbeeApiWaitMs( p_wait_ms );
+
+        /* Pick up the response, if the transport doesn't deliver it as it arrives */
+        if( !m_rxAttached )
+        {
+            if_rx();
+        }
                 
         /* Check the response for the OK indicator */
         if( m_rxBuff.getSize() == OK_LEN )
@@ -344,7 +1225,7 @@ XBeeDevice::XBeeDeviceReturn_t XBeeDevice::SendFrame( const char* const p_dat, s
         {
             ret_val = XBEEDEVICE_UNEXPECTED_LENGTH;
         }
-#if defined  XBEEAPI_CONFIG_USING_RTOS
+#if defined XBEE_DEVICE_IF_MUTEX
         m_ifMutex.unlock();
 #endif
     } 
@@ -360,7 +1241,7 @@ XBeeDevice::XBeeDeviceReturn_t XBeeDevice::setUpApi( void )
     XBeeDeviceReturn_t ret_val;
     
     /* Wait for the guard period before transmitting command sequence */
-    wait_ms( XBEEAPI_CONFIG_GUARDPERIOD_MS );
+    xbeeApiWaitMs( XBEEAPI_CONFIG_GUARDPERIOD_MS );
     
     m_inAtCmdMode = true;
     
@@ -371,7 +1252,7 @@ XBeeDevice::XBeeDeviceReturn_t XBeeDevice::setUpApi( void )
     /* Everything OK with last request? */
     if( ret_val == XBEEDEVICE_OK )
     {
-        wait_ms( XBEEAPI_CONFIG_GUARDPERIOD_MS );
+        xbeeApiWaitMs( XBEEAPI_CONFIG_GUARDPERIOD_MS );
         
         /* API mode 2 please! */
         ret_val = SendFrame(api_mode2_cmd,sizeof(api_mode2_cmd));
@@ -389,7 +1270,7 @@ XBeeDevice::XBeeDeviceReturn_t XBeeDevice::setUpApi( void )
     return ret_val;
 }
 
-#if defined XBEEAPI_CONFIG_ENABLE_DEVELOPER
+#if defined XBEEAPI_CONFIG_ENABLE_DEVELOPER && !defined XBEEAPI_CONFIG_POSIX
 
 #define PRINTABLE_ASCII_FIRST 32U
 #define PRINTABLE_ASCII_LAST 126U
@@ -27,22 +27,55 @@ limitations under the License.
 
 #include "XBeeApiCfg.hpp"
 
+#if !defined XBEEAPI_CONFIG_POSIX
 #include "mbed.h" // For serial interface
-#if defined  XBEEAPI_CONFIG_USING_RTOS
+#endif
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+#include <mutex>
+#elif defined  XBEEAPI_CONFIG_USING_RTOS
 #include "rtos.h" // Mutex support
 #endif
 
-#include "FixedLengthList.hpp"
-#include "CircularBuffer.h"
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD || defined XBEEAPI_CONFIG_USING_RTOS
+/** Defined in the case that XBeeDevice::m_ifMutex is used to prevent frames written to
+    the XBee from different threads from being interleaved */
+#define XBEE_DEVICE_IF_MUTEX
+#endif
 
 #include "XBeeApiFrame.hpp"
+#include "XBeeApiByteRing.hpp"
+#include "XBeeApiTransport.hpp"
+#include "XBeeApiCriticalSection.hpp"
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+#include "XBeeApiEvent.hpp"
+#endif
+#if defined XBEEAPI_CONFIG_POSIX
+#include "XBeeApiAtomic.hpp"
+#endif
+
+/* Select the smallest type able to hold a bit for each of the decoders */
+#if XBEEAPI_CONFIG_DECODER_LIST_SIZE <= 8
+typedef uint8_t  XBeeDecoderMask_t;
+#elif XBEEAPI_CONFIG_DECODER_LIST_SIZE <= 16
+typedef uint16_t XBeeDecoderMask_t;
+#elif XBEEAPI_CONFIG_DECODER_LIST_SIZE <= 32
+typedef uint32_t XBeeDecoderMask_t;
+#else
+#error "XBEEAPI_CONFIG_DECODER_LIST_SIZE must be 32 or less"
+#endif
+
+#if ( XBEEAPI_CONFIG_TX_WINDOW < 1 ) || ( XBEEAPI_CONFIG_TX_WINDOW > XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT )
+#error "XBEEAPI_CONFIG_TX_WINDOW must be between 1 and XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT"
+#endif
 
 /** Class to represent an XBee device & provide an interface to communicate with it
 
     Actual communication is performed by:
     tx - using SendFrame to transmit messages to the XBee
     rx - registering one or more decoders (via registerDecoder) to be called when
-         a message is received */
+         a message is received.  Each frame is offered to every decoder registered 
+         for fan-out which is interested in it, followed by the other decoders in 
+         turn until one of them decodes it */
 class XBeeDevice
 {
    public:
@@ -59,7 +92,10 @@ class XBeeDevice
      /** Common class initialisation, shared between constructors */
      void init( void );
  
-#if defined  XBEEAPI_CONFIG_USING_RTOS
+#if defined XBEEAPI_CONFIG_USING_STD_THREAD
+     /** Mutex for accessing the serial interface */
+     std::mutex   m_ifMutex;
+#elif defined  XBEEAPI_CONFIG_USING_RTOS
      /** Mutex for accessing the serial interface */
      rtos::Mutex  m_ifMutex;
 #endif
@@ -72,39 +108,281 @@ class XBeeDevice
    
      /** Track whether or not the last byte received from the XBee was an escape (i.e. the 
      next incoming byte needs to be un-escaped) */
-     uint16_t m_rxMsgLastWasEsc;
+     bool m_rxMsgLastWasEsc;
+
+     /** States of the parser used to process the (un-escaped) data received from the XBee
+         into frames - see parseRx() */
+     typedef enum {
+         /** Waiting for a start delimiter */
+         XBEE_RX_STATE_DELIMITER,
+         /** Waiting for the high byte of the length field */
+         XBEE_RX_STATE_LEN_HI,
+         /** Waiting for the low byte of the length field */
+         XBEE_RX_STATE_LEN_LO,
+         /** Receiving the frame payload (API identifier & API-specific data) */
+         XBEE_RX_STATE_PAYLOAD,
+         /** Waiting for the checksum */
+         XBEE_RX_STATE_CHECKSUM,
+         /** Skipping over the remainder of a frame which is being discarded */
+         XBEE_RX_STATE_DISCARD
+     } XBeeRxState_t;
+
+     /** Current state of the receive parser */
+     XBeeRxState_t m_rxState;
+
+     /** Payload length of the frame currently being received */
+     uint16_t m_rxFrameLen;
+
+     /** Number of bytes of the frame currently being received which are still
+         awaited, excluding the checksum */
+     uint16_t m_rxFrameRemaining;
+
+     /** Running checksum of the frame currently being received */
+     uint8_t m_rxChecksum;
    
-     /** Serial interface for the XBee comms */
-     Serial* m_if;
+     /** Serial link to the XBee */
+     XBeeApiTransport* m_if;
      
-     /** Flag to indicate if the Serial object m_if was created by this class and
+     /** Flag to indicate if the transport m_if was created by this class and
          hence needs deleting in the destructor */
-     bool m_serialNeedsDelete;
+     bool m_transportNeedsDelete;
+
+     /** Flag to indicate whether m_if calls if_rx() when data is received (e.g. from the
+         serial RX interrupt), as opposed to it needing to be polled for via pollRx() */
+     bool m_rxAttached;
      
-     /** Call-back function from MBED triggered when data is
-         received on the XBee's serial interface */
+     /** Attach to the transport m_if, so that received data is handled */
+     void attachTransport( void );
+
+     /** Call-back function from the transport, triggered when data is received on the 
+         XBee's serial interface
+
+         \param p_ctx The XBeeDevice */
+     static void transportRx( void* const p_ctx );
+
+     /** Read & process data received from the XBee */
      void if_rx( void );
      
+     /** Un-escape data received from the XBee (if required - see m_escape) and pass it to
+         parseRx()
+
+         \param p_data Received data.  This is modified in-place by the un-escaping process
+         \param p_len Length of the data pointed to by p_data */
+     void unescapeRx( uint8_t* const p_data, const size_t p_len );
+
+     /** Process un-escaped data received from the XBee, building up frames in 
+         m_rxBuff.  State is maintained between calls so that data can be passed in
+         as it arrives - each byte is examined only once.  Frames are only made 
+         available to checkRxDecode() once they are complete and their checksum
+         has been verified.
+
+         \param p_data Received data
+         \param p_len Length of the data pointed to by p_data */
+     void parseRx( const uint8_t* p_data, size_t p_len );
+
+     /** Reset the receive parser, discarding any partially received frame */
+     void resetRx( void );
+
      /** Helper function to determine whether or not there's a message to decode and to
-         offer it round any registered decoders */
-     void checkRxDecode( void );
+         offer it round any registered decoders
 
-     /** Write a byte to the XBee serial interface, taking care of any
-         escaping requirements (see m_escape)
-         
-         @param p_byte Byte to be written 
-         @return Sum of the byte(s) written - to be addded to the checksum 
+         \returns The number of frames decoded */
+     size_t checkRxDecode( void );
+
+     /** Signal (see signalPending()) in the case that the TX window has room for a queued
+         frame, e.g. after a response or the release of a frame identifier.  The frame isn't 
+         transmitted from here, as this may be interrupt context - see pumpTxQueue() */
+     void signalIfTxReady( void );
+
+     /** Offer any complete frames in m_rxBuff to the registered decoders, removing them 
+         from the buffer.  Used by checkRxDecode() and (see canDecodeRx()) by parseRx() in 
+         order to make space for a frame which would otherwise not fit
+
+         \returns The number of frames removed from the buffer */
+     size_t decodeRx( void );
+
+     /** Offer a received frame to each of a set of fan-out decoders, sharing a single copy
+         of the frame between them
+
+         \param p_frame Received frame
+         \param p_decoders Decoders to offer the frame to.  Bit n corresponds to m_decoders[n] */
+     void fanOutRx( const XBeeApiFrameView& p_frame, XBeeDecoderMask_t p_decoders );
+
+     /** Determine whether or not received frames may be decoded from the context which 
+         is receiving them.  Always the case unless XBEEAPI_CONFIG_DEFERRED_DECODE is 
+         defined, in which case it's only so when the data's being read by 
+         processPendingIo() (see m_rxInline) */
+     bool canDecodeRx( void ) const;
+
+     /** A frame being assembled for transmission by writeFrame() */
+     typedef struct {
+         /** Pieces of data to be written to the transport, in order */
+         XBeeApiFrameSegment_t m_segs[ XBEEAPI_CONFIG_TX_SEGMENTS ];
+         /** Number of entries in m_segs in use */
+         size_t                m_segCount;
+         /** Data which can't be written from where it is (escaped bytes, etc) */
+         uint8_t               m_buff[ XBEEAPI_CONFIG_TX_BUFFER_SIZE ];
+         /** Number of bytes of m_buff in use */
+         size_t                m_buffLen;
+         /** Set in the case that the last entry of m_segs refers to the end of m_buff, 
+             meaning that data added to m_buff can be added to that segment */
+         bool                  m_lastInBuff;
+         /** Set once the serial interface has been locked for the frame */
+         bool                  m_locked;
+     } XBeeTxGather_t;
+
+     /** Add data to a frame being assembled for transmission, taking care of any escaping
+         requirements (see m_escape).  Runs of data which don't need escaping are
+         referenced rather than copied, meaning that the data must remain valid until
+         flushTx() has been called
+
+         @param p_gather Frame being assembled
+         @param p_data Data to be added
+         @param p_len Length of the data pointed to by p_data
+         @param p_sum Checksum, to which the (un-escaped) data is added
+     */
+     void gatherTx( XBeeTxGather_t* const p_gather, const uint8_t* p_data, size_t p_len, uint8_t* const p_sum );
+
+     /** Copy data into a frame being assembled for transmission.  No escaping is performed
+
+         @param p_gather Frame being assembled
+         @param p_data Data to be added
+         @param p_len Length of the data pointed to by p_data.  Must be no greater than
+                      XBEEAPI_CONFIG_TX_BUFFER_SIZE
      */
-     uint8_t xbeeWrite( uint8_t p_byte, bool p_doEscape = true );
+     void gatherCopy( XBeeTxGather_t* const p_gather, const uint8_t* const p_data, const size_t p_len );
+
+     /** Write the data gathered so far for a frame to the serial interface, locking the 
+         interface if not already done
+
+         @param p_gather Frame being assembled
+     */
+     void flushTx( XBeeTxGather_t* const p_gather );
+
 
      /** Flag to indicate whether or not the dataflow is currentl being escaped */
      bool m_escape;
      
-     /** Buffer of bytes received from the XBee so far */
-     CircularBuffer<XBEEAPI_CONFIG_RX_BUFFER_SIZE> m_rxBuff;
+     /** Buffer of bytes received from the XBee so far.  Received frames are
+         offered to the decoders in-place, without being copied out of this
+         buffer */
+     XBeeApiByteRing<XBEEAPI_CONFIG_RX_BUFFER_SIZE> m_rxBuff;
+
+     /** Number of frames received from the XBee which were lost due to there being 
+         insufficient space in m_rxBuff */
+     size_t m_rxDroppedFrames;
+
+     /** Number of bytes received from the XBee which were lost due to there being
+         insufficient space in m_rxBuff */
+     size_t m_rxDroppedBytes;
+
+     /** Number of frames removed from m_rxBuff by decodeRx().  Used by processPendingIo()
+         to determine how many frames were decoded */
+     size_t m_rxDecodedFrames;
+
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+     /** Set while processPendingIo() is reading data from the transport.  Received frames
+         can be decoded straight away as it's processPendingIo()'s caller which would 
+         otherwise be asked to decode them */
+     bool m_rxInline;
+#endif
+
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+     /** Signalled from the serial RX interrupt when there are frames for processRx() to 
+         decode or frames in the TX queue which can be transmitted */
+     XBeeApiEvent m_rxEvent;
+#endif
+
+#if defined XBEEAPI_CONFIG_POSIX
+     /** eventfd signalled when there is work for processPendingIo() which isn't indicated
+         by the transport's own descriptor */
+     int m_eventFd;
+
+     /** epoll instance waiting on m_eventFd and the transport's descriptor - see 
+         getEventFd() */
+     int m_pollFd;
+
+     /** Non-zero while m_eventFd has been signalled and not yet cleared, allowing 
+         signalPending() & processPendingIo() to avoid system calls which would have no 
+         effect */
+     XBeeApiAtomicIndex m_eventPending;
+
+     /** Create m_eventFd & m_pollFd */
+     void initEventFd( void );
+#endif
+
+     /** Indicate that there is work waiting for processPendingIo() (or processRx()) - 
+         received frames to decode or queued frames to transmit.  May be called from 
+         interrupt context */
+     void signalPending( void );
      
-     /** List of objects which are registered to de-code received frames */
-     FixedLengthList<XBeeApiFrameDecoder*, XBEEAPI_CONFIG_DECODER_LIST_SIZE> m_decoders;
+     /** Objects which are registered to de-code received frames.  Unused slots are NULL */
+     XBeeApiFrameDecoder* m_decoders[ XBEEAPI_CONFIG_DECODER_LIST_SIZE ];
+
+     /** Table, indexed by API identifier, indicating which decoders are interested in 
+         frames of that type.  Bit n of each entry corresponds to m_decoders[n] */
+     XBeeDecoderMask_t m_dispatch[ XBEE_API_ID_COUNT ];
+
+     /** Decoders which are registered for fan-out (see XBeeApiFrameDecoder::sharedFrameCallback()).
+         Bit n corresponds to m_decoders[n] */
+     XBeeDecoderMask_t m_fanOut;
+
+     /** Record of a frame identifier which has been allocated and is awaiting a response */
+     typedef struct {
+         /** Decoder to which the response should be routed.  NULL if the entry is unused */
+         XBeeApiFrameDecoder* m_owner;
+         /** The frame identifier */
+         uint8_t              m_frameId;
+     } XBeeFrameInFlight_t;
+
+     /** Table of frame identifiers currently awaiting a response */
+     XBeeFrameInFlight_t m_inFlight[ XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT ];
+
+     /** Next frame identifier to be considered for allocation */
+     uint8_t m_nextFrameId;
+
+     /** Number of entries in use in m_inFlight */
+     size_t m_inFlightCount;
+
+     /** Frames waiting to be transmitted by pumpTxQueue() */
+     XBeeApiFrame* m_txQueue[ XBEEAPI_CONFIG_TX_QUEUE_SIZE ];
+
+     /** Index within m_txQueue of the oldest frame */
+     size_t m_txQueueHead;
+
+     /** Number of frames in m_txQueue */
+     size_t m_txQueueCount;
+
+     /** Maximum number of frames which pumpTxQueue() allows to be in flight */
+     size_t m_txWindow;
+
+     /** Set while pumpTxQueue() is transmitting frames, to prevent re-entry from 
+         interrupt context */
+     bool m_txPumping;
+
+     /** Lock guarding the frame identifiers & TX queue against the context handling 
+         received data.  Each device has its own, so that devices serviced by different
+         threads don't contend */
+     XBeeApiCriticalSectionLock m_csLock;
+
+     /** Look for a frame identifier in m_inFlight
+
+         \param p_id Frame identifier to look for
+         \returns Index within m_inFlight or XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT in the
+                  case that the identifier is not in flight */
+     size_t findInFlight( const uint8_t p_id ) const;
+
+     /** Route a response frame to the decoder which owns the frame identifier it carries,
+         releasing the frame identifier in the process
+
+         \param p_frame Received frame
+         \returns true in the case that the frame was decoded by its owner */
+     bool routeResponse( const XBeeApiFrameView& p_frame );
+
+     /** Encode a frame and write it to the serial interface
+
+         \param p_cmd Frame to be transmitted */
+     void writeFrame( XBeeApiFrame* const p_cmd );
      
    public:
    
@@ -129,6 +407,7 @@ class XBeeDevice
          XBEE_API_ADDR_TYPE_64BIT = 1    
      } XBeeApiAddrType_t;
 
+#if !defined XBEEAPI_CONFIG_POSIX
      /** Constructor.  Parameters are used to specify the particulars of the connection to the XBee
      
          Objects using this constructor will default to be associated with an XBee S1 (see XBeeDeviceModel_t).  
@@ -151,6 +430,18 @@ class XBeeDevice
                            being used.  Must not be NULL.
      */
      XBeeDevice( Serial* p_serialIf );
+#endif
+
+     /** Constructor.  Parameters are used to specify the particulars of the connection to the XBee
+     
+         Objects using this constructor will default to be associated with an XBee S1 (see XBeeDeviceModel_t).  
+         This should be altered via setXBeeModel() if required
+     
+         @param p_transport Serial link to be used to communicate with the XBee (e.g. 
+                            XBeeApiTransportTermios).  The referenced object must remain valid 
+                            for as long as the XBeeDevice object is being used.  Must not be NULL.
+     */
+     XBeeDevice( XBeeApiTransport* p_transport );
 
      /** Destructor */
      virtual ~XBeeDevice( void );  
@@ -175,8 +466,145 @@ class XBeeDevice
          The method uses the XBeeApiFrame class methods to fill in the length, API ID & data.
      
          \param p_cmd Frame to be transmitted
+         \returns true in the case that the frame was transmitted, false in the case that it was not
+                  (e.g. the frame was unable to allocate a frame identifier)
      */
-     void SendFrame( XBeeApiFrame* const p_cmd );
+     bool SendFrame( XBeeApiFrame* const p_cmd );
+
+     /** Add a frame to the TX queue.  The method returns immediately and the frame is 
+         transmitted via SendFrame() as soon as the number of frames awaiting a response from 
+         the XBee is less than the TX window (see setTxWindow()).  This allows a number of 
+         frames to be outstanding at the XBee at once, rather than waiting for the status of 
+         each before sending the next.
+
+         Completion is signalled in the same way as for SendFrame() - e.g. via 
+         XBeeApiTxFrame::setTxCallback().
+
+         The frame must remain valid until it has been transmitted (or removed from the queue
+         via cancelFrame()) and should only be present in the queue once at any point in time.
+
+         \param p_cmd Frame to be transmitted
+         \returns true in the case that the frame was queued, false in the case that the
+                  queue is full */
+     bool queueFrame( XBeeApiFrame* const p_cmd );
+
+     /** Remove a frame from the TX queue without transmitting it
+
+         \param p_cmd Frame to be removed
+         \returns true in the case that the frame was found in the queue and removed */
+     bool cancelFrame( const XBeeApiFrame* const p_cmd );
+
+     /** Transmit frames from the TX queue until the queue is empty or the TX window is full.  
+         Called automatically when a frame is queued, by processPendingIo() and (with 
+         XBEEAPI_CONFIG_DEFERRED_DECODE) by processRx().  Frames are never transmitted from 
+         the context in which responses are received (the serial RX interrupt on mbed), as 
+         writing a frame blocks & the TX interface may be held by another thread.  Instead, 
+         a response which opens up the TX window signals that there's work to do (see 
+         waitForRx() and getEventFd()), so the application must call processPendingIo() (or 
+         this method) from a thread in order to keep the queue moving */
+     void pumpTxQueue( void );
+
+     /** Set the number of frames which the TX queue allows to be awaiting a response from
+         the XBee at any one time.  Larger windows give better throughput on links with a 
+         long round trip, at the cost of more frames needing to be re-sent in the case of 
+         errors.
+
+         \param p_window Window size.  Values of 0 or greater than 
+                         XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT will be clamped */
+     void setTxWindow( const size_t p_window );
+
+     /** Retrieve the TX window - see setTxWindow() */
+     size_t getTxWindow( void ) const;
+
+     /** Retrieve the number of frames in the TX queue which have not yet been transmitted */
+     size_t getTxQueueCount( void ) const;
+
+     /** Retrieve the number of frames which are awaiting a response from the XBee */
+     size_t getInFlightCount( void ) const;
+
+     /** Wait for data to be received from the XBee and process it.  Only needed in the case
+         that the transport is unable to signal received data itself (e.g. 
+         XBeeApiTransportTermios) - must not be used otherwise.  Must only be called from 
+         one context.
+
+         \param p_timeout_ms Maximum time to wait for data, in milliseconds.  0 to process
+                             any data already received without waiting
+         \returns true in the case that data was received */
+     bool pollRx( const uint32_t p_timeout_ms );
+
+#if defined XBEEAPI_CONFIG_DEFERRED_DECODE
+     /** Decode any frames which have been received from the XBee, offering them to the
+         registered decoders.  Decoder call-backs are invoked from the context which calls
+         this method rather than from the serial RX interrupt.  Must only be called from one
+         context, which should not be one which blocks waiting for a response from the 
+         XBee (e.g. via XBeeApiCmdAt) as it's this method which delivers the response.
+
+         Example:
+
+             for(;;)
+             {
+                 xbee.waitForRx( 100 );
+                 xbee.processRx();
+             }
+
+         \returns The number of frames decoded */
+     size_t processRx( void );
+
+     /** Wait for frames to be received from the XBee, ready for processRx()
+
+         \param p_timeout_ms Maximum time to wait, in milliseconds
+         \returns true in the case that frames were received, false in the case that the
+                  timeout expired */
+     bool waitForRx( const uint32_t p_timeout_ms );
+#endif
+
+     /** Perform any processing which is pending, without blocking:
+           - read & process data from a transport which needs to be polled (see pollRx())
+           - decode frames left for processRx() (XBEEAPI_CONFIG_DEFERRED_DECODE)
+           - transmit frames from the TX queue (see pumpTxQueue())
+
+         This allows the device to be driven from an application's own event loop rather
+         than from a thread dedicated to it - see getEventFd().  Decoder call-backs (and 
+         hence responses & completions) are invoked from the calling context.  Must only be
+         called from one context, which should not be one which blocks waiting for a 
+         response from the XBee (e.g. via XBeeApiCmdAtBlocking).
+
+         \returns The number of frames decoded */
+     size_t processPendingIo( void );
+
+#if defined XBEEAPI_CONFIG_POSIX
+     /** Retrieve a file descriptor which becomes readable when there is work for 
+         processPendingIo() to do - data received by the transport or frames awaiting 
+         decoding.  The descriptor may be added to epoll, poll(), select() or e.g. a libuv
+         uv_poll_t.  It remains readable until processPendingIo() has dealt with the work,
+         so may be waited on level-triggered.  The descriptor belongs to the device & must
+         not be closed or read.
+
+         Example:
+
+             struct epoll_event ev;
+             ev.events = EPOLLIN;
+             ev.data.ptr = &xbee;
+             epoll_ctl( loopFd, EPOLL_CTL_ADD, xbee.getEventFd(), &ev );
+
+             ...
+
+             // When the event for xbee is reported:
+             xbee.processPendingIo();
+
+         \returns The descriptor, or XBEE_TRANSPORT_FD_INVALID in the case that it 
+                  couldn't be created */
+     int getEventFd( void ) const;
+#endif
+
+     /** Retrieve the number of frames received from the XBee which have been lost due to
+         the receive buffer being full (see XBEEAPI_CONFIG_RX_BUFFER_SIZE).  Frames lost 
+         after being decoded (e.g. by an XBeeApiRxFrameCircularBuffer) are not included */
+     size_t getRxDroppedFrames( void ) const;
+
+     /** Retrieve the number of bytes received from the XBee which have been lost due to
+         the receive buffer being full.  Includes data received in AT command mode */
+     size_t getRxDroppedBytes( void ) const;
      
      /** Set the XBee up in API mode.  Note that this method needs to know something about the way in which the
          attached XBee is configured (namely the guard time).  This is configured via XBeeApiCmd.hpp, currently */
@@ -185,18 +613,53 @@ class XBeeDevice
      /** Register an object as being interested in decoding messages from the XBee.  Note that each
          decoder MUST only be registered with ONE XBeeDevice.
 
+         The decoder will only be offered frames whose API identifier is included in those passed
+         to its constructor (see XBeeApiFrameDecoder::getApiIds()).  A response to a frame sent with an allocated frame
+         identifier is given to the decoder which sent the frame.  Otherwise, where more than one decoder is interested
+         in a frame, they are offered it in turn until one of them decodes it.  Decoders registered for fan-out (see
+         XBeeApiFrameDecoder()) are first offered every frame they're interested in, responses included.
+
          \param p_decoder Decoder to be registered
          \returns true in the case that registration was successful, false otherwise (decoder list full, decoder already registered, etc) */
      bool registerDecoder( XBeeApiFrameDecoder* const p_decoder );
      
      /** Remove a previous registration for decoding of messages.  The decoder will be removed from
-         the list and no-longer called when XBee data is received
+         the list and no-longer called when XBee data is received.  Any frame identifiers allocated
+         to the decoder are released
          
          \param p_decoder Decoder to be unregistered
          \returns true in the case that unregistration was successful, false otherwise (decoder not in list) */
      bool unregisterDecoder( XBeeApiFrameDecoder* const p_decoder );
+
+     /** Allocate a frame identifier to be used in a frame sent to the XBee.  The identifier will
+         not be allocated again until it's released, either explicitly via releaseFrameId() or
+         implicitly when the XBee's response (AT command response, TX status, etc) is received.
+         Responses carrying the identifier are routed directly to p_owner, bypassing other decoders.
+
+         Identifier 0 (XBEE_FRAME_ID_NONE) is never allocated.
+
+         \param p_owner Decoder to which the response should be routed.  Does not need to be
+                        registered with this device
+         \returns The allocated frame identifier or XBEE_FRAME_ID_NONE in the case that 
+                  XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT identifiers are already in use */
+     uint8_t allocFrameId( XBeeApiFrameDecoder* const p_owner );
+
+     /** Release a frame identifier previously allocated via allocFrameId().  In the case
+         that this makes room in the TX window for a queued frame, the context calling 
+         processPendingIo() is signalled to transmit it
+
+         \param p_id Frame identifier to be released
+         \param p_owner Decoder to which the identifier was allocated
+         \returns true in the case that the identifier was released, false in the case that it 
+                  was not allocated to p_owner */
+     bool releaseFrameId( const uint8_t p_id, const XBeeApiFrameDecoder* const p_owner );
+
+     /** Release all frame identifiers allocated to a decoder
+
+         \param p_owner Decoder whose frame identifiers are to be released */
+     void releaseFrameIds( const XBeeApiFrameDecoder* const p_owner );
      
-#if defined XBEEAPI_CONFIG_ENABLE_DEVELOPER
+#if defined XBEEAPI_CONFIG_ENABLE_DEVELOPER && !defined XBEEAPI_CONFIG_POSIX
      void dumpRxBuffer( Stream* p_buf, const bool p_hexView );
 #endif
 
@@ -28,6 +28,20 @@ limitations under the License.
 /** Set the size of the RX buffer in the XBeeDevice */
 #define XBEEAPI_CONFIG_RX_BUFFER_SIZE 512
 
+/** Set the size of the buffer used to assemble frames for transmission to the XBee.  
+    The buffer holds the parts of the frame which are not written from where they are (see
+    XBEEAPI_CONFIG_TX_SEGMENTS) - the frame header, escaped bytes, checksum, etc.  Frames
+    which fit are written to the serial interface in a single operation.  Larger frames are
+    still supported, but are written in multiple chunks.  The buffer is allocated on the
+    stack of the caller of XBeeDevice::SendFrame() */
+#define XBEEAPI_CONFIG_TX_BUFFER_SIZE 256
+
+#if 0
+/** Disable the use of SIMD instructions (e.g. SSE2 on x86 hosts) when escaping and 
+    un-escaping data.  Word-at-a-time processing will be used instead */
+#define XBEEAPI_CONFIG_DISABLE_SIMD
+#endif
+
 /** Enable developer options */
 #define XBEEAPI_CONFIG_ENABLE_DEVELOPER
 
@@ -36,6 +50,46 @@ limitations under the License.
     memory */
 #define XBEEAPI_CONFIG_DECODER_LIST_SIZE 10
 
+/** Maximum number of frames which can be awaiting a response from the XBee at any one
+    time (e.g. TX frames awaiting a TX status).  Each entry uses a small amount of memory */
+#define XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT 16
+
+/** Maximum number of frames which can be held in the XBeeDevice's TX queue (see 
+    XBeeDevice::queueFrame()) */
+#define XBEEAPI_CONFIG_TX_QUEUE_SIZE 16
+
+/** Default number of frames which the TX queue will allow to be awaiting a response 
+    from the XBee at any one time.  Can be changed at run-time via XBeeDevice::setTxWindow().  
+    Must be no greater than XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT */
+#define XBEEAPI_CONFIG_TX_WINDOW 4
+
+/** Number of blocks in the pool used to hold the payload of received frames which are
+    stored beyond the life of the receive callback (see XBeeApiRxFrame::deepCopyFrom()).
+    The pool is shared by all such frames, so should be at least the total number of frames
+    which can be stored at any one time */
+#define XBEEAPI_CONFIG_RX_POOL_BLOCKS 8
+
+/** Size of each block in the received frame payload pool, in bytes.  Must be at least 
+    XBEE_API_MAX_RX_PAYLOAD_LEN */
+#define XBEEAPI_CONFIG_RX_POOL_BLOCK_SIZE 100
+
+/** Number of frames in the pool used by XBeeApiTxFramePooled.  Each frame holds a copy of
+    its payload (XBEE_API_MAX_TX_PAYLOAD_LEN bytes) and remains allocated until its TX
+    status is received, so there's no benefit in having more frames than 
+    XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT */
+#define XBEEAPI_CONFIG_TX_POOL_FRAMES 8
+
+/** Number of frames in the pool used to share received frames between decoders registered
+    for fan-out (see XBeeApiSharedFrame).  A frame remains allocated for as long as any 
+    decoder holds a reference to it.  In the case that the pool is exhausted the decoders 
+    are offered the frame in-place instead, without being able to keep it */
+#define XBEEAPI_CONFIG_SHARED_FRAMES 4
+
+/** Size of each frame in the shared frame pool, in bytes.  This covers the whole frame, from
+    the delimiter to the checksum - a 64-bit addressed RX frame with a full 
+    (XBEE_API_MAX_RX_PAYLOAD_LEN) payload is 115 bytes */
+#define XBEEAPI_CONFIG_SHARED_FRAME_SIZE 120
+
 /** Guard period for sending "+++" commands - see XBee documentation */
 #define XBEEAPI_CONFIG_GUARDPERIOD_MS 1000
 
@@ -44,6 +98,60 @@ limitations under the License.
 #define  XBEEAPI_CONFIG_USING_RTOS
 #endif
 
+#if 0
+/** Use the C++11 standard library (std::condition_variable, etc) rather than mbed/RTOS 
+    features when waiting for events.  Intended for builds targetting a host OS */
+#define XBEEAPI_CONFIG_USING_STD_THREAD
+#endif
+
+#if 0
+/** Build for a POSIX host (e.g. a Linux gateway) rather than mbed.  mbed headers are not
+    used, the XBee is accessed via XBeeApiTransportTermios and critical sections are 
+    implemented using a mutex.  Requires XBEEAPI_CONFIG_USING_STD_THREAD */
+#define XBEEAPI_CONFIG_POSIX
+#endif
+
+/** Set the number of bytes read from the XBee's serial interface in one go.  The buffer is
+    allocated on the stack of the context handling received data (the serial RX interrupt
+    on mbed).  Hosts benefit from a larger value, as each read is a system call */
+#if defined XBEEAPI_CONFIG_POSIX
+#define XBEEAPI_CONFIG_RX_CHUNK_SIZE 1024
+#else
+#define XBEEAPI_CONFIG_RX_CHUNK_SIZE 32
+#endif
+
+/** Maximum number of separate pieces of data which XBeeDevice passes to the transport in
+    a single write when transmitting a frame (see XBeeApiTransport::writeSegments()).  Runs
+    of frame payload which don't need escaping are written from where they are rather than
+    being copied into the TX buffer (see XBEEAPI_CONFIG_TX_BUFFER_SIZE), each one using a 
+    segment.  Allocated on the stack alongside the TX buffer */
+#if defined XBEEAPI_CONFIG_POSIX
+#define XBEEAPI_CONFIG_TX_SEGMENTS 16
+#else
+#define XBEEAPI_CONFIG_TX_SEGMENTS 4
+#endif
+
+/** Maximum number of XBeeDevice objects which an XBeeApiGateway can drive (POSIX only) */
+#define XBEEAPI_CONFIG_GATEWAY_MAX_DEVICES 16
+
+/** Maximum number of worker threads which an XBeeApiGateway can use (POSIX only) */
+#define XBEEAPI_CONFIG_GATEWAY_MAX_WORKERS 16
+
+#if 0
+/** Decode received frames outside of interrupt context.  The serial RX interrupt only
+    captures & un-escapes the data, leaving the decoding (and with it, all decoder 
+    call-backs) to XBeeDevice::processRx(), which the application must call from a thread
+    or its main loop - see XBeeDevice::waitForRx() */
+#define XBEEAPI_CONFIG_DEFERRED_DECODE
+#endif
+
+#if 0
+/** Enable run-time consistency checks which are too costly to leave in a release build.
+    Currently XBeeApiBlockPool::free() walks the free list to refuse a block which has 
+    already been freed, rather than corrupting the pool by adding it to the list twice */
+#define XBEEAPI_CONFIG_DEBUG
+#endif
+
 #if 0
 #define XBEE_DEBUG_DEVICE_DUMP_MESSAGE_DECODE
 #endif
@@ -0,0 +1,303 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiGateway.hpp"
+
+#if defined XBEEAPI_CONFIG_POSIX
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+/** Maximum number of events retrieved from epoll in one go */
+#define XBEE_GATEWAY_MAX_EVENTS (16U)
+
+XBeeApiGateway::XBeeApiGateway( const size_t p_workers ) : m_deviceCount( 0 ),
+                                                           m_workerCount( p_workers ),
+                                                           m_pinWorkers( false ),
+                                                           m_running( false ),
+                                                           m_open( true ),
+                                                           m_hangUpCallback( NULL ),
+                                                           m_hangUpCtx( NULL )
+{
+    if( m_workerCount < 1U )
+    {
+        m_workerCount = 1U;
+    }
+    else if( m_workerCount > XBEEAPI_CONFIG_GATEWAY_MAX_WORKERS )
+    {
+        m_workerCount = XBEEAPI_CONFIG_GATEWAY_MAX_WORKERS;
+    }
+
+    for( size_t i = 0; i < m_workerCount; i++ )
+    {
+        struct epoll_event ev;
+
+        m_workers[ i ].m_epollFd = epoll_create1( EPOLL_CLOEXEC );
+        m_workers[ i ].m_wakeFd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+        m_workers[ i ].m_deviceCount = 0;
+
+        /* The wake-up descriptor is distinguished from devices by having no data */
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+
+        if(( m_workers[ i ].m_epollFd < 0 ) ||
+           ( m_workers[ i ].m_wakeFd < 0 ) ||
+           ( epoll_ctl( m_workers[ i ].m_epollFd, EPOLL_CTL_ADD, m_workers[ i ].m_wakeFd, &ev ) != 0 ))
+        {
+            m_open = false;
+        }
+    }
+}
+
+XBeeApiGateway::~XBeeApiGateway( void )
+{
+    stop();
+
+    for( size_t i = 0; i < m_workerCount; i++ )
+    {
+        if( m_workers[ i ].m_epollFd >= 0 )
+        {
+            close( m_workers[ i ].m_epollFd );
+        }
+        if( m_workers[ i ].m_wakeFd >= 0 )
+        {
+            close( m_workers[ i ].m_wakeFd );
+        }
+    }
+}
+
+bool XBeeApiGateway::addDevice( XBeeDevice* const p_device, XBeeApiTransportTermios* const p_transport )
+{
+    size_t worker = 0;
+
+    /* Spread the devices evenly across the workers */
+    for( size_t i = 1; i < m_workerCount; i++ )
+    {
+        if( m_workers[ i ].m_deviceCount < m_workers[ worker ].m_deviceCount )
+        {
+            worker = i;
+        }
+    }
+
+    return addDevice( p_device, p_transport, worker );
+}
+
+bool XBeeApiGateway::addDevice( XBeeDevice* const p_device, XBeeApiTransportTermios* const p_transport, const size_t p_worker )
+{
+    bool ret_val = false;
+
+    if(( m_open ) &&
+       ( m_deviceCount < XBEEAPI_CONFIG_GATEWAY_MAX_DEVICES ) &&
+       ( p_worker < m_workerCount ) &&
+       ( p_transport->isOpen() ) &&
+       ( getWorker( p_device ) == XBEE_GATEWAY_WORKER_NONE ))
+    {
+        XBeeApiGatewayDevice_t* const dev = &( m_devices[ m_deviceCount ] );
+        struct epoll_event ev;
+
+        dev->m_device = p_device;
+        dev->m_transport = p_transport;
+        dev->m_worker = p_worker;
+        dev->m_hungUp = false;
+
+        ev.data.ptr = dev;
+
+        /* The device's event descriptor covers both received data & work signalled from
+           other threads (deferred decoding, frames queued for transmission).  The transport's
+           own descriptor is only watched for hang-ups & errors, which epoll always reports */
+        ev.events = EPOLLIN;
+        if( epoll_ctl( m_workers[ p_worker ].m_epollFd, EPOLL_CTL_ADD, p_device->getEventFd(), &ev ) == 0 )
+        {
+            ev.events = 0;
+            if( epoll_ctl( m_workers[ p_worker ].m_epollFd, EPOLL_CTL_ADD, p_transport->getFd(), &ev ) == 0 )
+            {
+                m_workers[ p_worker ].m_deviceCount++;
+                m_deviceCount++;
+                ret_val = true;
+            }
+            else
+            {
+                epoll_ctl( m_workers[ p_worker ].m_epollFd, EPOLL_CTL_DEL, p_device->getEventFd(), NULL );
+            }
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiGateway::isOpen( void ) const
+{
+    return m_open;
+}
+
+size_t XBeeApiGateway::getDeviceCount( void ) const
+{
+    return m_deviceCount;
+}
+
+size_t XBeeApiGateway::getWorkerCount( void ) const
+{
+    return m_workerCount;
+}
+
+size_t XBeeApiGateway::getWorker( const XBeeDevice* const p_device ) const
+{
+    size_t ret_val = XBEE_GATEWAY_WORKER_NONE;
+
+    for( size_t i = 0; i < m_deviceCount; i++ )
+    {
+        if( m_devices[ i ].m_device == p_device )
+        {
+            ret_val = m_devices[ i ].m_worker;
+            break;
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiGateway::isHungUp( const XBeeDevice* const p_device ) const
+{
+    bool ret_val = false;
+
+    for( size_t i = 0; i < m_deviceCount; i++ )
+    {
+        if( m_devices[ i ].m_device == p_device )
+        {
+            ret_val = m_devices[ i ].m_hungUp;
+            break;
+        }
+    }
+
+    return ret_val;
+}
+
+void XBeeApiGateway::setHangUpCallback( const XBeeApiGatewayHangUpCallback_t p_callback, void* const p_ctx )
+{
+    m_hangUpCallback = p_callback;
+    m_hangUpCtx = p_ctx;
+}
+
+void XBeeApiGateway::setPinWorkers( const bool p_pin )
+{
+    m_pinWorkers = p_pin;
+}
+
+bool XBeeApiGateway::start( void )
+{
+    bool ret_val = false;
+
+    if(( m_open ) &&
+       ( !m_running ))
+    {
+        m_running = true;
+
+        for( size_t i = 0; i < m_workerCount; i++ )
+        {
+            m_workers[ i ].m_thread = std::thread( &XBeeApiGateway::runWorker, this, i );
+
+            if( m_pinWorkers )
+            {
+                const unsigned cpus = std::thread::hardware_concurrency();
+                cpu_set_t set;
+
+                CPU_ZERO( &set );
+                CPU_SET( ( cpus > 0 ) ? ( i % cpus ) : 0, &set );
+                pthread_setaffinity_np( m_workers[ i ].m_thread.native_handle(), sizeof( set ), &set );
+            }
+        }
+        ret_val = true;
+    }
+
+    return ret_val;
+}
+
+void XBeeApiGateway::stop( void )
+{
+    if( m_running )
+    {
+        const uint64_t wake = 1U;
+
+        m_running = false;
+
+        for( size_t i = 0; i < m_workerCount; i++ )
+        {
+            if( write( m_workers[ i ].m_wakeFd, &wake, sizeof( wake )) < 0 )
+            {
+                /* Counter can only be full if the worker's already been woken */
+            }
+            m_workers[ i ].m_thread.join();
+        }
+    }
+}
+
+void XBeeApiGateway::hangUp( XBeeApiGatewayWorker_t* const p_worker, XBeeApiGatewayDevice_t* const p_dev )
+{
+    /* epoll keeps reporting a hang-up for as long as the descriptor is registered (and
+       the device's event descriptor, which includes it, stays readable), so the worker 
+       would otherwise spin */
+    epoll_ctl( p_worker->m_epollFd, EPOLL_CTL_DEL, p_dev->m_transport->getFd(), NULL );
+    epoll_ctl( p_worker->m_epollFd, EPOLL_CTL_DEL, p_dev->m_device->getEventFd(), NULL );
+    p_dev->m_hungUp = true;
+
+    if( m_hangUpCallback != NULL )
+    {
+        m_hangUpCallback( this, p_dev->m_device, m_hangUpCtx );
+    }
+}
+
+void XBeeApiGateway::runWorker( const size_t p_worker )
+{
+    XBeeApiGatewayWorker_t* const worker = &( m_workers[ p_worker ] );
+    struct epoll_event events[ XBEE_GATEWAY_MAX_EVENTS ];
+
+    while( m_running )
+    {
+        const int count = epoll_wait( worker->m_epollFd, events, XBEE_GATEWAY_MAX_EVENTS, -1 );
+
+        for( int i = 0; i < count; i++ )
+        {
+            XBeeApiGatewayDevice_t* const dev = (XBeeApiGatewayDevice_t*)events[ i ].data.ptr;
+
+            if( dev == NULL )
+            {
+                uint64_t wake;
+                if( read( worker->m_wakeFd, &wake, sizeof( wake )) < 0 )
+                {
+                    /* Nothing to consume - someone else already did */
+                }
+            }
+            else if( !dev->m_hungUp )
+            {
+                /* Deal with anything received before the hang-up first */
+                dev->m_device->processPendingIo();
+
+                if( events[ i ].events & ( EPOLLHUP | EPOLLERR ))
+                {
+                    hangUp( worker, dev );
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,225 @@
+/**
+   @file
+   @brief Class to drive a number of XBee devices from a pool of worker threads,
+          using epoll to wait for received data
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIGATEWAY_HPP
+#define      XBEEAPIGATEWAY_HPP
+
+#include "XBeeApiCfg.hpp"
+
+#if defined XBEEAPI_CONFIG_POSIX
+
+#include "XBeeDevice.hpp"
+#include "XBeeApiTransportTermios.hpp"
+
+#include <atomic>
+#include <thread>
+
+/** Value returned by XBeeApiGateway::getWorker() for a device which isn't part of the
+    gateway */
+#define XBEE_GATEWAY_WORKER_NONE ((size_t)-1)
+
+/** Class to drive a number of XBeeDevice objects (e.g. the radios attached to a 
+    concentrator), each using an XBeeApiTransportTermios, from a pool of worker threads.
+
+    Each device is serviced by exactly one worker, which waits on the devices assigned to
+    it using epoll (see XBeeDevice::getEventFd()) and processes their received data and 
+    queued work (see XBeeDevice::processPendingIo()) as it arrives.  Decoder call-backs for a device are therefore always invoked from the same
+    thread, while devices assigned to different workers are processed in parallel.
+
+    In the case that a device's descriptor hangs up or reports an error (e.g. a USB adapter
+    being unplugged) the worker stops waiting on it & reports it - see setHangUpCallback()
+    and isHungUp().
+
+    Example:
+
+        XBeeApiTransportTermios t0( "/dev/ttyUSB0", 115200 );
+        XBeeApiTransportTermios t1( "/dev/ttyUSB1", 115200 );
+        XBeeDevice xbee0( &t0 );
+        XBeeDevice xbee1( &t1 );
+        XBeeApiGateway gateway( 2 );
+
+        gateway.addDevice( &xbee0, &t0 );
+        gateway.addDevice( &xbee1, &t1 );
+        gateway.start();
+*/
+class XBeeApiGateway
+{
+    public:
+        /** Type of function which can be called when a device's descriptor hangs up or
+            reports an error.  Called from the worker servicing the device
+
+            \param p_gateway The gateway
+            \param p_device The device which has hung up
+            \param p_ctx Context pointer, as passed to setHangUpCallback() */
+        typedef void (*XBeeApiGatewayHangUpCallback_t)( XBeeApiGateway* const p_gateway,
+                                                       XBeeDevice* const p_device,
+                                                       void* const p_ctx );
+
+    protected:
+        /** A device driven by the gateway */
+        typedef struct
+        {
+            /** The device */
+            XBeeDevice*              m_device;
+            /** The transport used by the device */
+            XBeeApiTransportTermios* m_transport;
+            /** Index of the worker servicing the device */
+            size_t                   m_worker;
+            /** Set once the device's descriptor has hung up & is no longer being waited on */
+            std::atomic<bool>        m_hungUp;
+        } XBeeApiGatewayDevice_t;
+
+        /** A worker thread */
+        typedef struct
+        {
+            /** epoll instance on which the worker waits */
+            int         m_epollFd;
+            /** eventfd used to wake the worker, e.g. to stop it */
+            int         m_wakeFd;
+            /** Number of devices assigned to the worker */
+            size_t      m_deviceCount;
+            /** The thread */
+            std::thread m_thread;
+        } XBeeApiGatewayWorker_t;
+
+        /** Devices driven by the gateway */
+        XBeeApiGatewayDevice_t m_devices[ XBEEAPI_CONFIG_GATEWAY_MAX_DEVICES ];
+
+        /** Number of entries in m_devices in use */
+        size_t                 m_deviceCount;
+
+        /** Worker threads */
+        XBeeApiGatewayWorker_t m_workers[ XBEEAPI_CONFIG_GATEWAY_MAX_WORKERS ];
+
+        /** Number of entries in m_workers in use */
+        size_t                 m_workerCount;
+
+        /** Whether or not each worker should be pinned to a CPU */
+        bool                   m_pinWorkers;
+
+        /** Set while the workers are running */
+        std::atomic<bool>      m_running;
+
+        /** Set in the case that the descriptors used by every worker were created */
+        bool                   m_open;
+
+        /** Function to call when a device hangs up */
+        XBeeApiGatewayHangUpCallback_t m_hangUpCallback;
+
+        /** Context pointer to pass to m_hangUpCallback */
+        void*                  m_hangUpCtx;
+
+        /** Stop waiting on a device whose descriptor has hung up, and report it
+
+            \param p_worker The worker servicing the device
+            \param p_dev The device */
+        void hangUp( XBeeApiGatewayWorker_t* const p_worker, XBeeApiGatewayDevice_t* const p_dev );
+
+        /** Body of each worker thread
+
+            \param p_worker Index of the worker */
+        void runWorker( const size_t p_worker );
+
+    public:
+        /** Constructor
+
+            \param p_workers Number of worker threads.  Limited to between 1 and 
+                             XBEEAPI_CONFIG_GATEWAY_MAX_WORKERS */
+        XBeeApiGateway( const size_t p_workers = 1U );
+
+        /** Destructor.  Stops the workers */
+        virtual ~XBeeApiGateway( void );
+
+        /** Add a device to the gateway, to be serviced by the worker with the fewest devices.
+            Devices may be added before or after the workers are started
+
+            \param p_device The device
+            \param p_transport The transport used by p_device
+            \returns true in the case that the device was added, false in the case that the
+                     gateway is full or either the gateway or the transport isn't open */
+        bool addDevice( XBeeDevice* const p_device, XBeeApiTransportTermios* const p_transport );
+
+        /** Add a device to the gateway, to be serviced by a specific worker
+
+            \param p_device The device
+            \param p_transport The transport used by p_device
+            \param p_worker Index of the worker to service the device
+            \returns true in the case that the device was added */
+        bool addDevice( XBeeDevice* const p_device, XBeeApiTransportTermios* const p_transport, const size_t p_worker );
+
+        /** Determine whether or not the gateway was successfully created.  In the case that
+            the descriptors used by the workers couldn't be created, devices can't be added
+            & the workers can't be started
+
+            \returns true in the case that the gateway is usable */
+        bool isOpen( void ) const;
+
+        /** Retrieve the number of devices driven by the gateway */
+        size_t getDeviceCount( void ) const;
+
+        /** Retrieve the number of worker threads */
+        size_t getWorkerCount( void ) const;
+
+        /** Determine which worker services a device
+
+            \param p_device The device
+            \returns Index of the worker, or XBEE_GATEWAY_WORKER_NONE in the case that the
+                     device isn't part of the gateway */
+        size_t getWorker( const XBeeDevice* const p_device ) const;
+
+        /** Determine whether or not a device's descriptor has hung up.  A device which has
+            hung up is no longer serviced, even if the workers are re-started
+
+            \param p_device The device
+            \returns true in the case that the device has hung up */
+        bool isHungUp( const XBeeDevice* const p_device ) const;
+
+        /** Set a function to be called when a device's descriptor hangs up or reports an
+            error.  Should be set before calling start()
+
+            \param p_callback Function to call, or NULL to remove a previously set function
+            \param p_ctx Context pointer to be passed to p_callback */
+        void setHangUpCallback( const XBeeApiGatewayHangUpCallback_t p_callback, void* const p_ctx = NULL );
+
+        /** Set whether or not each worker thread should be pinned to a CPU (worker n runs on
+            CPU n, modulo the number of CPUs).  Must be set before calling start()
+
+            \param p_pin true to pin the workers */
+        void setPinWorkers( const bool p_pin );
+
+        /** Start the worker threads
+
+            \returns true in the case that the workers were started, false in the case that
+                     they're already running or the gateway isn't open */
+        bool start( void );
+
+        /** Stop the worker threads, waiting for them to finish.  Devices remain part of the
+            gateway & are serviced again if start() is called */
+        void stop( void );
+};
+
+#endif
+
+#endif
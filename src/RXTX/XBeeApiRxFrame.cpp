@@ -18,46 +18,120 @@ limitations under the License.
 
 #include "XBeeApiRxFrame.hpp"
 
+#include <string.h>
+
+#if XBEEAPI_CONFIG_RX_POOL_BLOCK_SIZE < XBEE_API_MAX_RX_PAYLOAD_LEN
+#error "XBEEAPI_CONFIG_RX_POOL_BLOCK_SIZE must be at least XBEE_API_MAX_RX_PAYLOAD_LEN"
+#endif
+
+/** Storage for the blocks in XBeeApiRxFrame::s_pool */
+static void* rx_pool_storage[ XBEE_API_BLOCK_POOL_STORAGE_WORDS( XBEEAPI_CONFIG_RX_POOL_BLOCK_SIZE,
+                                                                 XBEEAPI_CONFIG_RX_POOL_BLOCKS ) ];
+
+XBeeApiBlockPool XBeeApiRxFrame::s_pool( rx_pool_storage, XBEEAPI_CONFIG_RX_POOL_BLOCK_SIZE, XBEEAPI_CONFIG_RX_POOL_BLOCKS );
+
 XBeeApiRxFrame::XBeeApiRxFrame( void ) : XBeeApiFrame(),
-					 m_dataIsMallocd ( false )
+                                         m_poolData( NULL ),
+                                         m_shared( NULL )
 {
 }
 
-	/** Constructor */
+/** Constructor */
 XBeeApiRxFrame::XBeeApiRxFrame( XBeeApiIdentifier_e p_id,
                                 const uint8_t* const p_data,
                                 const size_t         p_dataLen ) : XBeeApiFrame( p_id, p_data, p_dataLen ),
-							           m_dataIsMallocd ( false )
+                                                                   m_poolData( NULL ),
+                                                                   m_shared( NULL )
 {
 }
 
 XBeeApiRxFrame::~XBeeApiRxFrame( void )
 {
-    if( m_dataIsMallocd )
+    releaseData();
+}
+
+void XBeeApiRxFrame::releaseData( void )
+{
+    if( m_poolData != NULL )
+    {
+        s_pool.free( m_poolData );
+        m_poolData = NULL;
+    }
+    if( m_shared != NULL )
     {
-        free( m_mallocdData );
+        m_shared->release();
+        m_shared = NULL;
     }
+    m_data = NULL;
+    m_dataLen = 0;
 }
-        
+
 bool XBeeApiRxFrame::deepCopyFrom( const XBeeApiRxFrame& p_frame )
 {
-    /* TODO: need to catch assignment operator and free data if data is already malloc'd */
-    if( m_dataIsMallocd )
+    /* Hang on to any block we already have - the assignment would otherwise
+       overwrite it with that of p_frame */
+    uint8_t* block = m_poolData;
+    XBeeApiSharedFrame* const shared = m_shared;
+    XBeeApiSharedFrame* const srcShared = p_frame.m_shared;
+
+    *this = p_frame;
+    m_poolData = NULL;
+    m_shared = NULL;
+
+    if( srcShared != NULL )
     {
-        free( m_mallocdData );
-	m_dataIsMallocd = false;
+        /* The payload is already held somewhere which will stay put for as long as
+           there's a reference to it, so there's no need for a copy */
+        setSharedFrame( srcShared );
+        s_pool.free( block );
+        block = NULL;
     }
-    *this = p_frame;
-    m_mallocdData = (uint8_t*)malloc( p_frame.m_dataLen );
-    if( m_mallocdData )
+    else if(( block == NULL ) &&
+       ( p_frame.m_dataLen <= s_pool.getBlockSize() ))
+    {
+        block = (uint8_t*)s_pool.alloc();
+    }
+
+    if(( block != NULL ) &&
+       ( p_frame.m_dataLen <= s_pool.getBlockSize() ))
     {
-    	m_dataIsMallocd = true;
-        memcpy( m_mallocdData, p_frame.m_data, m_dataLen );
-	m_data = m_mallocdData;
+        m_poolData = block;
+        memcpy( m_poolData, p_frame.m_data, m_dataLen );
+        m_data = m_poolData;
     }
-    else
+    else if( m_shared == NULL )
     {
+        s_pool.free( block );
         m_data = NULL;
+        m_dataLen = 0;
     }
-    return( m_mallocdData != NULL );
+
+    /* Only given up after the new reference has been taken, in case it's the same frame */
+    if( shared != NULL )
+    {
+        shared->release();
+    }
+
+    return(( m_poolData != NULL ) || ( m_shared != NULL ));
+}
+
+void XBeeApiRxFrame::setSharedFrame( XBeeApiSharedFrame* const p_shared )
+{
+    p_shared->acquire();
+
+    if( m_shared != NULL )
+    {
+        m_shared->release();
+    }
+    m_shared = p_shared;
+}
+
+XBeeApiSharedFrame* XBeeApiRxFrame::getSharedFrame( void ) const
+{
+    return m_shared;
+}
+
+const XBeeApiBlockPool& XBeeApiRxFrame::getPool( void )
+{
+    return s_pool;
 }
@@ -27,9 +27,14 @@ limitations under the License.
 
 #include "XBeeApiFrame.hpp"
 #include "XBeeDevice.hpp"
+#include "XBeeApiBlockPool.hpp"
+#include "XBeeApiSharedFrame.hpp"
 
 #include <stdint.h>
 
+/** Maximum length of the payload of a received data frame */
+#define XBEE_API_MAX_RX_PAYLOAD_LEN 100U
+
 /** Class to represent a frame of data being received by the XBee.
 
     The message data content is accessed via the inherited m_data 
@@ -53,12 +58,17 @@ class XBeeApiRxFrame : public XBeeApiFrame
         
         /** Indicate whether or not the message was PAN broadcase */
         bool m_panBroadcast;
-   
-	/* TODO: doc */
-       	bool m_dataIsMallocd;	
 
-	/* TODO: doc */
-       	uint8_t* m_mallocdData;	
+        /** Block from the payload pool holding a copy of the payload (see deepCopyFrom()),
+            or NULL in the case that m_data refers to memory not owned by this frame */
+        uint8_t* m_poolData;
+
+        /** Shared frame which m_data points into & to which this frame holds a reference
+            (see setSharedFrame()), or NULL */
+        XBeeApiSharedFrame* m_shared;
+
+        /** Pool used to hold copies of frame payloads */
+        static XBeeApiBlockPool s_pool;
     public:
         /** Constructor */
         XBeeApiRxFrame();
@@ -68,9 +78,37 @@ class XBeeApiRxFrame : public XBeeApiFrame
                         const uint8_t* const p_data,
                         const size_t         p_dataLen );
 
-	/** Deep copy */
-	/* TODO: doc */
+        /** Make this frame a copy of p_frame, including a copy of the payload, such that
+            it remains valid after p_frame is gone.  The payload is held in a block from a 
+            fixed-size pool (see XBEEAPI_CONFIG_RX_POOL_BLOCKS) rather than on the heap.  Any
+            block already held by this frame is re-used.  In the case that p_frame's payload
+            is held in a shared frame (see setSharedFrame()) the payload is not copied, this
+            frame taking a reference to the shared frame instead.  May be called from 
+            interrupt context.
+
+            \param p_frame Frame to copy
+            \returns true in the case that the copy was made, false in the case that no
+                     block was available or the payload was too large, in which case the
+                     frame has no payload */
         bool deepCopyFrom( const XBeeApiRxFrame& p_frame );
+
+        /** Indicate that the frame's payload is held within a shared frame.  The frame takes
+            a reference to p_shared, which is released along with the payload
+
+            \param p_shared Shared frame containing the data pointed to by m_data */
+        void setSharedFrame( XBeeApiSharedFrame* const p_shared );
+
+        /** Retrieve the shared frame holding the frame's payload, or NULL in the case that
+            the payload is not held in a shared frame */
+        XBeeApiSharedFrame* getSharedFrame( void ) const;
+
+        /** Return any block held by the frame to the pool & release any reference held to
+            a shared frame.  The frame has no payload afterwards */
+        void releaseData( void );
+
+        /** Retrieve the pool used to hold copies of frame payloads, e.g. to check how many
+            blocks remain free */
+        static const XBeeApiBlockPool& getPool( void );
        
         /** Destructor */
         virtual ~XBeeApiRxFrame( void ); 
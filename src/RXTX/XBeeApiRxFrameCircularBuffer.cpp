@@ -18,55 +18,351 @@ limitations under the License.
 
 #include "XBeeApiRxFrameCircularBuffer.hpp"
 
-XBeeApiRxFrameCircularBuffer::XBeeApiRxFrameCircularBuffer( size_t p_bufferSize, XBeeDevice* p_device ) : XBeeApiRxFrameDecoder( p_device ),
-										     m_bufferSize( p_bufferSize ),
+#include <string.h>
+
+#define XBEE_RX_RING_POSN_LEN    (0U)
+#define XBEE_RX_RING_POSN_API_ID (1U)
+
+/** Value stored in place of a frame's length to indicate that the remainder of the ring
+    is unused & the next frame is at the start.  Payloads are never this long */
+#define XBEE_RX_RING_WRAP_MARKER (0xFFU)
+
+/** Mask for the part of the tail index holding the position of the oldest frame */
+#define XBEE_RX_RING_POSN_MASK   (( 1U << XBEE_RX_RING_POSN_BITS ) - 1U )
+
+/** Extract the position of the oldest frame from the tail index */
+#define TAIL_POSN( _tail )       (( _tail ) & XBEE_RX_RING_POSN_MASK )
+
+/** Extract the number of frames removed from the tail index */
+#define TAIL_COUNT( _tail )      (( _tail ) >> XBEE_RX_RING_POSN_BITS )
+
+/** Construct a tail index from a position & a number of frames removed */
+#define MAKE_TAIL( _count, _posn ) ((( _count ) << XBEE_RX_RING_POSN_BITS ) | ( _posn ))
+
+/** Difference between two counts of frames, allowing for the counts having wrapped (only
+    the low bits of the count of frames removed are held in the tail index) */
+#define COUNT_DIFF( _a, _b )     ((( _a ) - ( _b )) & ( ~(size_t)0U >> XBEE_RX_RING_POSN_BITS ))
+
+XBeeApiRxFrameCircularBuffer::XBeeApiRxFrameCircularBuffer( const XBeeApiRxBufferBytes p_bufferSize, XBeeDevice* p_device,
+                                                            const XBeeApiRxOverflowPolicy_e p_policy ) : XBeeApiRxFrameDecoder( p_device ),
+										     m_bufferSize( p_bufferSize.getBytes() ),
 										     m_head( 0 ),
 										     m_tail( 0 ),
-										     m_count( 0 )
+										     m_pushed( 0 ),
+										     m_droppedFrames( 0 ),
+										     m_droppedBytes( 0 ),
+										     m_readCount( 0 ),
+										     m_overflowPolicy( p_policy ),
+										     m_highWater( 0 ),
+										     m_highWaterCallback( NULL ),
+										     m_highWaterCtx( NULL ),
+										     m_waitCount( 0 )
 {
-    m_framesBuffer = new( XBeeApiRxFrame[ m_bufferSize ] );
+    if( m_bufferSize > XBEE_RX_RING_MAX_SIZE )
+    {
+        m_bufferSize = XBEE_RX_RING_MAX_SIZE;
+    }
+    m_buffer = new uint8_t[ m_bufferSize ];
 }
 
 XBeeApiRxFrameCircularBuffer::~XBeeApiRxFrameCircularBuffer( void )
 {
+    delete[]( m_buffer );
+}
+
+size_t XBeeApiRxFrameCircularBuffer::getIndex( const size_t p_posn ) const
+{
+    return ( p_posn < m_bufferSize ) ? p_posn : ( p_posn - m_bufferSize );
+}
+
+size_t XBeeApiRxFrameCircularBuffer::advance( const size_t p_posn, const size_t p_bytes ) const
+{
+    size_t ret_val = p_posn + p_bytes;
+
+    if( ret_val >= ( 2U * m_bufferSize ))
+    {
+        ret_val -= ( 2U * m_bufferSize );
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiRxFrameCircularBuffer::nextFrame( const size_t p_posn, size_t* const p_dataLen ) const
+{
+    size_t ret_val = p_posn;
+    size_t index = getIndex( p_posn );
+
+    if( m_buffer[ index + XBEE_RX_RING_POSN_LEN ] == XBEE_RX_RING_WRAP_MARKER )
+    {
+        ret_val = advance( ret_val, m_bufferSize - index );
+        index = 0;
+    }
+
+    *p_dataLen = m_buffer[ index + XBEE_RX_RING_POSN_LEN ];
+
+    return advance( ret_val, XBEE_RX_RING_HEADER_LEN + *p_dataLen );
+}
+
+size_t XBeeApiRxFrameCircularBuffer::getUsed( const size_t p_head, const size_t p_tail ) const
+{
+    return ( p_head >= p_tail ) ? ( p_head - p_tail ) : ( p_head + ( 2U * m_bufferSize ) - p_tail );
 }
 
 void XBeeApiRxFrameCircularBuffer::frameRxCallback( const XBeeApiRxFrame* const p_frame )
 {
-    if( m_count < m_bufferSize )
+    const uint8_t* data;
+    uint16_t dataLen;
+    p_frame->getDataPtr( 0, &data, &dataLen );
+
+    const size_t head = m_head.loadOwn();
+    const size_t frameLen = XBEE_RX_RING_HEADER_LEN + dataLen;
+    const size_t endSpace = m_bufferSize - getIndex( head );
+    /* Space which needs to be skipped in order to store the frame contiguously */
+    const size_t skip = ( frameLen > endSpace ) ? endSpace : 0;
+    size_t tail = m_tail.load();
+    size_t used = getUsed( head, TAIL_POSN( tail ));
+    /* Would the frame fit if the buffer were empty? */
+    const bool storable = ( dataLen < XBEE_RX_RING_WRAP_MARKER ) &&
+                          (( skip + frameLen ) <= m_bufferSize );
+
+    if( storable && 
+        ( m_overflowPolicy == XBEE_API_RX_OVERFLOW_DROP_OLDEST ))
     {
-	size_t insertPoint = m_head;
-	m_count++;
-        m_head = (m_head + 1) % m_bufferSize;
-	m_framesBuffer[ insertPoint ].deepCopyFrom( *p_frame );
+        /* Discard frames from the tail until there's space.  The tail may be moved on 
+           at the same time by frames being removed, in which case the exchange fails &
+           we try again with the updated tail */
+        while(( used + skip + frameLen ) > m_bufferSize )
+        {
+            size_t droppedLen;
+            const size_t next = MAKE_TAIL( TAIL_COUNT( tail ) + 1U, 
+                                           nextFrame( TAIL_POSN( tail ), &droppedLen ));
+
+            if( m_tail.compareExchange( tail, next ))
+            {
+                m_droppedFrames.store( m_droppedFrames.loadOwn() + 1U );
+                m_droppedBytes.store( m_droppedBytes.loadOwn() + droppedLen );
+                tail = next;
+            }
+            used = getUsed( head, TAIL_POSN( tail ));
+        }
+    }
+
+    if( storable &&
+        (( used + skip + frameLen ) <= m_bufferSize ))
+    {
+        size_t posn = getIndex( head );
+
+        if( skip )
+        {
+            m_buffer[ posn ] = XBEE_RX_RING_WRAP_MARKER;
+            posn = 0;
+        }
+
+        m_buffer[ posn + XBEE_RX_RING_POSN_LEN ] = (uint8_t)dataLen;
+        m_buffer[ posn + XBEE_RX_RING_POSN_API_ID ] = (uint8_t)p_frame->getApiId();
+        memcpy( &( m_buffer[ posn + XBEE_RX_RING_HEADER_LEN ] ), data, dataLen );
+
+        /* Only make the frame visible once it's complete.  The head is moved first so
+           that the space is accounted for by the time the frame is counted */
+        m_head.store( advance( head, skip + frameLen ));
+        m_pushed.store( m_pushed.loadOwn() + 1U );
+
+        /* Wake anything waiting in waitForFrames() once there are enough frames.  The fence
+           pairs with the one in waitForFrames() so that a waiter can't be missed */
+        XBeeApiAtomicIndex::fence();
+        const size_t waitCount = m_waitCount.load();
+        if(( waitCount != 0 ) &&
+           ( getFrameCount() >= waitCount ))
+        {
+            m_frameEvent.signal();
+        }
+
+        if(( m_highWaterCallback != NULL ) &&
+           ( used < m_highWater ) &&
+           (( used + skip + frameLen ) >= m_highWater ))
+        {
+            m_highWaterCallback( this, used + skip + frameLen, m_highWaterCtx );
+        }
+    }
+    else
+    {
+        m_droppedFrames.store( m_droppedFrames.loadOwn() + 1U );
+        m_droppedBytes.store( m_droppedBytes.loadOwn() + dataLen );
     }
 }
 	
 size_t XBeeApiRxFrameCircularBuffer::getFrameCount() const
 {
-    return( m_count );
+    /* Tail first - frames can only be discarded from the tail once they've been counted */
+    const size_t tail = m_tail.load();
+    return COUNT_DIFF( m_pushed.load(), TAIL_COUNT( tail ));
 }
 
 void XBeeApiRxFrameCircularBuffer::clear()
 {
-    m_count = 0;
+    m_readCount = TAIL_COUNT( m_tail.load() );
+    pop( getFrameCount() );
 }
 
 void XBeeApiRxFrameCircularBuffer::pop()
 {
-    if( m_count )
+    pop( 1U );
+}
+
+void XBeeApiRxFrameCircularBuffer::pop( const size_t p_count )
+{
+    size_t tail = m_tail.load();
+    size_t next;
+
+    do
     {
-    	m_tail = (m_tail + 1) % m_bufferSize;
-    	m_count--;
-    }
+        const size_t available = COUNT_DIFF( m_pushed.load(), TAIL_COUNT( tail ));
+        /* Frames which have been discarded since they were retrieved count towards those
+           to be removed */
+        const size_t discarded = COUNT_DIFF( TAIL_COUNT( tail ), m_readCount );
+        size_t count = ( discarded < p_count ) ? ( p_count - discarded ) : 0;
+        size_t posn = TAIL_POSN( tail );
+
+        if( count > available )
+        {
+            count = available;
+        }
+
+        for( size_t i = 0;
+             i < count;
+             i++ )
+        {
+            size_t dataLen;
+            posn = nextFrame( posn, &dataLen );
+        }
+
+        next = MAKE_TAIL( TAIL_COUNT( tail ) + count, posn );
+
+        /* Hand the space back only once we've finished with it.  The exchange fails in 
+           the case that frames were discarded in the meantime */
+    } while( !m_tail.compareExchange( tail, next ));
+
+    m_readCount = TAIL_COUNT( next );
 }
 	
 const XBeeApiRxFrame* XBeeApiRxFrameCircularBuffer::getTailPtr( void ) const
 {
     XBeeApiRxFrame* ret_val = NULL;
-    if( m_count )
+    if( getFrames( &m_tailFrame, 1U ))
+    {
+        ret_val = &m_tailFrame;
+    }
+    return ret_val;
+}
+
+size_t XBeeApiRxFrameCircularBuffer::getFrames( XBeeApiRxFrame* const p_frames, const size_t p_maxFrames ) const
+{
+    const size_t tail = m_tail.load();
+    const size_t count = COUNT_DIFF( m_pushed.load(), TAIL_COUNT( tail ));
+    size_t posn = getIndex( TAIL_POSN( tail ));
+    size_t ret_val;
+
+    m_readCount = TAIL_COUNT( tail );
+
+    for( ret_val = 0;
+         ( ret_val < p_maxFrames ) && ( ret_val < count );
+         ret_val++ )
+    {
+        if( m_buffer[ posn + XBEE_RX_RING_POSN_LEN ] == XBEE_RX_RING_WRAP_MARKER )
+        {
+            posn = 0;
+        }
+
+        const size_t dataLen = m_buffer[ posn + XBEE_RX_RING_POSN_LEN ];
+
+        /* Frames being discarded (see XBEE_API_RX_OVERFLOW_DROP_OLDEST) may be overwritten 
+           while we're looking at them - don't stray outside the buffer if that happens */
+        if(( posn + XBEE_RX_RING_HEADER_LEN + dataLen ) > m_bufferSize )
+        {
+            break;
+        }
+
+        p_frames[ ret_val ].releaseData();
+        p_frames[ ret_val ] = XBeeApiRxFrame( (XBeeApiIdentifier_e)m_buffer[ posn + XBEE_RX_RING_POSN_API_ID ],
+                                              &( m_buffer[ posn + XBEE_RX_RING_HEADER_LEN ] ),
+                                              dataLen );
+
+        posn += XBEE_RX_RING_HEADER_LEN + dataLen;
+        if( posn == m_bufferSize )
+        {
+            posn = 0;
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiRxFrameCircularBuffer::waitForFrame( const uint32_t p_timeout_ms )
+{
+    return waitForFrames( 1U, p_timeout_ms );
+}
+
+bool XBeeApiRxFrameCircularBuffer::waitForFrames( const size_t p_count, const uint32_t p_timeout_ms )
+{
+    XBeeApiTimeout timeout( p_timeout_ms );
+    bool ret_val;
+
+    /* Discard any signal left over from frames which arrived while nothing was waiting */
+    m_frameEvent.clear();
+    m_waitCount.store( p_count );
+    XBeeApiAtomicIndex::fence();
+
+    for( ;; )
     {
-        ret_val = &( m_framesBuffer[ m_tail ] );
+        ret_val = ( getFrameCount() >= p_count );
+
+        const uint32_t remaining = timeout.getRemaining();
+        if( ret_val || ( remaining == 0 ))
+        {
+            break;
+        }
+        m_frameEvent.wait( remaining );
     }
+
+    m_waitCount.store( 0 );
+
     return ret_val;
 }
+
+void XBeeApiRxFrameCircularBuffer::setOverflowPolicy( const XBeeApiRxOverflowPolicy_e p_policy )
+{
+    m_overflowPolicy = p_policy;
+}
+
+XBeeApiRxFrameCircularBuffer::XBeeApiRxOverflowPolicy_e XBeeApiRxFrameCircularBuffer::getOverflowPolicy( void ) const
+{
+    return m_overflowPolicy;
+}
+
+void XBeeApiRxFrameCircularBuffer::setHighWaterCallback( const size_t p_threshold, 
+                                                         const XBeeApiRxHighWaterCallback_t p_callback,
+                                                         void* const p_ctx )
+{
+    m_highWater = p_threshold;
+    m_highWaterCtx = p_ctx;
+    m_highWaterCallback = p_callback;
+}
+
+size_t XBeeApiRxFrameCircularBuffer::getUsed( void ) const
+{
+    /* Tail first, as the head can only move away from it.  Frames may be discarded in
+       between, so the result is limited to the size of the buffer */
+    const size_t tail = m_tail.load();
+    const size_t ret_val = getUsed( m_head.load(), TAIL_POSN( tail ));
+    return ( ret_val < m_bufferSize ) ? ret_val : m_bufferSize;
+}
+
+size_t XBeeApiRxFrameCircularBuffer::getDroppedFrames( void ) const
+{
+    return m_droppedFrames.load();
+}
+
+size_t XBeeApiRxFrameCircularBuffer::getDroppedBytes( void ) const
+{
+    return m_droppedBytes.load();
+}
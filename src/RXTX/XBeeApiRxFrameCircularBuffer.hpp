@@ -28,38 +28,267 @@ limitations under the License.
 
 #include "XBeeApiRxFrameDecoder.hpp"
 #include "XBeeDevice.hpp"
+#include "XBeeApiAtomic.hpp"
+#include "XBeeApiEvent.hpp"
 
 #include <stdint.h>
 
-/** Class to deal with decoding of an RX'd data frame
+/** Number of bytes of header stored in XBeeApiRxFrameCircularBuffer ahead of each
+    frame's payload */
+#define XBEE_RX_RING_HEADER_LEN 2U
+
+/** Number of bits of XBeeApiRxFrameCircularBuffer's tail index which hold the position
+    of the oldest frame.  The remaining bits hold a count of the frames removed */
+#define XBEE_RX_RING_POSN_BITS 16U
+
+/** Largest size of buffer supported by XBeeApiRxFrameCircularBuffer, in bytes */
+#define XBEE_RX_RING_MAX_SIZE (( 1U << ( XBEE_RX_RING_POSN_BITS - 1U )) - 1U )
+
+/** Size of an XBeeApiRxFrameCircularBuffer, in bytes.  The buffer was once sized in
+    frames, so the size is wrapped up in its own type rather than being a plain integer, 
+    meaning that code written for the old constructor fails to compile rather than 
+    silently getting a buffer of only a few bytes. e.g.
+
+    \code
+    XBeeApiRxFrameCircularBuffer rxBuffer( XBeeApiRxBufferBytes( 1024 ), &xbeeDevice );
+    \endcode
+*/
+class XBeeApiRxBufferBytes
+{
+    protected:
+        /** Number of bytes */
+        size_t m_bytes;
+
+    public:
+        /** Constructor
+
+            \param p_bytes Number of bytes */
+        explicit XBeeApiRxBufferBytes( const size_t p_bytes ) : m_bytes( p_bytes )
+        {
+        }
+
+        /** Retrieve the number of bytes */
+        size_t getBytes( void ) const
+        {
+            return m_bytes;
+        }
+};
+
+/** Class to store received data frames until the application is ready to deal with
+    them.
+
+    Frames are packed into a ring of bytes, each one being stored as a small header
+    (see XBEE_RX_RING_HEADER_LEN) followed by its payload, meaning that the number of
+    frames which can be stored depends upon their size.  Each frame is held contiguously;
+    in the case that a frame won't fit in the space remaining before the end of the ring,
+    a marker is left and the frame is stored at the start instead.  Frames retrieved from
+    the buffer refer to the payload in place, so remain valid only until they're removed
+    via pop() or clear().
+
+    Frames are added from the context in which the XBeeDevice decodes received data
+    (possibly interrupt context) and may be retrieved & removed from one other context.
+    The two contexts share the buffer without locking: each index is written by only one
+    of them (see XBeeApiAtomicIndex), and is updated only once the data it covers has been
+    written (in the case of adding a frame) or finished with (in the case of removing one).
+
+    When a frame arrives & the buffer is full either the new frame is discarded or the 
+    oldest frames are discarded to make space for it, depending upon the overflow policy
+    (see setOverflowPolicy()).  Either way, the loss is recorded (see getDroppedFrames()
+    and getDroppedBytes()).  A call-back may also be registered to warn the application
+    that the buffer is filling up (see setHighWaterCallback()).
+
+    Rather than polling, the context removing frames can block until frames arrive using
+    waitForFrame() or waitForFrames().
 */
 class XBeeApiRxFrameCircularBuffer : public XBeeApiRxFrameDecoder
 {
+    public:
+        /** What to do with a frame which arrives when the buffer is full */
+        typedef enum
+        {
+            /** Discard the frame which has just arrived */
+            XBEE_API_RX_OVERFLOW_DROP_NEWEST = 0,
+            /** Discard the oldest frames in the buffer until there's space for the frame 
+                which has just arrived */
+            XBEE_API_RX_OVERFLOW_DROP_OLDEST = 1
+        } XBeeApiRxOverflowPolicy_e;
+
+        /** Type of function which can be called when the buffer fills beyond a threshold.  
+            Called from the context in which frames are received (possibly interrupt context)
+
+            \param p_buffer Buffer which has reached the threshold
+            \param p_used Number of bytes of the buffer now in use
+            \param p_ctx Context pointer, as passed to setHighWaterCallback() */
+        typedef void (*XBeeApiRxHighWaterCallback_t)( XBeeApiRxFrameCircularBuffer* const p_buffer,
+                                                     const size_t p_used,
+                                                     void* const p_ctx );
+
     protected:
-        size_t          m_bufferSize;
-        size_t          m_head;
-        size_t          m_tail;	
-	size_t          m_count;
-	XBeeApiRxFrame* m_framesBuffer;
+        /** Storage for the ring */
+        uint8_t*           m_buffer;
+        /** Size of m_buffer in bytes */
+        size_t             m_bufferSize;
+        /** Position at which the next frame will be stored.  Positions run from 0 to twice
+            m_bufferSize, allowing a full ring to be distinguished from an empty one.
+            Written only when adding frames */
+        XBeeApiAtomicIndex m_head;
+        /** Position of the oldest frame (or of a marker preceding it), combined with the
+            number of frames which have been removed - see XBEE_RX_RING_POSN_BITS.  Written
+            when removing frames and also, in the case that the overflow policy is
+            XBEE_API_RX_OVERFLOW_DROP_OLDEST, when adding them, so only ever updated using 
+            XBeeApiAtomicIndex::compareExchange() */
+        XBeeApiAtomicIndex m_tail;
+        /** Number of frames which have been added.  Written only when adding frames */
+        XBeeApiAtomicIndex m_pushed;
+        /** Number of frames which have been discarded due to the buffer being full.  
+            Written only when adding frames */
+        XBeeApiAtomicIndex m_droppedFrames;
+        /** Number of bytes of payload which have been discarded due to the buffer being 
+            full.  Written only when adding frames */
+        XBeeApiAtomicIndex m_droppedBytes;
+        /** Count of removed frames (see m_tail) as of the oldest frame retrieved by
+            getFrames(), used by pop() to account for any of those frames which have since
+            been discarded.  Used only when removing frames */
+        mutable size_t     m_readCount;
+        /** What to do with frames which arrive when the buffer is full */
+        XBeeApiRxOverflowPolicy_e m_overflowPolicy;
+        /** Number of bytes in use at which m_highWaterCallback is called */
+        size_t             m_highWater;
+        /** Function to call when the buffer fills to m_highWater bytes */
+        XBeeApiRxHighWaterCallback_t m_highWaterCallback;
+        /** Context pointer to pass to m_highWaterCallback */
+        void*              m_highWaterCtx;
+        /** Number of frames being waited for by waitForFrames(), 0 if nothing is waiting.
+            Written only when removing frames */
+        XBeeApiAtomicIndex m_waitCount;
+        /** Signalled when frames are added & m_waitCount frames are available */
+        XBeeApiEvent       m_frameEvent;
+        /** Frame returned by getTailPtr() */
+        mutable XBeeApiRxFrame m_tailFrame;
+
+        /** Convert a position (see m_head) into an index in m_buffer */
+        size_t getIndex( const size_t p_posn ) const;
+
+        /** Move a position (see m_head) on by a number of bytes */
+        size_t advance( const size_t p_posn, const size_t p_bytes ) const;
+
+        /** Determine the position of the frame following the one at a given position
+
+            \param p_posn Position (see m_head) of a frame, or of a marker preceding it
+            \param p_dataLen Receives the length of the frame's payload
+            \returns The position following the frame */
+        size_t nextFrame( const size_t p_posn, size_t* const p_dataLen ) const;
+
+        /** Determine the number of bytes in use between the tail & head positions */
+        size_t getUsed( const size_t p_head, const size_t p_tail ) const;
+
     public:
-        /** Constructor */
-        XBeeApiRxFrameCircularBuffer( size_t p_bufferSize, XBeeDevice* p_device = NULL );
+        /** Constructor
+
+            \param p_bufferSize Size of the buffer in bytes (see XBeeApiRxBufferBytes).  
+                                Each frame uses XBEE_RX_RING_HEADER_LEN bytes plus its 
+                                payload.  Limited to XBEE_RX_RING_MAX_SIZE
+            \param p_device XBee device with which this object should be associated
+            \param p_policy What to do with frames which arrive when the buffer is full */
+        XBeeApiRxFrameCircularBuffer( const XBeeApiRxBufferBytes p_bufferSize, XBeeDevice* p_device = NULL,
+                                      const XBeeApiRxOverflowPolicy_e p_policy = XBEE_API_RX_OVERFLOW_DROP_NEWEST );
         
         /** Destructor */
         virtual ~XBeeApiRxFrameCircularBuffer( void ); 
 
-        /* Callback which is invoked when a frame is successfully decoded
+        /* Callback which is invoked when a frame is successfully decoded.  Frames which
+           don't fit in the buffer are dealt with according to the overflow policy
 	   \param p_frame The frame content
         */       
         virtual void frameRxCallback( const XBeeApiRxFrame* const p_frame );
 
+        /** Retrieve the number of frames in the buffer */
 	size_t getFrameCount() const;
 
+        /** Remove all frames from the buffer.  Frames being added at the same time may or may
+            not be removed */
 	void clear();
 
+        /** Remove the oldest frame from the buffer */
 	void pop();
 
+        /** Remove a number of frames from the buffer, oldest first.  In the case that frames
+            previously retrieved via getFrames() have since been discarded to make space 
+            for new frames, they count towards the number removed.
+
+            \param p_count Number of frames to remove */
+        void pop( const size_t p_count );
+
+        /** Retrieve the oldest frame in the buffer
+
+            \returns Pointer to the frame, or NULL in the case that the buffer is empty.
+                     The frame remains valid until the next call to getTailPtr(), pop() or
+                     clear() */
 	const XBeeApiRxFrame* getTailPtr() const;
+
+        /** Retrieve a batch of frames from the buffer, oldest first, without removing
+            them.  Once they have been dealt with the frames can be removed using
+            pop( size_t ).
+
+            \param p_frames Array to receive the frames, which remain valid until they are
+                            removed from the buffer
+            \param p_maxFrames Number of entries in p_frames
+            \returns Number of frames retrieved */
+        size_t getFrames( XBeeApiRxFrame* const p_frames, const size_t p_maxFrames ) const;
+
+        /** Wait for a frame to be available in the buffer.  Must be called from the context
+            which removes frames from the buffer
+
+            \param p_timeout_ms Maximum time to wait, in milliseconds
+            \returns true in the case that a frame is available, false in the case that the
+                     timeout expired */
+        bool waitForFrame( const uint32_t p_timeout_ms );
+
+        /** Wait for a number of frames to be available in the buffer.  Must be called from
+            the context which removes frames from the buffer.  The waiting context is only
+            woken once the number of frames has been reached (or the timeout expires), not
+            for each frame which arrives.
+
+            \param p_count Number of frames to wait for.  Note that in the case that the
+                           frames won't all fit in the buffer, the wait will time out
+            \param p_timeout_ms Maximum time to wait, in milliseconds
+            \returns true in the case that at least p_count frames are available, false in
+                     the case that the timeout expired */
+        bool waitForFrames( const size_t p_count, const uint32_t p_timeout_ms );
+
+        /** Set what to do with frames which arrive when the buffer is full.  Note that with
+            XBEE_API_RX_OVERFLOW_DROP_OLDEST, frames which have been retrieved but not yet 
+            removed may be discarded (and their content overwritten) at any time, so the 
+            application should check getDroppedFrames() after using them if it needs to know
+            that they were intact.  Should be set before frames start to arrive.
+
+            \param p_policy The policy to use */
+        void setOverflowPolicy( const XBeeApiRxOverflowPolicy_e p_policy );
+
+        /** Retrieve the overflow policy - see setOverflowPolicy() */
+        XBeeApiRxOverflowPolicy_e getOverflowPolicy( void ) const;
+
+        /** Set a function to be called when the buffer fills up.  The function is called 
+            each time a frame takes the number of bytes in use from below the threshold to 
+            or above it.  Should be set before frames start to arrive.
+
+            \param p_threshold Number of bytes in use at which to call the function
+            \param p_callback Function to call, or NULL to disable the call-back
+            \param p_ctx Context pointer to be passed to the function */
+        void setHighWaterCallback( const size_t p_threshold, 
+                                   const XBeeApiRxHighWaterCallback_t p_callback,
+                                   void* const p_ctx = NULL );
+
+        /** Retrieve the number of bytes of the buffer currently in use */
+        size_t getUsed( void ) const;
+
+        /** Retrieve the number of frames which have been discarded due to the buffer being
+            full (whichever the overflow policy) */
+        size_t getDroppedFrames( void ) const;
+
+        /** Retrieve the number of bytes of payload which have been discarded due to the 
+            buffer being full */
+        size_t getDroppedBytes( void ) const;
 };
 
 #endif
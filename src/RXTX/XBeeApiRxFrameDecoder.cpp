@@ -18,7 +18,10 @@ limitations under the License.
 
 #include "XBeeApiRxFrameDecoder.hpp"
 
-XBeeApiRxFrameDecoder::XBeeApiRxFrameDecoder( XBeeDevice* p_device ) : XBeeApiFrameDecoder( p_device )
+/** API identifiers of the frames decoded by this class */
+static const XBeeApiIdentifier_e rx_api_ids[] = { XBEE_CMD_RX_64B_ADDR, XBEE_CMD_RX_16B_ADDR };
+
+XBeeApiRxFrameDecoder::XBeeApiRxFrameDecoder( XBeeDevice* p_device, const bool p_fanOut ) : XBeeApiFrameDecoder( p_device, rx_api_ids, sizeof( rx_api_ids ) / sizeof( rx_api_ids[ 0 ] ), p_fanOut )
 {
 }
 
@@ -26,26 +29,40 @@ XBeeApiRxFrameDecoder::~XBeeApiRxFrameDecoder( void )
 {
 }
 
-bool XBeeApiRxFrameDecoder::decodeCallback( const uint8_t* const p_data, size_t p_len )
+
+bool XBeeApiRxFrameDecoder::decodeCallback( const XBeeApiFrameView& p_data )
+{
+    return decodeFrame( p_data, NULL );
+}
+
+void XBeeApiRxFrameDecoder::sharedFrameCallback( XBeeApiSharedFrame* const p_frame )
+{
+    decodeFrame( p_frame->getView(), p_frame );
+}
+
+bool XBeeApiRxFrameDecoder::decodeFrame( const XBeeApiFrameView& p_data, XBeeApiSharedFrame* const p_shared )
 {
     bool ret_val = false;
+    const bool addrIs16bit = ( XBEE_CMD_RX_16B_ADDR == p_data[ XBEE_CMD_POSN_API_ID ] );
+    /* Shortest frame which can be decoded - the header, source address, RSSI, options
+       and checksum, with no payload */
+    const size_t minLen = XBEE_CMD_POSN_ID_SPECIFIC_DATA + 
+                          ( addrIs16bit ? sizeof( uint16_t ) : sizeof( uint64_t )) + 3U;
  
-    /* TODO: Length check */
- 
-    if(( XBEE_CMD_RX_64B_ADDR == p_data[ XBEE_CMD_POSN_API_ID ] ) ||
-       ( XBEE_CMD_RX_16B_ADDR == p_data[ XBEE_CMD_POSN_API_ID ] ))
+    if((( XBEE_CMD_RX_64B_ADDR == p_data[ XBEE_CMD_POSN_API_ID ] ) || addrIs16bit ) &&
+       ( p_data.getLen() >= minLen ))
     {
         size_t pos = XBEE_CMD_POSN_ID_SPECIFIC_DATA;
 	uint64_t addr;
-	bool addrIs16bit;
 	uint8_t rssi;
 	bool addressBroadcast;
         bool panBroadcast;
 	const uint8_t* data;
         size_t   dataLen;
+        uint8_t  scratch[ XBEE_API_MAX_RX_PAYLOAD_LEN ];
 
         /* Depending on the frame type, decode either a 64- or 16-bit address */
-        if( XBEE_CMD_RX_64B_ADDR == p_data[ XBEE_CMD_POSN_API_ID ] ) 
+        if( !addrIs16bit ) 
         {
             addr = (((uint64_t)p_data[ pos ]) << 54U ) | 
                    (((uint64_t)p_data[ pos+1 ]) << 48U ) |
@@ -56,14 +73,12 @@ bool XBeeApiRxFrameDecoder::decodeCallback( const uint8_t* const p_data, size_t
                    (((uint64_t)p_data[ pos+6 ]) << 8U ) |
                                p_data[ pos+7 ];
             pos += sizeof( uint64_t );
-            addrIs16bit = false;
         }
         else
         {
             addr = (((uint16_t)p_data[ pos ]) << 8U ) | 
                                  p_data[ pos+1 ];
             pos += sizeof( uint16_t );
-            addrIs16bit = true;
         }
         
         rssi += p_data[ pos++ ];
@@ -72,18 +87,30 @@ bool XBeeApiRxFrameDecoder::decodeCallback( const uint8_t* const p_data, size_t
         panBroadcast = p_data[ pos ] & 4U;
         pos++;
         
-        data = &( p_data[ pos ] );
-        
         /* -1 to account for the checksum */
-        dataLen = p_len - pos - 1;
+        dataLen = p_data.getLen() - pos - 1;
+
+        /* Payload is normally referenced in-place in the receive buffer, it's only
+           copied (to the stack) in the case that it wraps around the end of the buffer */
+        data = p_data.getPtr( pos, dataLen, ( dataLen <= sizeof( scratch )) ? scratch : NULL );
         
-	XBeeApiRxFrame new_frame( (XBeeApiIdentifier_e)(p_data[ XBEE_CMD_POSN_API_ID ]),
-			          data,
-				  dataLen );
+        if( data != NULL )
+        {
+	    XBeeApiRxFrame new_frame( (XBeeApiIdentifier_e)(p_data[ XBEE_CMD_POSN_API_ID ]),
+			              data,
+				      dataLen );
+
+            /* The payload is within the shared frame, so anyone wanting to keep the frame
+               can do so by taking a reference rather than copying it */
+            if( p_shared != NULL )
+            {
+                new_frame.setSharedFrame( p_shared );
+            }
         
-        frameRxCallback( &new_frame );
+            frameRxCallback( &new_frame );
         
-        ret_val = true;
+            ret_val = true;
+        }
     }
     
     return ret_val;
@@ -38,14 +38,33 @@ class XBeeApiRxFrameDecoder : public XBeeApiFrameDecoder
         /** Called by XBeeDevice in order to offer frame data to the object for
             decoding
            
-            \param p_data Pointer to the content of the received data
-            \param p_len Length of the data pointed to by p_data
+            \param p_data View of the content of the received data
         */
-        virtual bool decodeCallback( const uint8_t* const p_data, size_t p_len );
+        virtual bool decodeCallback( const XBeeApiFrameView& p_data );
+
+        /** Called by XBeeDevice in order to offer a frame to the object in the case that
+            it's registered for fan-out.  The frame passed to frameRxCallback() refers to
+            the payload within p_frame, so can be kept without copying the payload (see
+            XBeeApiRxFrame::deepCopyFrom())
+
+            \param p_frame The received frame */
+        virtual void sharedFrameCallback( XBeeApiSharedFrame* const p_frame );
+
+        /** Decode a received frame & pass it to frameRxCallback()
+
+            \param p_data View of the received frame
+            \param p_shared Shared frame which p_data is a view of, or NULL
+            \returns true in the case that the frame was decoded */
+        bool decodeFrame( const XBeeApiFrameView& p_data, XBeeApiSharedFrame* const p_shared );
 
     public:
-        /** Constructor */
-        XBeeApiRxFrameDecoder( XBeeDevice* p_device = NULL );
+        /** Constructor
+
+            \param p_device Device with which to register the decoder, or NULL
+            \param p_fanOut true in the case that the decoder should see all received data
+                            frames, even those decoded by other decoders - see 
+                            XBeeApiFrameDecoder::XBeeApiFrameDecoder() */
+        XBeeApiRxFrameDecoder( XBeeDevice* p_device = NULL, const bool p_fanOut = false );
         
         /** Destructor */
         virtual ~XBeeApiRxFrameDecoder( void ); 
@@ -18,10 +18,18 @@ limitations under the License.
 
 #include "XBeeApiTxFrame.hpp"
 
-XBeeApiTxFrame::XBeeApiTxFrame( XBeeDevice* p_device ) : XBeeApiFrame(), XBeeApiFrameDecoder( p_device ),
+/** API identifiers of the frames decoded by this class */
+static const XBeeApiIdentifier_e tx_api_ids[] = { XBEE_CMD_TX_STATUS };
+
+XBeeApiTxFrame::XBeeApiTxFrame( XBeeDevice* p_device ) : XBeeApiFrame(), XBeeApiFrameDecoder( p_device, tx_api_ids, sizeof( tx_api_ids ) / sizeof( tx_api_ids[ 0 ] ) ),
                                                          m_addr( XBEE_BROADCAST_ADDR ),
                                                          m_ack( true ), 
-                                                         m_panBroadcast( false )
+                                                         m_panBroadcast( false ),
+                                                         m_bufferLen( 0 ),
+                                                         m_frameId( XBEE_FRAME_ID_NONE ),
+                                                         m_txDevice( NULL ),
+                                                         m_txCallback( NULL ),
+                                                         m_txCallbackCtx( NULL )
 {
     m_apiId = XBEE_CMD_TX_16B_ADDR;
 }
@@ -29,39 +37,40 @@ XBeeApiTxFrame::XBeeApiTxFrame( XBeeDevice* p_device ) : XBeeApiFrame(), XBeeApi
 
 XBeeApiTxFrame::~XBeeApiTxFrame( void ) 
 {
+    /* Don't want the TX status to be routed to an object which no longer exists */
+    releaseFrameId();
 }
 
 uint8_t XBeeApiTxFrame::getFrameId( void ) const
 {
-    return 'T';
+    return m_frameId;
 }
 
-uint16_t XBeeApiTxFrame::getCmdLen( void ) const
+void XBeeApiTxFrame::releaseFrameId( void )
 {
-    /* Length of the data payload plus the API ID, frame ID and option byte */ 
-    uint16_t ret_val = m_dataLen + 3U;
-    
-    if( m_apiId == XBEE_CMD_TX_16B_ADDR )
-    {
-        ret_val += 2U;
-    }
-    else
+    if(( m_txDevice != NULL ) &&
+       ( m_frameId != XBEE_FRAME_ID_NONE ))
     {
-        ret_val += 8U;
+        m_txDevice->releaseFrameId( m_frameId, this );
     }
-
-    return ret_val;
+    m_frameId = XBEE_FRAME_ID_NONE;
 }
 
-
-void XBeeApiTxFrame::getDataPtr( const uint16_t p_start, const uint8_t**  p_buff, uint16_t* const p_len )
+bool XBeeApiTxFrame::prepareForTx( XBeeDevice* const p_device )
 {
-    if( p_start == 0 ) 
+    bool ret_val = false;
+
+    /* Any status for a previous transmission is no longer of interest */
+    releaseFrameId();
+
+    m_txDevice = p_device;
+    m_frameId = p_device->allocFrameId( this );
+
+    if( m_frameId != XBEE_FRAME_ID_NONE )
     {
         /* Need to keep the XBEE_API_TX_FRAME_BUFFER_SIZE limit in mind when writing to m_buffer */
- 
         uint8_t len = 0;
-        m_buffer[ len++ ] = getFrameId(); // Frame ID
+        m_buffer[ len++ ] = m_frameId;
         
         /* Pack the destination address depending on whether it's 16 or 64-bit addressed */
         if( m_apiId == XBEE_CMD_TX_16B_ADDR )
@@ -73,6 +82,7 @@ void XBeeApiTxFrame::getDataPtr( const uint16_t p_start, const uint8_t**  p_buff
         {
             m_buffer[ len++ ] = m_addr >> 56U;
             m_buffer[ len++ ] = m_addr >> 48U;
+            m_buffer[ len++ ] = m_addr >> 40U;
             m_buffer[ len++ ] = m_addr >> 32U;
             m_buffer[ len++ ] = m_addr >> 24U;
             m_buffer[ len++ ] = m_addr >> 16U;
@@ -81,23 +91,50 @@ void XBeeApiTxFrame::getDataPtr( const uint16_t p_start, const uint8_t**  p_buff
         }
         
         /* Frame options */
-        m_buffer[ len++ ] =   m_ack?         (0x00U):(0x01U)
-                            | m_panBroadcast?(0x04U):(0x00U);
- 
-        *p_buff = &( m_buffer[0] );
-        *p_len = len;    
-    } 
-    else 
+        m_buffer[ len++ ] = ( m_ack?         (0x00U):(0x01U) )
+                          | ( m_panBroadcast?(0x04U):(0x00U) );
+
+        m_bufferLen = len;
+        ret_val = true;
+    }
+
+    return ret_val;
+}
+
+uint16_t XBeeApiTxFrame::getCmdLen( void ) const
+{
+    /* Length of the data payload plus the API ID, frame ID and option byte */ 
+    uint16_t ret_val = m_dataLen + 3U;
+    
+    if( m_apiId == XBEE_CMD_TX_16B_ADDR )
+    {
+        ret_val += 2U;
+    }
+    else
     {
-        *p_buff = m_data;
-        *p_len = m_dataLen;
+        ret_val += 8U;
     }
+
+    return ret_val;
+}
+
+
+size_t XBeeApiTxFrame::getSegments( XBeeApiFrameSegment_t* const p_segs ) const
+{
+    /* Header is packed by prepareForTx() */
+    p_segs[ 0 ].m_data = m_buffer;
+    p_segs[ 0 ].m_len = m_bufferLen;
+    /* The payload is transmitted from the user's buffer */
+    p_segs[ 1 ].m_data = m_data;
+    p_segs[ 1 ].m_len = m_dataLen;
+
+    return 2U;
 }
 
 bool XBeeApiTxFrame::setDataPtr( const uint8_t* const p_buff, const uint16_t p_len )
 {
     bool ret_val = false;
-    if( p_len < XBEE_API_MAX_TX_PAYLOAD_LEN )
+    if( p_len <= XBEE_API_MAX_TX_PAYLOAD_LEN )
     {
         m_data = p_buff;
         m_dataLen = p_len;
@@ -133,14 +170,22 @@ void XBeeApiTxFrame::setPanBroadcast( const bool p_bc )
     m_panBroadcast = p_bc;
 }
 
-bool XBeeApiTxFrame::decodeCallback( const uint8_t* const p_data, size_t p_len )
+
+bool XBeeApiTxFrame::decodeCallback( const XBeeApiFrameView& p_data )
 {
     bool ret_val = false;
  
-    if( XBEE_CMD_TX_STATUS == p_data[ XBEE_CMD_POSN_API_ID ] )
+    /* Only interested in the status relating to the most recent transmission of this frame.  
+       Normally this will have been routed here by the XBeeDevice, which has already released 
+       the frame identifier */
+    if(( XBEE_CMD_TX_STATUS == p_data[ XBEE_CMD_POSN_API_ID ] ) &&
+       ( m_frameId != XBEE_FRAME_ID_NONE ) &&
+       ( m_frameId == p_data[ XBEE_CMD_POSN_FRAME_ID ] ))
     {
+        m_frameId = XBEE_FRAME_ID_NONE;
+
         /* Data transmitted call-back */
-        frameTxCallback( (XBeeApiTxStatus_e)(p_data[ XBEE_CMD_POSN_ID_SPECIFIC_DATA + 1U ]) );
+        frameTxCallback( (XBeeApiTxStatus_e)(p_data[ XBEE_CMD_POSN_FRAME_ID + 1U ]) );
         ret_val = true;
     }
     
@@ -149,5 +194,14 @@ bool XBeeApiTxFrame::decodeCallback( const uint8_t* const p_data, size_t p_len )
 
 void XBeeApiTxFrame::frameTxCallback( const XBeeApiTxStatus_e p_status )
 {
-    /* TODO */
+    if( m_txCallback != NULL )
+    {
+        m_txCallback( this, p_status, m_txCallbackCtx );
+    }
+}
+
+void XBeeApiTxFrame::setTxCallback( const XBeeApiTxCallback_t p_callback, void* const p_ctx )
+{
+    m_txCallback = p_callback;
+    m_txCallbackCtx = p_ctx;
 }
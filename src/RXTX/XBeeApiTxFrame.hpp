@@ -47,14 +47,24 @@ class XBeeApiTxFrame : public XBeeApiFrame, public XBeeApiFrameDecoder
        bool              m_panBroadcast;
        /** Buffer to house data relating to the frame header */
        uint8_t           m_buffer[XBEE_API_TX_FRAME_BUFFER_SIZE];
+       /** Length of the data in m_buffer */
+       uint8_t           m_bufferLen;
+       /** Frame identifier allocated for the most recent transmission of this frame.
+           XBEE_FRAME_ID_NONE in the case that no TX status is outstanding */
+       uint8_t           m_frameId;
+       /** Device via which the frame was most recently transmitted (and hence the
+           device which allocated m_frameId) */
+       XBeeDevice*       m_txDevice;
 
        /** Called by XBeeDevice in order to offer frame data to the object for
            decoding
            
-           \param p_data Pointer to the content of the received data
-           \param p_len Length of the data pointed to by p_data
+           \param p_data View of the content of the received data
        */
-       virtual bool decodeCallback( const uint8_t* const p_data, size_t p_len );
+       virtual bool decodeCallback( const XBeeApiFrameView& p_data );
+
+       /** Release the frame identifier allocated to this frame, if any */
+       void releaseFrameId( void );
 
     public:
        /** Enum for capturing the possible status of an XBee message TX 
@@ -77,6 +87,15 @@ class XBeeApiTxFrame : public XBeeApiFrame, public XBeeApiFrameDecoder
                enumeration items */
            XBEE_API_TX_STATUS_LAST = 4  
        } XBeeApiTxStatus_e;
+
+       /** Type of function which can be called when the TX status for a frame is received
+
+           \param p_frame Frame to which the status relates
+           \param p_status Status of the TX attempt
+           \param p_ctx Context pointer, as passed to setTxCallback() */
+       typedef void (*XBeeApiTxCallback_t)( XBeeApiTxFrame* const p_frame,
+                                            const XBeeApiTxStatus_e p_status,
+                                            void* const p_ctx );
     
        XBeeApiTxFrame( XBeeDevice* p_device = NULL );
        virtual ~XBeeApiTxFrame( void );
@@ -87,25 +106,52 @@ class XBeeApiTxFrame : public XBeeApiFrame, public XBeeApiFrameDecoder
        void setPanBroadcast( const bool p_bc );
        
        virtual uint16_t getCmdLen( void ) const;
-       virtual void getDataPtr( const uint16_t p_start, const uint8_t**  p_buff, uint16_t* const p_len );
+       /** Returns the header packed by prepareForTx() (frame identifier, destination address
+           & options) followed by the payload set via setDataPtr() - see 
+           XBeeApiFrame::getSegments() */
+       virtual size_t getSegments( XBeeApiFrameSegment_t* const p_segs ) const;
+
+       /** Allocates a frame identifier from p_device (releasing any previously allocated to 
+           this frame) so that the TX status can be routed back to this object.  Fails in the 
+           case that the device has too many frames in flight */
+       virtual bool prepareForTx( XBeeDevice* const p_device );
        
+       /** Retrieve the frame identifier used for the most recent transmission of this frame
+
+           \returns The frame identifier, or XBEE_FRAME_ID_NONE in the case that the frame has not
+                    been transmitted or the TX status has already been received */
        virtual uint8_t getFrameId( void ) const;
        
        /** Callback function which is invoked when a response to the TX request is received from
-           the XBee.
+           the XBee.  The implementation in this class calls the function set via setTxCallback(),
+           if any.
            
            \param p_status Status of the TX attempt */
        virtual void frameTxCallback( const XBeeApiTxStatus_e p_status );
+
+       /** Set a function to be called when the TX status for this frame is received.  Note that
+           the function may be called from interrupt context.
+
+           \param p_callback Function to be called, or NULL to remove a previously set function
+           \param p_ctx Context pointer to be passed to p_callback */
+       void setTxCallback( const XBeeApiTxCallback_t p_callback, void* const p_ctx = NULL );
        
        /** Set the frame payload
        
            \param p_buff Pointer to the buffer containing the data.  Note that this buffer is not copied, so
-                         must retain the appropriate content until transmission is complete
+                         must retain the appropriate content until transmission is complete (see
+                         XBeeApiTxFramePooled for a frame which copies its payload)
            \param p_len Length of the data pointed to be p_buff.  Must be 100 or less.
            \returns true in the case that the operation was successful, false in the case that it was not
                     (content too long, etc)
        */
        bool setDataPtr( const uint8_t* const p_buff, const uint16_t p_len );
+
+    protected:
+       /** Function to be called when the TX status is received */
+       XBeeApiTxCallback_t m_txCallback;
+       /** Context pointer to be passed to m_txCallback */
+       void*               m_txCallbackCtx;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+/** 
+
+Copyright 2014 John Bailey
+   
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiTxFramePooled.hpp"
+
+#include <new>
+#include <string.h>
+
+/** Number of 64-bit words needed to hold the pool.  The storage is made up of 64-bit words
+    as the frames contain a uint64_t, so need that alignment */
+#define TX_POOL_STORAGE_DWORDS ((( XBEE_API_BLOCK_POOL_STORAGE_WORDS( sizeof( XBeeApiTxFramePooled ), \
+                                                                      XBEEAPI_CONFIG_TX_POOL_FRAMES ) * sizeof( void* )) + \
+                                   sizeof( uint64_t ) - 1U ) / sizeof( uint64_t ))
+
+/** Storage for the frames in XBeeApiTxFramePooled::s_pool */
+static uint64_t tx_pool_storage[ TX_POOL_STORAGE_DWORDS ];
+
+XBeeApiBlockPool XBeeApiTxFramePooled::s_pool( (void**)tx_pool_storage, sizeof( XBeeApiTxFramePooled ), XBEEAPI_CONFIG_TX_POOL_FRAMES );
+
+XBeeApiTxFramePooled::XBeeApiTxFramePooled( void ) : XBeeApiTxFrame( NULL )
+{
+}
+
+XBeeApiTxFramePooled::~XBeeApiTxFramePooled( void )
+{
+}
+
+XBeeApiTxFramePooled* XBeeApiTxFramePooled::alloc( void )
+{
+    XBeeApiTxFramePooled* ret_val = NULL;
+    void* const block = s_pool.alloc();
+
+    if( block != NULL )
+    {
+        ret_val = new( block ) XBeeApiTxFramePooled();
+    }
+
+    return ret_val;
+}
+
+void XBeeApiTxFramePooled::release( void )
+{
+    this->~XBeeApiTxFramePooled();
+    s_pool.free( this );
+}
+
+bool XBeeApiTxFramePooled::setPayload( const uint8_t* const p_buff, const uint16_t p_len )
+{
+    bool ret_val = false;
+
+    if( p_len <= sizeof( m_payload ))
+    {
+        memcpy( m_payload, p_buff, p_len );
+        ret_val = setDataPtr( m_payload, p_len );
+    }
+
+    return ret_val;
+}
+
+void XBeeApiTxFramePooled::frameTxCallback( const XBeeApiTxStatus_e p_status )
+{
+    XBeeApiTxFrame::frameTxCallback( p_status );
+
+    /* Nothing else refers to the frame once the status has been received */
+    release();
+}
+
+void XBeeApiTxFramePooled::frameTxDropped( void )
+{
+    release();
+}
+
+bool XBeeApiTxFramePooled::send( XBeeDevice* const p_device,
+                                 const uint64_t p_addr,
+                                 const uint8_t* const p_buff,
+                                 const uint16_t p_len,
+                                 const XBeeDevice::XBeeApiAddrType_t p_addrType,
+                                 const XBeeApiTxCallback_t p_callback,
+                                 void* const p_ctx )
+{
+    bool ret_val = false;
+    XBeeApiTxFramePooled* const frame = alloc();
+
+    if( frame != NULL )
+    {
+        frame->setDestAddrType( p_addrType );
+        frame->setDestAddr( p_addr );
+        frame->setTxCallback( p_callback, p_ctx );
+
+        ret_val = ( frame->setPayload( p_buff, p_len ) &&
+                    p_device->SendFrame( frame ));
+
+        if( !ret_val )
+        {
+            frame->release();
+        }
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiTxFramePooled::getFreeCount( void )
+{
+    return s_pool.getFreeCount();
+}
+
+size_t XBeeApiTxFramePooled::getFreeLowWater( void )
+{
+    return s_pool.getFreeLowWater();
+}
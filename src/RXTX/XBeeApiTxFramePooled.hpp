@@ -0,0 +1,132 @@
+/**
+   @file
+   @brief Class inheriting from XBeeApiTxFrame which holds its own copy of
+          the payload & is allocated from a fixed-size pool, allowing frames
+          to be sent without the caller needing to keep anything alive.
+      
+   @author John Bailey 
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+   
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPITXFRAMEPOOLED_HPP
+#define      XBEEAPITXFRAMEPOOLED_HPP
+
+#include "XBeeApiTxFrame.hpp"
+#include "XBeeApiBlockPool.hpp"
+
+#include <stdint.h>
+
+/** TX frame which copies its payload into a buffer of its own.  Frames are allocated from
+    a fixed-size pool (see XBEEAPI_CONFIG_TX_POOL_FRAMES) rather than the heap and return
+    to the pool automatically once the TX status has been received from the XBee - any
+    function set via setTxCallback() is called first.  This allows a frame to be built from
+    data on the caller's stack & sent without the caller waiting for it to complete.
+
+    Frames which are never transmitted must be returned to the pool via release().  Frames
+    which are transmitted but for which the XBee never sends a TX status (e.g. because it's
+    reset) are not returned to the pool.
+
+    Example:
+
+        uint8_t msg[ 10 ];
+        ...
+        if( !XBeeApiTxFramePooled::send( &xbee, 0x1234, msg, sizeof( msg )))
+        {
+            // Pool exhausted or no frame identifiers available
+        }
+*/
+class XBeeApiTxFramePooled : public XBeeApiTxFrame
+{
+    protected:
+        /** Copy of the frame payload */
+        uint8_t m_payload[ XBEE_API_MAX_TX_PAYLOAD_LEN ];
+
+        /** Pool from which the frames are allocated */
+        static XBeeApiBlockPool s_pool;
+
+        /** Constructor.  Frames are only constructed by alloc() */
+        XBeeApiTxFramePooled( void );
+
+        /** Destructor.  Frames are only destroyed by release() */
+        virtual ~XBeeApiTxFramePooled( void );
+
+    public:
+        /** Allocate a frame from the pool.  The frame is not registered with any device as
+            the TX status is routed to it via its frame identifier.  May be called from 
+            interrupt context.
+
+            \returns The frame, or NULL in the case that the pool is exhausted */
+        static XBeeApiTxFramePooled* alloc( void );
+
+        /** Return the frame to the pool.  The frame must not be used after this has been 
+            called.  Only needed in the case that the frame was not transmitted, e.g. 
+            XBeeDevice::SendFrame() failed or the frame was removed via 
+            XBeeDevice::cancelFrame() */
+        void release( void );
+
+        /** Set the frame payload, copying the data into the frame
+
+            \param p_buff Pointer to the buffer containing the data.  Need not remain valid
+                          after this call
+            \param p_len Length of the data pointed to by p_buff.  Must be 
+                         XBEE_API_MAX_TX_PAYLOAD_LEN or less
+            \returns true in the case that the payload was set, false in the case that it
+                     is too long */
+        bool setPayload( const uint8_t* const p_buff, const uint16_t p_len );
+
+        /** Calls any function set via setTxCallback() and then returns the frame to the pool
+
+            \param p_status Status of the TX attempt */
+        virtual void frameTxCallback( const XBeeApiTxStatus_e p_status );
+
+        /** Returns the frame to the pool - see XBeeApiFrame::frameTxDropped() */
+        virtual void frameTxDropped( void );
+
+        /** Allocate a frame, fill it in & transmit it.  The frame returns to the pool once 
+            the TX status has been received.  Does not block waiting for the TX status.
+
+            \param p_device Device via which the frame is to be transmitted
+            \param p_addr Destination address
+            \param p_buff Payload.  Copied into the frame, so need not remain valid after this
+                          call
+            \param p_len Length of the data pointed to by p_buff.  Must be 
+                         XBEE_API_MAX_TX_PAYLOAD_LEN or less
+            \param p_addrType Type of address in p_addr
+            \param p_callback Function to be called when the TX status is received, or NULL
+            \param p_ctx Context pointer to be passed to p_callback
+            \returns true in the case that the frame was transmitted, false in the case that 
+                     it was not (pool exhausted, payload too long, no frame identifiers 
+                     available, etc) */
+        static bool send( XBeeDevice* const p_device,
+                          const uint64_t p_addr,
+                          const uint8_t* const p_buff,
+                          const uint16_t p_len,
+                          const XBeeDevice::XBeeApiAddrType_t p_addrType = XBeeDevice::XBEE_API_ADDR_TYPE_16BIT,
+                          const XBeeApiTxCallback_t p_callback = NULL,
+                          void* const p_ctx = NULL );
+
+        /** Retrieve the number of frames currently free in the pool */
+        static size_t getFreeCount( void );
+
+        /** Retrieve the lowest number of frames which have been free in the pool at any one 
+            time.  Useful for tuning XBEEAPI_CONFIG_TX_POOL_FRAMES */
+        static size_t getFreeLowWater( void );
+};
+
+#endif
@@ -0,0 +1,108 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiTransportMbed.hpp"
+
+#if !defined XBEEAPI_CONFIG_POSIX
+
+#include "XBeeApiEvent.hpp"
+
+XBeeApiTransportMbed::XBeeApiTransportMbed( PinName p_tx, PinName p_rx, PinName p_rts, PinName p_cts ) : m_serialNeedsDelete( true ),
+                                                                                                       m_rxCallback( NULL ),
+                                                                                                       m_rxCtx( NULL )
+{
+    m_serial = new Serial( p_tx, p_rx );
+
+    /* Can only do flow control on devices which support it */
+#if defined ( DEVICE_SERIAL_FC )
+    /* TODO: need rts and cts both set? */
+    m_serial->set_flow_control( mbed::SerialBase::Flow.RTSCTS, p_rts, p_cts );
+#endif
+}
+
+XBeeApiTransportMbed::XBeeApiTransportMbed( Serial* p_serialIf ) : m_serial( p_serialIf ),
+                                                                 m_serialNeedsDelete( false ),
+                                                                 m_rxCallback( NULL ),
+                                                                 m_rxCtx( NULL )
+{
+}
+
+XBeeApiTransportMbed::~XBeeApiTransportMbed( void )
+{
+    if( m_serialNeedsDelete )
+    {
+        delete( m_serial );
+    }
+}
+
+size_t XBeeApiTransportMbed::read( uint8_t* const p_buff, const size_t p_len )
+{
+    size_t ret_val = 0;
+
+    while(( ret_val < p_len ) &&
+          ( m_serial->readable() ))
+    {
+        p_buff[ ret_val++ ] = m_serial->getc();
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiTransportMbed::write( const uint8_t* const p_buff, const size_t p_len )
+{
+    return fwrite( p_buff, 1, p_len, *m_serial );
+}
+
+void XBeeApiTransportMbed::flush( void )
+{
+    fflush( *m_serial );
+}
+
+bool XBeeApiTransportMbed::waitReadable( const uint32_t p_timeout_ms )
+{
+    XBeeApiTimeout timeout( p_timeout_ms );
+    bool ret_val;
+
+    while(( !( ret_val = m_serial->readable() )) &&
+          ( timeout.getRemaining() > 0 ))
+    {
+        xbeeApiWaitMs( 1U );
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiTransportMbed::attachRx( const XBeeApiTransportRxCallback_t p_callback, void* const p_ctx )
+{
+    m_rxCtx = p_ctx;
+    m_rxCallback = p_callback;
+
+    m_serial->attach( this, &XBeeApiTransportMbed::serialRx, Serial::RxIrq );
+
+    return true;
+}
+
+void XBeeApiTransportMbed::serialRx( void )
+{
+    if( m_rxCallback != NULL )
+    {
+        m_rxCallback( m_rxCtx );
+    }
+}
+
+#endif
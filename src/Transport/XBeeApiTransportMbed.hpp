@@ -0,0 +1,93 @@
+/**
+   @file
+   @brief XBeeApiTransport implementation using an mbed Serial object
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPITRANSPORTMBED_HPP
+#define      XBEEAPITRANSPORTMBED_HPP
+
+#include "XBeeApiCfg.hpp"
+
+#if !defined XBEEAPI_CONFIG_POSIX
+
+#include "XBeeApiTransport.hpp"
+
+#include "mbed.h" // For serial interface
+
+/** Transport using an mbed Serial object.  Received data is signalled from the serial
+    RX interrupt */
+class XBeeApiTransportMbed : public XBeeApiTransport
+{
+    protected:
+        /** The serial interface */
+        Serial* m_serial;
+
+        /** Flag to indicate if m_serial was created by this class and hence needs 
+            deleting in the destructor */
+        bool m_serialNeedsDelete;
+
+        /** Function to call when data is received */
+        XBeeApiTransportRxCallback_t m_rxCallback;
+
+        /** Context pointer to pass to m_rxCallback */
+        void* m_rxCtx;
+
+        /** Call-back from mbed, triggered when data is received on the serial interface */
+        void serialRx( void );
+
+    public:
+        /** Constructor
+
+            \param p_tx Serial interface TX pin
+            \param p_rx Serial interface RX pin
+            \param p_rts Pin to use for RTS (flow control).  Will only be used if supported.  Can specify NC to disable.
+            \param p_cts Pin to use for CTS (flow control).  Will only be used if supported.  Can specify NC to disable. */
+        XBeeApiTransportMbed( PinName p_tx, PinName p_rx, PinName p_rts, PinName p_cts );
+
+        /** Constructor
+
+            \param p_serialIf Serial interface to be used.  The referenced object must remain
+                              valid for as long as this object is being used.  Must not be NULL */
+        XBeeApiTransportMbed( Serial* p_serialIf );
+
+        /** Destructor */
+        virtual ~XBeeApiTransportMbed( void );
+
+        /** See XBeeApiTransport::read() */
+        virtual size_t read( uint8_t* const p_buff, const size_t p_len );
+
+        /** See XBeeApiTransport::write() */
+        virtual size_t write( const uint8_t* const p_buff, const size_t p_len );
+
+        /** See XBeeApiTransport::flush() */
+        virtual void flush( void );
+
+        /** See XBeeApiTransport::waitReadable() */
+        virtual bool waitReadable( const uint32_t p_timeout_ms );
+
+        /** See XBeeApiTransport::attachRx() */
+        virtual bool attachRx( const XBeeApiTransportRxCallback_t p_callback, void* const p_ctx );
+};
+
+#endif
+
+#endif
@@ -0,0 +1,268 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiTransportTermios.hpp"
+
+#if defined XBEEAPI_CONFIG_POSIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/** Maximum number of segments passed to writev() in one go */
+#define XBEE_TERMIOS_IOV_MAX (16U)
+
+/** Mapping between baud rates & termios speed constants */
+static const struct
+{
+    uint32_t m_baud;
+    speed_t  m_speed;
+} xbeeTermiosSpeeds[] = {
+    { 1200U,   B1200 },
+    { 2400U,   B2400 },
+    { 4800U,   B4800 },
+    { 9600U,   B9600 },
+    { 19200U,  B19200 },
+    { 38400U,  B38400 },
+    { 57600U,  B57600 },
+    { 115200U, B115200 },
+    { 230400U, B230400 }
+};
+
+XBeeApiTransportTermios::XBeeApiTransportTermios( const char* const p_device, const uint32_t p_baud, const bool p_rtsCts ) : m_fdNeedsClose( true )
+{
+    m_fd = open( p_device, O_RDWR | O_NOCTTY | O_NONBLOCK );
+
+    if(( m_fd != XBEE_TRANSPORT_FD_INVALID ) &&
+       ( !configure( p_baud, p_rtsCts )))
+    {
+        close( m_fd );
+        m_fd = XBEE_TRANSPORT_FD_INVALID;
+    }
+}
+
+XBeeApiTransportTermios::XBeeApiTransportTermios( const int p_fd, const bool p_takeOwnership ) : m_fd( p_fd ),
+                                                                                              m_fdNeedsClose( p_takeOwnership )
+{
+    if( m_fd != XBEE_TRANSPORT_FD_INVALID )
+    {
+        const int flags = fcntl( m_fd, F_GETFL );
+
+        if( flags != -1 )
+        {
+            fcntl( m_fd, F_SETFL, flags | O_NONBLOCK );
+        }
+    }
+}
+
+XBeeApiTransportTermios::~XBeeApiTransportTermios( void )
+{
+    if( m_fdNeedsClose && 
+        ( m_fd != XBEE_TRANSPORT_FD_INVALID ))
+    {
+        close( m_fd );
+    }
+}
+
+bool XBeeApiTransportTermios::isOpen( void ) const
+{
+    return( m_fd != XBEE_TRANSPORT_FD_INVALID );
+}
+
+int XBeeApiTransportTermios::getFd( void ) const
+{
+    return m_fd;
+}
+
+bool XBeeApiTransportTermios::configure( const uint32_t p_baud, const bool p_rtsCts )
+{
+    bool ret_val = false;
+    struct termios tio;
+
+    for( size_t i = 0;
+         i < ( sizeof( xbeeTermiosSpeeds ) / sizeof( xbeeTermiosSpeeds[ 0 ] ));
+         i++ )
+    {
+        if(( xbeeTermiosSpeeds[ i ].m_baud == p_baud ) &&
+           ( tcgetattr( m_fd, &tio ) == 0 ))
+        {
+            /* Raw 8N1, no echo or line processing.  Reads never block (the descriptor is
+               non-blocking in any case) */
+            cfmakeraw( &tio );
+            tio.c_cflag |= ( CLOCAL | CREAD );
+            if( p_rtsCts )
+            {
+                tio.c_cflag |= CRTSCTS;
+            }
+            else
+            {
+                tio.c_cflag &= ~CRTSCTS;
+            }
+            tio.c_cc[ VMIN ] = 0;
+            tio.c_cc[ VTIME ] = 0;
+            cfsetispeed( &tio, xbeeTermiosSpeeds[ i ].m_speed );
+            cfsetospeed( &tio, xbeeTermiosSpeeds[ i ].m_speed );
+
+            ret_val = ( tcsetattr( m_fd, TCSANOW, &tio ) == 0 );
+            break;
+        }
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiTransportTermios::read( uint8_t* const p_buff, const size_t p_len )
+{
+    size_t ret_val = 0;
+    ssize_t res;
+
+    do
+    {
+        res = ::read( m_fd, p_buff, p_len );
+    } while(( res < 0 ) && ( errno == EINTR ));
+
+    /* Anything other than data (EAGAIN, EOF, errors) is treated as there being nothing 
+       to read */
+    if( res > 0 )
+    {
+        ret_val = (size_t)res;
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiTransportTermios::write( const uint8_t* const p_buff, const size_t p_len )
+{
+    size_t ret_val = 0;
+
+    while( ret_val < p_len )
+    {
+        const ssize_t res = ::write( m_fd, &( p_buff[ ret_val ] ), p_len - ret_val );
+
+        if( res > 0 )
+        {
+            ret_val += (size_t)res;
+        }
+        else if(( res < 0 ) && ( errno == EAGAIN ))
+        {
+            /* Output buffer is full - wait for the device to drain it */
+            struct pollfd pfd;
+            pfd.fd = m_fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            poll( &pfd, 1, -1 );
+        }
+        else if(( res < 0 ) && ( errno == EINTR ))
+        {
+            /* Interrupted - try again */
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiTransportTermios::writeSegments( const XBeeApiFrameSegment_t* const p_segs, const size_t p_count )
+{
+    size_t ret_val = 0;
+    /* Next segment to be written & the number of bytes of it already written */
+    size_t seg = 0;
+    size_t offset = 0;
+
+    while( seg < p_count )
+    {
+        struct iovec iov[ XBEE_TERMIOS_IOV_MAX ];
+        int iovCount = 0;
+        ssize_t res;
+
+        for( size_t i = seg; 
+             ( i < p_count ) && ( iovCount < (int)XBEE_TERMIOS_IOV_MAX ); 
+             i++ )
+        {
+            const size_t skip = ( i == seg ) ? offset : 0U;
+
+            iov[ iovCount ].iov_base = (void*)&( p_segs[ i ].m_data[ skip ] );
+            iov[ iovCount ].iov_len = p_segs[ i ].m_len - skip;
+            iovCount++;
+        }
+
+        res = ::writev( m_fd, iov, iovCount );
+
+        if( res >= 0 )
+        {
+            size_t done = (size_t)res;
+
+            ret_val += done;
+
+            /* Move past the segments which have been written completely */
+            while(( seg < p_count ) &&
+                  (( p_segs[ seg ].m_len - offset ) <= done ))
+            {
+                done -= p_segs[ seg ].m_len - offset;
+                seg++;
+                offset = 0;
+            }
+            offset += done;
+
+            if(( res == 0 ) && ( seg < p_count ))
+            {
+                break;
+            }
+        }
+        else if( errno == EAGAIN )
+        {
+            /* Output buffer is full - wait for the device to drain it */
+            struct pollfd pfd;
+            pfd.fd = m_fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            poll( &pfd, 1, -1 );
+        }
+        else if( errno != EINTR )
+        {
+            break;
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiTransportTermios::waitReadable( const uint32_t p_timeout_ms )
+{
+    struct pollfd pfd;
+    int res;
+
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    do
+    {
+        res = poll( &pfd, 1, (int)p_timeout_ms );
+    } while(( res < 0 ) && ( errno == EINTR ));
+
+    return(( res > 0 ) && ( pfd.revents & POLLIN ));
+}
+
+#endif
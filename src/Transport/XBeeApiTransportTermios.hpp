@@ -0,0 +1,115 @@
+/**
+   @file
+   @brief XBeeApiTransport implementation using a POSIX (termios) serial device
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPITRANSPORTTERMIOS_HPP
+#define      XBEEAPITRANSPORTTERMIOS_HPP
+
+#include "XBeeApiCfg.hpp"
+
+#if defined XBEEAPI_CONFIG_POSIX
+
+#include "XBeeApiTransport.hpp"
+
+/** Transport using a POSIX serial device (e.g. /dev/ttyUSB0) or any other file descriptor
+    which behaves like one, such as one side of a pseudo-terminal.  The descriptor is used 
+    in non-blocking mode, with data read in bulk as it becomes available.  There is no
+    interrupt to signal received data, so the application must poll for it - see 
+    XBeeDevice::pollRx() - or wait for the descriptor to become readable in its own event
+    loop - see XBeeDevice::getEventFd().
+
+    Example:
+
+        XBeeApiTransportTermios transport( "/dev/ttyUSB0", 9600 );
+        XBeeDevice xbee( &transport );
+
+        for(;;)
+        {
+            xbee.pollRx( 100 );
+        }
+*/
+class XBeeApiTransportTermios : public XBeeApiTransport
+{
+    protected:
+        /** File descriptor of the serial device */
+        int  m_fd;
+
+        /** Flag to indicate if m_fd was opened by this class and hence needs closing in the
+            destructor */
+        bool m_fdNeedsClose;
+
+    public:
+        /** Constructor.  Opens & configures a serial device - see isOpen() to check for 
+            success
+
+            \param p_device Path of the device to open
+            \param p_baud Baud rate, e.g. 9600
+            \param p_rtsCts true to enable RTS/CTS flow control */
+        XBeeApiTransportTermios( const char* const p_device, const uint32_t p_baud, const bool p_rtsCts = false );
+
+        /** Constructor.  Uses a file descriptor which has already been opened, e.g. one side
+            of a pseudo-terminal.  The descriptor is switched to non-blocking mode but 
+            otherwise left as-is - see configure()
+
+            \param p_fd The file descriptor.  Must remain open for as long as this object is 
+                        being used
+            \param p_takeOwnership true in the case that the descriptor should be closed when
+                                   this object is destroyed */
+        XBeeApiTransportTermios( const int p_fd, const bool p_takeOwnership = false );
+
+        /** Destructor */
+        virtual ~XBeeApiTransportTermios( void );
+
+        /** Determine whether or not the device was opened successfully */
+        bool isOpen( void ) const;
+
+        /** Retrieve the file descriptor in use, e.g. in order to wait on it along with 
+            other descriptors.  XBEE_TRANSPORT_FD_INVALID in the case that it's not open */
+        virtual int getFd( void ) const;
+
+        /** Configure the device for raw 8N1 operation
+
+            \param p_baud Baud rate, e.g. 9600
+            \param p_rtsCts true to enable RTS/CTS flow control
+            \returns true in the case that the configuration was applied, false in the case
+                     that the baud rate is not supported or the descriptor is not a terminal */
+        bool configure( const uint32_t p_baud, const bool p_rtsCts = false );
+
+        /** See XBeeApiTransport::read() */
+        virtual size_t read( uint8_t* const p_buff, const size_t p_len );
+
+        /** See XBeeApiTransport::write() */
+        virtual size_t write( const uint8_t* const p_buff, const size_t p_len );
+
+        /** See XBeeApiTransport::writeSegments().  The segments are written using writev(),
+            so a frame is usually written with a single system call and without being 
+            copied */
+        virtual size_t writeSegments( const XBeeApiFrameSegment_t* const p_segs, const size_t p_count );
+
+        /** See XBeeApiTransport::waitReadable() */
+        virtual bool waitReadable( const uint32_t p_timeout_ms );
+};
+
+#endif
+
+#endif
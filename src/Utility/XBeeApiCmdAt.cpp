@@ -18,28 +18,21 @@ limitations under the License.
 
 #include "XBeeApiCmdAt.hpp"
 
-/* Set of Frame ID codes for the various commands (see XBEE_CMD_POSN_FRAME_ID) */
-
-#define CMD_RESPONSE_GET_VR  '1'
-#define CMD_RESPONSE_GET_HV  '2'
-#define CMD_RESPONSE_GET_CH  '3'
-#define CMD_RESPONSE_SET_CH  '4'
-#define CMD_RESPONSE_SET_CE  '5'
-#define CMD_RESPONSE_GET_CE  '6'
-#define CMD_RESPONSE_SET_EDA '7'
-#define CMD_RESPONSE_GET_EDA '8'
-#define CMD_RESPONSE_SET_PID '9'
-#define CMD_RESPONSE_GET_PID '0'
-#define CMD_RESPONSE_SET_MY  'a'
-#define CMD_RESPONSE_GET_MY  'b'
-#define CMD_RESPONSE_GET_SH  'c'
-#define CMD_RESPONSE_GET_SL  'd'
-#define CMD_RESPONSE_SET_RR  'e'
-#define CMD_RESPONSE_GET_RR  'f'
-#define CMD_RESPONSE_SET_RN  'g'
-#define CMD_RESPONSE_GET_RN  'h'
-#define CMD_RESPONSE_SET_MM  'i'
-#define CMD_RESPONSE_GET_MM  'j'
+/* Mnemonics for the various commands */
+
+#define CMD_VR XBEE_AT_MNEMONIC( 'V', 'R' )
+#define CMD_HV XBEE_AT_MNEMONIC( 'H', 'V' )
+#define CMD_CH XBEE_AT_MNEMONIC( 'C', 'H' )
+#define CMD_CE XBEE_AT_MNEMONIC( 'C', 'E' )
+#define CMD_EDA XBEE_AT_MNEMONIC( 'A', '1' )
+#define CMD_PID XBEE_AT_MNEMONIC( 'I', 'D' )
+#define CMD_MY XBEE_AT_MNEMONIC( 'M', 'Y' )
+#define CMD_SH XBEE_AT_MNEMONIC( 'S', 'H' )
+#define CMD_SL XBEE_AT_MNEMONIC( 'S', 'L' )
+#define CMD_RR XBEE_AT_MNEMONIC( 'R', 'R' )
+#define CMD_RN XBEE_AT_MNEMONIC( 'R', 'N' )
+#define CMD_MM XBEE_AT_MNEMONIC( 'M', 'M' )
+#define CMD_AC XBEE_AT_MNEMONIC( 'A', 'C' )
 
 /** Lowest channel supported by the XBee S1 */
 #define XBEE_CHAN_MIN 0x0b
@@ -51,44 +44,18 @@ limitations under the License.
 /** Highest channel supported by the XBee S1 Pro */
 #define XBEE_PRO_CHAN_MAX 0x17
 
-/* Content for the various commands - value of 0 indicates a value to be populated (i.e. variable) */
+/** API identifiers of the frames decoded by this class */
+static const XBeeApiIdentifier_e at_api_ids[] = { XBEE_CMD_AT_RESPONSE };
 
-static const uint8_t cmd_vr[] =      { CMD_RESPONSE_GET_VR, 'V', 'R' };
-static const uint8_t cmd_hv[] =      { CMD_RESPONSE_GET_HV, 'H', 'V' };
-static const uint8_t cmd_sh[] =      { CMD_RESPONSE_GET_SH, 'S', 'H' };
-static const uint8_t cmd_sl[] =      { CMD_RESPONSE_GET_SL, 'S', 'L' };
-
-static const uint8_t cmd_ch[] =      { CMD_RESPONSE_GET_CH, 'C', 'H' };
-static const uint8_t cmd_set_ch[] =  { CMD_RESPONSE_SET_CH, 'C', 'H', 0 };
-
-static const uint8_t cmd_ce[] =      { CMD_RESPONSE_GET_CE, 'C', 'E' };
-static const uint8_t cmd_set_ce[] =  { CMD_RESPONSE_SET_CE, 'C', 'E', 0 };
-
-static const uint8_t cmd_eda[] =     { CMD_RESPONSE_GET_EDA, 'A', '1' };
-static const uint8_t cmd_set_eda[] = { CMD_RESPONSE_SET_EDA, 'A', '1', 0 };
-
-static const uint8_t cmd_pid[] =     { CMD_RESPONSE_GET_PID, 'I', 'D' };
-static const uint8_t cmd_set_pid[] = { CMD_RESPONSE_SET_PID, 'I', 'D', 0, 0 };
-
-static const uint8_t cmd_my[] =      { CMD_RESPONSE_GET_MY,  'M', 'Y' };
-static const uint8_t cmd_set_my[] =  { CMD_RESPONSE_SET_MY,  'M', 'Y', 0, 0 };
-
-static const uint8_t cmd_rr[] =      { CMD_RESPONSE_GET_RR,  'R', 'R' };
-static const uint8_t cmd_set_rr[] =  { CMD_RESPONSE_SET_RR,  'R', 'R', 0 };
-
-static const uint8_t cmd_rn[] =      { CMD_RESPONSE_GET_RN,  'R', 'N' };
-static const uint8_t cmd_set_rn[] =  { CMD_RESPONSE_SET_RN,  'R', 'N', 0 };
-
-static const uint8_t cmd_mm[] =      { CMD_RESPONSE_GET_MM,  'M', 'M' };
-static const uint8_t cmd_set_mm[] =  { CMD_RESPONSE_SET_MM,  'M', 'M', 0 };
-
-#define XBEE_CMD_POSN_FRAME_ID (4U)
+#define XBEE_CMD_POSN_CMD (5U)
 #define XBEE_CMD_POSN_STATUS (7U)
 #define XBEE_CMD_POSN_PARAM_START (8U)
 
-#define XBEE_CMD_RESPONS_HAS_DATA( _p_len ) ((_p_len > ( XBEE_CMD_POSN_PARAM_START + 1 ))
+/** Length of the parameter data in an AT command response of total length _p_len (which 
+    includes the trailing checksum) */
+#define XBEE_CMD_RESPONSE_DATA_LEN( _p_len ) ((_p_len) - ( XBEE_CMD_POSN_PARAM_START + 1U ))
 
-XBeeApiCmdAt::XBeeApiCmdAt( XBeeDevice* const p_device ) : XBeeApiFrameDecoder( p_device ) , 
+XBeeApiCmdAt::XBeeApiCmdAt( XBeeDevice* const p_device ) : XBeeApiFrameDecoder( p_device, at_api_ids, sizeof( at_api_ids ) / sizeof( at_api_ids[ 0 ] ) ), 
     m_have_hwVer( false ),
     m_have_fwVer( false ),
     m_have_chan( false ),
@@ -100,99 +67,384 @@ XBeeApiCmdAt::XBeeApiCmdAt( XBeeDevice* const p_device ) : XBeeApiFrameDecoder(
     m_have_snHigh( false ),
     m_have_retries( false ),
     m_have_randomDelaySlots( false ),
-    m_have_macMode( false )
+    m_have_macMode( false ),
+    m_callback( NULL ),
+    m_callbackCtx( NULL ),
+    m_lastFrameId( XBEE_FRAME_ID_NONE ),
+    m_batching( false ),
+    m_batchCount( 0 )
 {
+    for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        m_pendingIds[ i ] = XBEE_FRAME_ID_NONE;
+    }
 }
 
-#define PROCESS_SET_GET_RESPONSE_GENERIC( _type, _var, _src, _t ) \
-            case CMD_RESPONSE_SET_ ## _type: \
-            case CMD_RESPONSE_GET_ ## _type: \
-                if( p_data[ XBEE_CMD_POSN_STATUS ] == 0 ) \
+/* A response carrying parameter data is the result of a get, one without is the result of a set,
+   in which case the value that was set becomes the cached value - unless the change was queued 
+   as part of a batch, in which case that's done once the batch has been applied (see 
+   commitBatch()).  _width is the number of bytes the XBee uses for the parameter, which isn't
+   necessarily the size of the cached variable */
+#define PROCESS_SET_GET_RESPONSE_GENERIC( _cmd, _var, _src, _t, _width ) \
+            case _cmd: \
+                if( status == XBEE_API_CMD_AT_STATUS_OK ) \
                 { \
-                    if( CMD_RESPONSE_GET_ ## _type == p_data[ XBEE_CMD_POSN_API_ID ] ) \
+                    if( dataLen >= _width ) \
                     { \
                         m_ ##_var = (_t) (_src); \
+                        m_have_ ## _var = true; \
                     } \
-                    else \
+                    else if(( dataLen == 0 ) && ( !queued )) \
                     { \
                         m_ ## _var = m_ ## _var ## Pend; \
+                        m_have_ ## _var = true; \
                     } \
-                    m_have_ ## _var = true; \
-                } \
-                else \
-                { \
-                    /* TODO */ \
                 } \
                 ret_val = true; \
                 break;
 
-#define PROCESS_GET_RESPONSE_GENERIC( _type, _var, _src ) \
-            case CMD_RESPONSE_GET_ ## _type: \
-                if( p_data[ XBEE_CMD_POSN_STATUS ] == 0 ) \
+#define PROCESS_GET_RESPONSE_GENERIC( _cmd, _var, _src, _width ) \
+            case _cmd: \
+                if(( status == XBEE_API_CMD_AT_STATUS_OK ) && \
+                   ( dataLen >= _width )) \
                 { \
                     m_ ##_var = _src; \
                     m_have_ ## _var = true; \
                 } \
-                else \
-                { \
-                    /* TODO */ \
-                } \
                 ret_val = true; \
                 break;
 
-#define PROCESS_SET_GET_RESPONSE_8BIT_WITHCAST( _type, _var, _t )  PROCESS_SET_GET_RESPONSE_GENERIC( _type, _var, p_data[ XBEE_CMD_POSN_PARAM_START ], _t )
-#define PROCESS_SET_GET_RESPONSE_8BIT( _type, _var )               PROCESS_SET_GET_RESPONSE_GENERIC( _type, _var, p_data[ XBEE_CMD_POSN_PARAM_START ], uint8_t )
-#define PROCESS_SET_GET_RESPONSE_16BIT( _type, _var )              PROCESS_SET_GET_RESPONSE_GENERIC( _type, _var, ((uint16_t)p_data[ XBEE_CMD_POSN_PARAM_START ] << 8) | p_data[ XBEE_CMD_POSN_PARAM_START + 1 ], uint16_t )
+#define PROCESS_SET_GET_RESPONSE_8BIT_WITHCAST( _cmd, _var, _t )  PROCESS_SET_GET_RESPONSE_GENERIC( _cmd, _var, p_data[ XBEE_CMD_POSN_PARAM_START ], _t, 1U )
+#define PROCESS_SET_GET_RESPONSE_8BIT( _cmd, _var )               PROCESS_SET_GET_RESPONSE_GENERIC( _cmd, _var, p_data[ XBEE_CMD_POSN_PARAM_START ], uint8_t, 1U )
+#define PROCESS_SET_GET_RESPONSE_16BIT( _cmd, _var )              PROCESS_SET_GET_RESPONSE_GENERIC( _cmd, _var, ((uint16_t)p_data[ XBEE_CMD_POSN_PARAM_START ] << 8) | p_data[ XBEE_CMD_POSN_PARAM_START + 1 ], uint16_t, 2U )
+
+#define PROCESS_GET_RESPONSE_16BIT( _cmd, _var ) PROCESS_GET_RESPONSE_GENERIC( _cmd, _var, ((uint16_t)p_data[ XBEE_CMD_POSN_PARAM_START ] << 8) | p_data[ XBEE_CMD_POSN_PARAM_START + 1 ], 2U )
+#define PROCESS_GET_RESPONSE_32BIT( _cmd, _var ) PROCESS_GET_RESPONSE_GENERIC( _cmd, _var, ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START ] << 24) |\
+                                                                                           ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START + 1 ] << 16) |\
+                                                                                           ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START + 2 ] << 8) |\
+                                                                                           ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START + 3 ]), 4U )
 
-#define PROCESS_GET_RESPONSE_16BIT( _type, _var ) PROCESS_GET_RESPONSE_GENERIC( _type, _var, ((uint16_t)p_data[ XBEE_CMD_POSN_PARAM_START ] << 8) | p_data[ XBEE_CMD_POSN_PARAM_START + 1 ] )
-#define PROCESS_GET_RESPONSE_32BIT( _type, _var ) PROCESS_GET_RESPONSE_GENERIC( _type, _var, ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START ] << 24) |\
-                                                                                             ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START + 1 ] << 16) |\
-                                                                                             ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START + 2 ] << 8) |\
-                                                                                             ((uint32_t)p_data[ XBEE_CMD_POSN_PARAM_START + 3 ]))
 
 
-bool XBeeApiCmdAt::decodeCallback( const uint8_t* const p_data, size_t p_len )
+bool XBeeApiCmdAt::decodeCallback( const XBeeApiFrameView& p_data )
 {
     bool ret_val = false;
 
-    if( XBEE_CMD_AT_RESPONSE == p_data[ XBEE_CMD_POSN_API_ID ] ) {
+    if(( XBEE_CMD_AT_RESPONSE == p_data[ XBEE_CMD_POSN_API_ID ] ) &&
+       ( p_data.getLen() > XBEE_CMD_POSN_PARAM_START )) {
+
+        /* Responses are decoded based on the command they relate to - the frame identifier
+           is only used to route the response here */
+        const uint16_t mnemonic = XBEE_AT_MNEMONIC( p_data[ XBEE_CMD_POSN_CMD ], 
+                                                    p_data[ XBEE_CMD_POSN_CMD + 1U ] );
+        const XBeeApiCmdAtStatus_e status = (XBeeApiCmdAtStatus_e)p_data[ XBEE_CMD_POSN_STATUS ];
+        const size_t dataLen = XBEE_CMD_RESPONSE_DATA_LEN( p_data.getLen() );
+        bool queued = false;
 
-        switch( p_data[ XBEE_CMD_POSN_FRAME_ID ] ) {
+        /* The XBeeDevice releases the frame identifier once the response has been decoded */
+        removePending( p_data[ XBEE_CMD_POSN_FRAME_ID ], status, &queued );
+
+        switch( mnemonic ) {
             
-            PROCESS_GET_RESPONSE_16BIT( HV, hwVer )
-            PROCESS_GET_RESPONSE_16BIT( VR, fwVer )
+            PROCESS_GET_RESPONSE_16BIT( CMD_HV, hwVer )
+            PROCESS_GET_RESPONSE_16BIT( CMD_VR, fwVer )
             
-            PROCESS_SET_GET_RESPONSE_8BIT( CH, chan )
-            PROCESS_SET_GET_RESPONSE_8BIT( CE, CE )
-            PROCESS_SET_GET_RESPONSE_8BIT( PID, PANId )
-            PROCESS_SET_GET_RESPONSE_8BIT( EDA, EDA )
-            PROCESS_SET_GET_RESPONSE_8BIT( RR, retries )
-            PROCESS_SET_GET_RESPONSE_16BIT( MY, sourceAddress )
-            PROCESS_GET_RESPONSE_32BIT( SH, snHigh )
-            PROCESS_GET_RESPONSE_32BIT( SL, snLow )
-            PROCESS_SET_GET_RESPONSE_8BIT( RN, randomDelaySlots )
-            PROCESS_SET_GET_RESPONSE_8BIT_WITHCAST( MM, macMode, XBeeApiMACMode_e )
+            PROCESS_SET_GET_RESPONSE_8BIT( CMD_CH, chan )
+            PROCESS_SET_GET_RESPONSE_8BIT( CMD_CE, CE )
+            PROCESS_SET_GET_RESPONSE_16BIT( CMD_PID, PANId )
+            PROCESS_SET_GET_RESPONSE_8BIT( CMD_EDA, EDA )
+            PROCESS_SET_GET_RESPONSE_8BIT( CMD_RR, retries )
+            PROCESS_SET_GET_RESPONSE_16BIT( CMD_MY, sourceAddress )
+            PROCESS_GET_RESPONSE_32BIT( CMD_SH, snHigh )
+            PROCESS_GET_RESPONSE_32BIT( CMD_SL, snLow )
+            PROCESS_SET_GET_RESPONSE_8BIT( CMD_RN, randomDelaySlots )
+            PROCESS_SET_GET_RESPONSE_8BIT_WITHCAST( CMD_MM, macMode, XBeeApiMACMode_e )
+
+            case CMD_AC:
+                /* The status is also passed on via the call-back */
+                commitBatch( status );
+                ret_val = true;
+                break;
+        }
+
+        if( ret_val && 
+            ( m_callback != NULL ))
+        {
+            m_callback( this, mnemonic, p_data[ XBEE_CMD_POSN_FRAME_ID ], status, m_callbackCtx );
+        }
+    }
+    return ret_val;
+}
+
+void XBeeApiCmdAt::setCmdCallback( const XBeeApiCmdAtCallback_t p_callback, void* const p_ctx )
+{
+    m_callback = p_callback;
+    m_callbackCtx = p_ctx;
+}
+
+uint8_t XBeeApiCmdAt::getLastFrameId( void ) const
+{
+    return m_lastFrameId;
+}
+
+size_t XBeeApiCmdAt::getPendingCount( void ) const
+{
+    size_t ret_val = 0;
+
+    for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        if( m_pendingIds[ i ] != XBEE_FRAME_ID_NONE )
+        {
+            ret_val++;
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiCmdAt::sendReq( XBeeApiCmdAtReq* const p_req )
+{
+    bool ret_val = false;
+
+    if( m_device != NULL )
+    {
+        const uint8_t frameId = m_device->allocFrameId( this );
+
+        if( frameId != XBEE_FRAME_ID_NONE )
+        {
+            bool recorded = true;
+
+            {
+                XBeeApiCriticalSection cs( m_lock );
+
+                /* There's always a free entry, as the XBeeDevice won't allocate any more 
+                   identifiers than there are entries.  An entry using the same identifier 
+                   must be stale, as the device has handed it out again */
+                for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+                {
+                    if(( m_pendingIds[ i ] == XBEE_FRAME_ID_NONE ) ||
+                       ( m_pendingIds[ i ] == frameId ))
+                    {
+                        m_pendingIds[ i ] = frameId;
+                        break;
+                    }
+                }
+
+                /* A queued change is recorded so that it can be cached once the batch has 
+                   been applied.  Changing the same parameter again replaces the entry */
+                if( p_req->getApiId() == XBEE_CMD_QUEUE_PARAM_VAL )
+                {
+                    const uint16_t mnemonic = p_req->getMnemonic();
+                    size_t i = 0;
+
+                    while(( i < m_batchCount ) &&
+                          ( m_batch[ i ].m_mnemonic != mnemonic ))
+                    {
+                        i++;
+                    }
+
+                    if( i < XBEE_API_CMD_MAX_BATCH )
+                    {
+                        m_batch[ i ].m_mnemonic = mnemonic;
+                        m_batch[ i ].m_frameId = frameId;
+                        m_batch[ i ].m_status = XBEE_API_CMD_AT_STATUS_NO_RESPONSE;
+                        if( i == m_batchCount )
+                        {
+                            m_batchCount++;
+                        }
+                    }
+                    else
+                    {
+                        recorded = false;
+                    }
+                }
+            }
+
+            if( recorded )
+            {
+                p_req->setFrameId( frameId );
+                ret_val = m_device->SendFrame( p_req );
+            }
+
+            if( ret_val )
+            {
+                m_lastFrameId = frameId;
+            }
+            else
+            {
+                cancelRequest( frameId );
+            }
         }
     }
+
+    return ret_val;
+}
+
+bool XBeeApiCmdAt::removePending( const uint8_t p_frameId, 
+                                  const XBeeApiCmdAtStatus_e p_status,
+                                  bool* const p_queued )
+{
+    bool ret_val = false;
+
+    if( p_frameId != XBEE_FRAME_ID_NONE )
+    {
+        XBeeApiCriticalSection cs( m_lock );
+
+        for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+        {
+            if( m_pendingIds[ i ] == p_frameId )
+            {
+                m_pendingIds[ i ] = XBEE_FRAME_ID_NONE;
+                ret_val = true;
+            }
+        }
+
+        for( size_t i = 0; i < m_batchCount; i++ )
+        {
+            if( m_batch[ i ].m_frameId == p_frameId )
+            {
+                m_batch[ i ].m_frameId = XBEE_FRAME_ID_NONE;
+                m_batch[ i ].m_status = p_status;
+                if( p_queued != NULL )
+                {
+                    *p_queued = true;
+                }
+            }
+        }
+    }
+
+    return ret_val;
+}
+
+void XBeeApiCmdAt::commitBatch( const XBeeApiCmdAtStatus_e p_status )
+{
+    XBeeApiCriticalSection cs( m_lock );
+
+    for( size_t i = 0; i < m_batchCount; i++ )
+    {
+        /* The outcome of a change which the XBee accepted is that of applying it */
+        if( m_batch[ i ].m_status == XBEE_API_CMD_AT_STATUS_OK )
+        {
+            m_batch[ i ].m_status = p_status;
+        }
+        commitParam( m_batch[ i ].m_mnemonic, ( m_batch[ i ].m_status == XBEE_API_CMD_AT_STATUS_OK ));
+    }
+}
+
+#define COMMIT_PARAM( _cmd, _var ) \
+        case _cmd: \
+            if( p_commit ) \
+            { \
+                m_ ## _var = m_ ## _var ## Pend; \
+            } \
+            m_have_ ## _var = p_commit; \
+            break;
+
+void XBeeApiCmdAt::commitParam( const uint16_t p_mnemonic, const bool p_commit )
+{
+    switch( p_mnemonic ) {
+        COMMIT_PARAM( CMD_CH, chan )
+        COMMIT_PARAM( CMD_CE, CE )
+        COMMIT_PARAM( CMD_PID, PANId )
+        COMMIT_PARAM( CMD_EDA, EDA )
+        COMMIT_PARAM( CMD_RR, retries )
+        COMMIT_PARAM( CMD_MY, sourceAddress )
+        COMMIT_PARAM( CMD_RN, randomDelaySlots )
+        COMMIT_PARAM( CMD_MM, macMode )
+    }
+}
+
+bool XBeeApiCmdAt::getBatchStatus( const uint16_t p_mnemonic, XBeeApiCmdAtStatus_e* const p_status ) const
+{
+    bool ret_val = false;
+
+    for( size_t i = 0; i < m_batchCount; i++ )
+    {
+        if( m_batch[ i ].m_mnemonic == p_mnemonic )
+        {
+            *p_status = m_batch[ i ].m_status;
+            ret_val = true;
+            break;
+        }
+    }
+
     return ret_val;
 }
 
+bool XBeeApiCmdAt::cancelRequest( const uint8_t p_frameId )
+{
+    const bool ret_val = removePending( p_frameId, XBEE_API_CMD_AT_STATUS_NO_RESPONSE );
+
+    if( ret_val &&
+        ( m_device != NULL ))
+    {
+        m_device->releaseFrameId( p_frameId, this );
+    }
+
+    return ret_val;
+}
+
+void XBeeApiCmdAt::cancelAllRequests( void )
+{
+    for( size_t i = 0; i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        /* Read once, as the response may be decoded at the same time */
+        const uint8_t frameId = m_pendingIds[ i ];
+
+        if( frameId != XBEE_FRAME_ID_NONE )
+        {
+            cancelRequest( frameId );
+        }
+    }
+}
+
+XBeeApiIdentifier_e XBeeApiCmdAt::getSetApiId( void ) const
+{
+    return m_batching ? XBEE_CMD_QUEUE_PARAM_VAL : XBEE_CMD_AT_CMD;
+}
+
+void XBeeApiCmdAt::beginBatch( void )
+{
+    XBeeApiCriticalSection cs( m_lock );
+
+    m_batchCount = 0;
+    m_batching = true;
+}
+
+bool XBeeApiCmdAt::applyBatch( void )
+{
+    XBeeApiCmdAtReq req( this, CMD_AC );
+
+    m_batching = false;
+    return sendReq( &req );
+}
+
+bool XBeeApiCmdAt::isBatching( void ) const
+{
+    return m_batching;
+}
+
+bool XBeeApiCmdAt::isChannelValid( const XBeeDevice::XBeeDeviceModel_t p_model, const channel_t p_chan )
+{
+    return((( p_model == XBeeDevice::XBEEDEVICE_S1 ) && 
+            ( p_chan >= XBEE_CHAN_MIN ) &&
+            ( p_chan <= XBEE_CHAN_MAX )) ||
+           (( p_model == XBeeDevice::XBEEDEVICE_S1_PRO ) && 
+            ( p_chan >= XBEE_PRO_CHAN_MIN ) &&
+            ( p_chan <= XBEE_PRO_CHAN_MAX )));
+}
+
 bool XBeeApiCmdAt::setChannel( uint8_t const p_chan )
 {
     bool ret_val = false;
     
-    if((( m_device->getXBeeModel() == XBeeDevice::XBEEDEVICE_S1 ) && 
-        ( p_chan >= XBEE_CHAN_MIN ) &&
-        ( p_chan <= XBEE_CHAN_MAX )) ||
-       (( m_device->getXBeeModel() == XBeeDevice::XBEEDEVICE_S1_PRO ) && 
-        ( p_chan >= XBEE_PRO_CHAN_MIN ) &&
-        ( p_chan <= XBEE_PRO_CHAN_MAX )))
+    if( isChannelValid( m_device->getXBeeModel(), p_chan ))
     {
-        XBeeApiCmdAtSet<uint8_t> req( cmd_set_ch, p_chan );
+        XBeeApiCmdAtSet<uint8_t> req( this, CMD_CH, p_chan, getSetApiId() );
     
+        m_have_chan = false;
         m_chanPend = p_chan;
-        m_device->SendFrame( &req );
-        ret_val = true;
+        ret_val = sendReq( &req );
     }
     return ret_val;
 }
@@ -200,31 +452,28 @@ bool XBeeApiCmdAt::setChannel( uint8_t const p_chan )
 #define MAKE_REQUEST( _name, _mnemonic, _cmd ) \
 bool XBeeApiCmdAt::request ## _name( void ) \
 {\
-    XBeeApiFrame req( XBEE_CMD_AT_CMD, _cmd, sizeof( _cmd ));\
+    XBeeApiCmdAtReq req( this, _cmd );\
     m_have_ ## _mnemonic = false;\
-    m_device->SendFrame( &req );\
-    return true;\
+    return sendReq( &req );\
 }
 
-MAKE_REQUEST( HardwareVersion, hwVer, cmd_hv )
-MAKE_REQUEST( FirmwareVersion, fwVer, cmd_vr )
-MAKE_REQUEST( Channel, chan, cmd_ch )
-MAKE_REQUEST( PanId, PANId, cmd_pid )
-MAKE_REQUEST( CoordinatorEnabled, CE, cmd_ce )
-MAKE_REQUEST( EndDeviceAssociationEnabled, EDA, cmd_eda )
-MAKE_REQUEST( SourceAddress, sourceAddress, cmd_my )
-MAKE_REQUEST( Retries, retries, cmd_rr )
-MAKE_REQUEST( RandomDelaySlots, randomDelaySlots, cmd_rn )
-MAKE_REQUEST( MacMode, macMode, cmd_mm );
+MAKE_REQUEST( HardwareVersion, hwVer, CMD_HV )
+MAKE_REQUEST( FirmwareVersion, fwVer, CMD_VR )
+MAKE_REQUEST( Channel, chan, CMD_CH )
+MAKE_REQUEST( PanId, PANId, CMD_PID )
+MAKE_REQUEST( CoordinatorEnabled, CE, CMD_CE )
+MAKE_REQUEST( EndDeviceAssociationEnabled, EDA, CMD_EDA )
+MAKE_REQUEST( SourceAddress, sourceAddress, CMD_MY )
+MAKE_REQUEST( Retries, retries, CMD_RR )
+MAKE_REQUEST( RandomDelaySlots, randomDelaySlots, CMD_RN )
+MAKE_REQUEST( MacMode, macMode, CMD_MM );
 
 bool XBeeApiCmdAt::requestSerialNumber( void )
 {
-    XBeeApiFrame req1( XBEE_CMD_AT_CMD, cmd_sh, sizeof( cmd_sh ));
-    XBeeApiFrame req2( XBEE_CMD_AT_CMD, cmd_sl, sizeof( cmd_sl ));
+    XBeeApiCmdAtReq req1( this, CMD_SH );
+    XBeeApiCmdAtReq req2( this, CMD_SL );
     m_have_snHigh = m_have_snLow = false;
-    m_device->SendFrame( &req1 );
-    m_device->SendFrame( &req2 );
-    return true;
+    return sendReq( &req1 ) && sendReq( &req2 );
 }
 
 #define MAKE_GET(_name, _mnemonic, _type ) \
@@ -260,30 +509,78 @@ bool XBeeApiCmdAt::getSerialNumber( uint64_t* const p_sn )
     return( have_sn );
 }
 
-#define MAKE_SET( _name, _mnemonic, _cmd, _type ) \
+/* _wire is the type whose size matches the number of bytes the XBee uses for the parameter */
+#define MAKE_SET( _name, _mnemonic, _cmd, _type, _wire ) \
 bool XBeeApiCmdAt::set ## _name( const _type p_param ) \
 {\
-    XBeeApiCmdAtSet<_type> req( _cmd, p_param );\
+    XBeeApiCmdAtSet<_wire> req( this, _cmd, (_wire)p_param, getSetApiId() );\
 \
     m_have_ ## _mnemonic = false;\
     m_## _mnemonic ## Pend = p_param;\
-    m_device->SendFrame( &req );\
-    return true;\
+    return sendReq( &req );\
 }
 
-MAKE_SET( CoordinatorEnabled,          CE,               cmd_set_ce,  bool )
-MAKE_SET( EndDeviceAssociationEnabled, EDA,              cmd_set_eda, bool )
-MAKE_SET( PanId,                       PANId,            cmd_set_pid, panId_t )
-MAKE_SET( SourceAddress,               sourceAddress,    cmd_set_my,  uint16_t )
-MAKE_SET( Retries,                     retries,          cmd_set_rr,  uint8_t )
-MAKE_SET( RandomDelaySlots,            randomDelaySlots, cmd_set_rn,  uint8_t )
-MAKE_SET( MacMode,                     macMode,          cmd_set_mm,  XBeeApiMACMode_e )
+MAKE_SET( CoordinatorEnabled,          CE,               CMD_CE,  bool,             uint8_t )
+MAKE_SET( EndDeviceAssociationEnabled, EDA,              CMD_EDA, bool,             uint8_t )
+MAKE_SET( PanId,                       PANId,            CMD_PID, panId_t,          uint16_t )
+MAKE_SET( SourceAddress,               sourceAddress,    CMD_MY,  uint16_t,         uint16_t )
+MAKE_SET( Retries,                     retries,          CMD_RR,  uint8_t,          uint8_t )
+MAKE_SET( RandomDelaySlots,            randomDelaySlots, CMD_RN,  uint8_t,          uint8_t )
+MAKE_SET( MacMode,                     macMode,          CMD_MM,  XBeeApiMACMode_e, uint8_t )
 
 XBeeApiCmdAtBlocking::XBeeApiCmdAtBlocking( XBeeDevice* const p_device, const uint16_t p_timeout, const uint16_t p_slice ) :
     XBeeApiCmdAt( p_device ),
     m_timeout( p_timeout ),
-    m_slice( p_slice )
+    m_slice( p_slice ),
+    m_responseFrameId( XBEE_FRAME_ID_NONE ),
+    m_responseStatus( XBEE_API_CMD_AT_STATUS_OK )
+{
+}
+
+bool XBeeApiCmdAtBlocking::decodeCallback( const XBeeApiFrameView& p_data )
+{
+    const bool ret_val = XBeeApiCmdAt::decodeCallback( p_data );
+
+    if( ret_val )
+    {
+        m_responseStatus = p_data[ XBEE_CMD_POSN_STATUS ];
+        m_responseFrameId = p_data[ XBEE_CMD_POSN_FRAME_ID ];
+        m_event.signal();
+    }
+
+    return ret_val;
+}
+
+void XBeeApiCmdAtBlocking::prepareForResponse( void )
 {
+    m_responseFrameId = XBEE_FRAME_ID_NONE;
+    m_event.clear();
+}
+
+bool XBeeApiCmdAtBlocking::waitForResponse( XBeeApiTimeout* const p_timeout )
+{
+    const uint8_t frameId = getLastFrameId();
+    bool ret_val = ( m_responseFrameId == frameId );
+
+    /* Other responses (e.g. to requests made via the non-blocking interface) may also
+       signal the event, so check that it's the one we're after */
+    while(( !ret_val ) &&
+          ( m_event.wait( p_timeout->getRemaining() ))) 
+    {
+        ret_val = ( m_responseFrameId == frameId );
+    }
+
+    ret_val = ret_val || ( m_responseFrameId == frameId );
+
+    /* The response may have been lost, in which case the identifiers would otherwise never be
+       released, permanently shrinking the XBeeDevice's TX window.  Requests sent back to back
+       ahead of this one (e.g. by XBeeApiCmdAtProfile::apply()) are abandoned too */
+    if( !ret_val )
+    {
+        cancelAllRequests();
+    }
+
+    return ret_val;
 }
 
 /**
@@ -308,23 +605,16 @@ XBeeApiCmdAtBlocking::XBeeApiCmdAtBlocking( XBeeDevice* const p_device, const ui
     {\
         ret_val = true;\
     } \
-    else if( _REQ_FN() )\
+    else\
     {\
-        uint16_t counter = m_timeout; \
-        bool cont;\
+        XBeeApiTimeout timeout( m_timeout );\
 \
-        do{\
-            cont = false; \
-            wait_ms( m_slice );\
-            if( _GET_FN( _VAR ) )\
-            {\
-                ret_val = true;\
-            }\
-            else if( counter > m_slice ) {\
-                counter -= m_slice;    \
-                cont = true;\
-            } \
-        } while( cont );\
+        prepareForResponse();\
+        if( _REQ_FN() )\
+        {\
+            waitForResponse( &timeout );\
+            ret_val = _GET_FN( _VAR );\
+        }\
     }\
     \
     return( ret_val );
@@ -335,31 +625,63 @@ XBeeApiCmdAtBlocking::XBeeApiCmdAtBlocking( XBeeDevice* const p_device, const ui
 */
 #define BLOCKING_SET( _SET_FN, _GET_FN, _VAR, _TYPE ) \
     bool ret_val = false; \
-    uint16_t counter = m_timeout; \
+    XBeeApiTimeout timeout( m_timeout ); \
     _TYPE readback; \
 \
+    prepareForResponse();\
     if( _SET_FN( _VAR ) )\
     {\
-        bool cont;\
+        const bool responded = waitForResponse( &timeout );\
 \
-        do{\
-            cont = false;\
-            wait_ms( m_slice );\
-            if( _GET_FN( &readback ) &&\
-               ( readback == _VAR ))\
-            {\
-                ret_val = true;\
-            }\
-            else if( counter > m_slice ) {\
-                counter -= m_slice;    \
-                cont = true;\
-            } \
-        } while( cont );\
+        /* A change queued as part of a batch isn't cached until the batch is applied */\
+        if( isBatching() )\
+        {\
+            ret_val = responded && ( m_responseStatus == XBEE_API_CMD_AT_STATUS_OK );\
+        }\
+        else if( _GET_FN( &readback ) &&\
+                 ( readback == _VAR ))\
+        {\
+            ret_val = true;\
+        }\
     }\
     \
     return( ret_val );
 
 
+bool XBeeApiCmdAtBlocking::waitForLastResponse( void )
+{
+    XBeeApiTimeout timeout( m_timeout );
+    return waitForResponse( &timeout );
+}
+
+bool XBeeApiCmdAtBlocking::applyBatch( void )
+{
+    bool ret_val = false;
+    XBeeApiTimeout timeout( m_timeout );
+
+    prepareForResponse();
+    if( XBeeApiCmdAt::applyBatch() &&
+        waitForResponse( &timeout ))
+    {
+        ret_val = ( m_responseStatus == XBEE_API_CMD_AT_STATUS_OK );
+
+        for( size_t i = 0; i < m_batchCount; i++ )
+        {
+            if( m_batch[ i ].m_status != XBEE_API_CMD_AT_STATUS_OK )
+            {
+                ret_val = false;
+            }
+        }
+    }
+    else
+    {
+        /* Nothing's known to have been applied */
+        commitBatch( XBEE_API_CMD_AT_STATUS_NO_RESPONSE );
+    }
+
+    return ret_val;
+}
+
 bool XBeeApiCmdAtBlocking::getHardwareVersion( uint16_t* const p_ver )
 {
     BLOCKING_GET( XBeeApiCmdAt::requestHardwareVersion,
@@ -503,33 +825,64 @@ bool XBeeApiCmdAtBlocking::setMacMode( const XBeeApiMACMode_e p_mode )
 
 
 
-template < typename T >
-XBeeApiCmdAt::XBeeApiCmdAtSet<T>::XBeeApiCmdAtSet( const uint8_t* const p_data,
-                                                   const T p_val ) : XBeeApiFrame( )
+XBeeApiCmdAt::XBeeApiCmdAtReq::XBeeApiCmdAtReq( XBeeApiFrameDecoder* const p_owner,
+                                                const uint16_t p_mnemonic,
+                                                const XBeeApiIdentifier_e p_apiId ) : XBeeApiFrame( ),
+                                                                                      m_owner( p_owner )
 {
-    size_t s;
-    uint8_t* dest;
-    const uint8_t* src = (uint8_t*)(&p_val);
-    
-    m_apiId = XBEE_CMD_AT_CMD;
-    
-    m_buffer[0] = p_data[0];
-    m_buffer[1] = p_data[1];
-    m_buffer[2] = p_data[2];
-    
-    m_dataLen = sizeof( m_buffer );
+    m_apiId = p_apiId;
 
-    /* TODO: This copy code isn't portable - it's assuming that the data in 
-     * p_data is little endian */
-    dest = &( m_buffer[ m_dataLen - 1 ] );
-    
-    for( s = 0;
+    /* Frame identifier is filled in by prepareForTx() */
+    m_buffer[0] = XBEE_FRAME_ID_NONE;
+    m_buffer[1] = (uint8_t)( p_mnemonic >> 8U );
+    m_buffer[2] = (uint8_t)( p_mnemonic );
+
+    m_dataLen = XBEE_API_CMD_SET_HEADER_LEN;
+    m_data = m_buffer;
+}
+
+XBeeApiCmdAt::XBeeApiCmdAtReq::~XBeeApiCmdAtReq()
+{
+}
+
+bool XBeeApiCmdAt::XBeeApiCmdAtReq::prepareForTx( XBeeDevice* const p_device )
+{
+    if( m_buffer[0] == XBEE_FRAME_ID_NONE )
+    {
+        m_buffer[0] = p_device->allocFrameId( m_owner );
+    }
+    return( m_buffer[0] != XBEE_FRAME_ID_NONE );
+}
+
+void XBeeApiCmdAt::XBeeApiCmdAtReq::setFrameId( const uint8_t p_frameId )
+{
+    m_buffer[0] = p_frameId;
+}
+
+uint8_t XBeeApiCmdAt::XBeeApiCmdAtReq::getFrameId( void ) const
+{
+    return m_buffer[0];
+}
+
+uint16_t XBeeApiCmdAt::XBeeApiCmdAtReq::getMnemonic( void ) const
+{
+    return XBEE_AT_MNEMONIC( m_buffer[1], m_buffer[2] );
+}
+
+template < typename T >
+XBeeApiCmdAt::XBeeApiCmdAtSet<T>::XBeeApiCmdAtSet( XBeeApiFrameDecoder* const p_owner,
+                                                   const uint16_t p_mnemonic,
+                                                   const T p_val,
+                                                   const XBeeApiIdentifier_e p_apiId ) : XBeeApiCmdAtReq( p_owner, p_mnemonic, p_apiId )
+{
+    /* Parameter values are sent MSB first */
+    for( size_t s = 0;
          s < sizeof( T );
-         s++, dest--, src++ ) {
-        *dest = *src;         
+         s++ ) {
+        this->m_buffer[ XBEE_API_CMD_SET_HEADER_LEN + s ] = (uint8_t)(((uint64_t)p_val) >> ( 8U * ( sizeof( T ) - 1U - s )));
     }
     
-    m_data = m_buffer;
+    this->m_dataLen = XBEE_API_CMD_SET_HEADER_LEN + sizeof( T );
 }
 
 template < typename T >
@@ -33,17 +33,39 @@ limitations under the License.
 
 #include "XBeeApiFrame.hpp"
 #include "XBeeDevice.hpp"
+#include "XBeeApiEvent.hpp"
+#include "XBeeApiCriticalSection.hpp"
 
 #include <stdint.h>
 
 #define XBEE_API_CMD_SET_HEADER_LEN 3U
 
+/** Maximum length of the parameter value which can be sent with an AT command */
+#define XBEE_API_CMD_MAX_PARAM_LEN 8U
+
+/** Maximum number of different parameters which can be changed in one batch (see
+    XBeeApiCmdAt::beginBatch()) - one for each of XBeeApiCmdAt's setXXX methods */
+#define XBEE_API_CMD_MAX_BATCH 8U
+
+/** Form the 16-bit representation of a 2 character AT command mnemonic, e.g. 
+    XBEE_AT_MNEMONIC( 'V', 'R' ) */
+#define XBEE_AT_MNEMONIC( _a, _b ) ((uint16_t)((((uint16_t)(_a)) << 8U) | ((uint8_t)(_b))))
+
 /** Class to access the configuration interface of the XBee.
     Requests to the XBee are non-blocking meaning that code
     which utilises this class must deal with the fact that
     there will be a delay between requesting the data from
     the XBee and the data being available via the API.  See
     XBeeApiCmdAtBlocking for a blocking version.
+
+    Each request is sent with a unique frame identifier allocated
+    by the XBeeDevice, so any number of requests (up to
+    XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT) may be issued back to back
+    without waiting for the responses.  Completion of each request
+    can be observed via setCmdCallback().  The object keeps track of 
+    the requests which are awaiting a response, so that they can be 
+    abandoned (see cancelRequest() and cancelAllRequests()) in the 
+    case that the responses are lost.
     
     Parameters from the XBee are cached in the object so
     subsequent requests do not need have the overhead of
@@ -62,8 +84,42 @@ class XBeeApiCmdAt : public XBeeApiFrameDecoder
             XBEE_API_MAC_MODE_802_15_4_ACK    = 2,
             XBEE_API_MAC_MODE_DIGI_NO_ACK     = 3,
         } XBeeApiMACMode_e;
+        /** Status of an AT command, as reported by the XBee */
+        typedef enum {
+            XBEE_API_CMD_AT_STATUS_OK            = 0,
+            XBEE_API_CMD_AT_STATUS_ERROR         = 1,
+            XBEE_API_CMD_AT_STATUS_INVALID_CMD   = 2,
+            XBEE_API_CMD_AT_STATUS_INVALID_PARAM = 3,
+            /** Only applicable to remote AT commands */
+            XBEE_API_CMD_AT_STATUS_TX_FAILURE    = 4,
+            /** Not reported by the XBee - indicates that no response was received */
+            XBEE_API_CMD_AT_STATUS_NO_RESPONSE   = 0xFF
+        } XBeeApiCmdAtStatus_e;
+        /** Type of function which can be called when the response to an AT command is received
+
+            \param p_cmd Object which sent the command
+            \param p_mnemonic Command to which the response relates - see XBEE_AT_MNEMONIC()
+            \param p_frameId Frame identifier used for the command
+            \param p_status Status reported by the XBee
+            \param p_ctx Context pointer, as passed to setCmdCallback() */
+        typedef void (*XBeeApiCmdAtCallback_t)( XBeeApiCmdAt* const p_cmd,
+                                                const uint16_t p_mnemonic,
+                                                const uint8_t p_frameId,
+                                                const XBeeApiCmdAtStatus_e p_status,
+                                                void* const p_ctx );
     
     protected:
+        /** Record of a parameter change queued as part of a batch - see beginBatch() */
+        typedef struct {
+            /** Command used to make the change - see XBEE_AT_MNEMONIC() */
+            uint16_t             m_mnemonic;
+            /** Frame identifier of the change while it's awaiting a response, otherwise
+                XBEE_FRAME_ID_NONE */
+            uint8_t              m_frameId;
+            /** Outcome of the change - see getBatchStatus() */
+            XBeeApiCmdAtStatus_e m_status;
+        } XBeeApiCmdAtBatchEntry_t;
+
         /** Indicates whether or not m_hwVer contains data retrieved from the XBee */
         bool m_have_hwVer;
         /** Indicates whether or not m_fwVer contains data retrieved from the XBee */
@@ -104,30 +160,122 @@ class XBeeApiCmdAt : public XBeeApiFrameDecoder
         XBeeApiMACMode_e m_macMode;
         XBeeApiMACMode_e m_macModePend;
 
+        /** Function to be called when the response to a command is received */
+        XBeeApiCmdAtCallback_t m_callback;
+        /** Context pointer to be passed to m_callback */
+        void* m_callbackCtx;
+        /** Frame identifier used for the most recently sent command */
+        uint8_t m_lastFrameId;
+        /** Indicates whether or not parameter changes are being batched - see beginBatch() */
+        bool m_batching;
+        /** Frame identifiers of the commands which are awaiting a response.  Unused entries 
+            are XBEE_FRAME_ID_NONE */
+        uint8_t m_pendingIds[ XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT ];
+        /** Changes made in the current (or most recent) batch */
+        XBeeApiCmdAtBatchEntry_t m_batch[ XBEE_API_CMD_MAX_BATCH ];
+        /** Number of entries used in m_batch */
+        size_t m_batchCount;
+        /** Lock guarding m_pendingIds & m_batch against decodeCallback() */
+        XBeeApiCriticalSectionLock m_lock;
+
+        /** Class to create an XBeeApiFrame which can be used to send an AT command
+            to the XBee.  A frame identifier is allocated when the frame is sent, 
+            causing the response to be routed to the owning object */
+        class XBeeApiCmdAtReq : public XBeeApiFrame {
+            protected:
+                /** Decoder to which the response should be routed */
+                XBeeApiFrameDecoder* m_owner;
+                /** Frame identifier, command & parameter value */
+                uint8_t m_buffer[ XBEE_API_CMD_SET_HEADER_LEN + XBEE_API_CMD_MAX_PARAM_LEN ];
+            public:
+                /** Constructor
+
+                    \param p_owner Decoder to which the response should be routed
+                    \param p_mnemonic Command to be sent - see XBEE_AT_MNEMONIC()
+                    \param p_apiId Type of frame to send the command in */
+                XBeeApiCmdAtReq( XBeeApiFrameDecoder* const p_owner,
+                                 const uint16_t p_mnemonic,
+                                 const XBeeApiIdentifier_e p_apiId = XBEE_CMD_AT_CMD );
+                /** Destructor */
+                virtual ~XBeeApiCmdAtReq();
+
+                /** Allocates the frame identifier, unless one has already been set via
+                    setFrameId() */
+                virtual bool prepareForTx( XBeeDevice* const p_device );
+
+                /** Set the frame identifier to be used, in the case that it has been 
+                    allocated before the frame is sent */
+                void setFrameId( const uint8_t p_frameId );
+
+                /** Retrieve the frame identifier allocated when the frame was sent */
+                uint8_t getFrameId( void ) const;
+
+                /** Retrieve the command being sent - see XBEE_AT_MNEMONIC() */
+                uint16_t getMnemonic( void ) const;
+        };
+
         /** Template class to create an XBeeApiFrame which can be used to change
             the value of one of the XBee parameters.  This class is used by the
             setXXX methods in XBeeApiCmdAt */
         template< typename T >
-        class XBeeApiCmdAtSet : public XBeeApiFrame {
-            uint8_t m_buffer[ XBEE_API_CMD_SET_HEADER_LEN + sizeof( T ) ];
+        class XBeeApiCmdAtSet : public XBeeApiCmdAtReq {
             public:
                 /** Constructor
                    
-                    \param p_data Pointer to a buffer of length 3 bytes containing a 
-                                  single byte frame ID followed by 2 bytes identifying
-                                  the command, e.g. '0', 'V', 'R' would set up a version
-                                  request with a frame identifier of 48 (ASCII value of 
-                                  '0').
+                    \param p_owner Decoder to which the response should be routed
+                    \param p_mnemonic Command to be sent - see XBEE_AT_MNEMONIC()
                     \param p_val New value for the parameter 
+                    \param p_apiId Type of frame to send the command in.  
+                                   XBEE_CMD_QUEUE_PARAM_VAL queues the change until
+                                   changes are applied
                 */
-                XBeeApiCmdAtSet( const uint8_t* const p_data,
-                                 const T p_val );
+                XBeeApiCmdAtSet( XBeeApiFrameDecoder* const p_owner,
+                                 const uint16_t p_mnemonic,
+                                 const T p_val,
+                                 const XBeeApiIdentifier_e p_apiId = XBEE_CMD_AT_CMD );
                 /** Destructor */
                 virtual ~XBeeApiCmdAtSet();
         };
 
+       /** Send a command to the XBee, recording the frame identifier used.  The identifier 
+           is allocated up-front so that it can be recorded in m_pendingIds before the 
+           response has any chance of arriving
+
+           \param p_req Command to be sent
+           \returns true in the case that the command was sent */
+       bool sendReq( XBeeApiCmdAtReq* const p_req );
+
+       /** Remove a frame identifier from m_pendingIds.  In the case that the request was a
+           change queued as part of a batch, its outcome is recorded in m_batch
+
+           \param p_frameId Frame identifier to be removed
+           \param p_status Status of the response, or XBEE_API_CMD_AT_STATUS_NO_RESPONSE in
+                           the case that the request is being cancelled
+           \param p_queued Set to true in the case that the request was a change queued as
+                           part of a batch.  May be NULL
+           \returns true in the case that the identifier was found */
+       bool removePending( const uint8_t p_frameId, 
+                           const XBeeApiCmdAtStatus_e p_status,
+                           bool* const p_queued = NULL );
+
+       /** Record the outcome of applying the current batch, caching the values of the 
+           parameters which were successfully changed and invalidating the rest
+
+           \param p_status Status of the AC command */
+       void commitBatch( const XBeeApiCmdAtStatus_e p_status );
+
+       /** Cache the value sent for a parameter (see the m_xxxPend members), or invalidate the
+           cached value
+
+           \param p_mnemonic Command used to change the parameter
+           \param p_commit true to cache the value, false to invalidate it */
+       void commitParam( const uint16_t p_mnemonic, const bool p_commit );
+
+       /** Determine the type of frame which should be used for a parameter change */
+       XBeeApiIdentifier_e getSetApiId( void ) const;
+
        /* Implement XBeeApiCmdDecoder interface */
-       virtual bool decodeCallback( const uint8_t* const p_data, size_t p_len );
+       virtual bool decodeCallback( const XBeeApiFrameView& p_data );
 
     public:
 
@@ -138,6 +286,72 @@ class XBeeApiCmdAt : public XBeeApiFrameDecoder
        
         /** Destructor */
         virtual ~XBeeApiCmdAt( void ) {};
+
+        /** Set a function to be called when the response to each command sent by this
+            object is received.  Note that the function may be called from interrupt context.
+
+            \param p_callback Function to be called, or NULL to remove a previously set function
+            \param p_ctx Context pointer to be passed to p_callback */
+        void setCmdCallback( const XBeeApiCmdAtCallback_t p_callback, void* const p_ctx = NULL );
+
+        /** Retrieve the frame identifier used for the most recently sent command, allowing it to
+            be matched up with the p_frameId parameter passed to the call-back function */
+        uint8_t getLastFrameId( void ) const;
+
+        /** Retrieve the number of commands sent by this object which are awaiting a response */
+        size_t getPendingCount( void ) const;
+
+        /** Stop waiting for the response to a command, e.g. because it has been lost.  The 
+            frame identifier is released, meaning that it no longer counts towards the 
+            XBeeDevice's TX window.  A response which arrives later is dispatched in the 
+            same way as any other frame.
+
+            \param p_frameId Frame identifier of the command, as passed to the call-back
+                             function or returned by getLastFrameId()
+            \returns true in the case that the command was awaiting a response */
+        bool cancelRequest( const uint8_t p_frameId );
+
+        /** Stop waiting for the responses to all commands sent by this object - see
+            cancelRequest() */
+        void cancelAllRequests( void );
+
+        /** Determine whether or not a channel is supported by a particular model of XBee
+
+            \param p_model XBee model
+            \param p_chan Channel number
+            \returns true in the case that the channel is supported */
+        static bool isChannelValid( const XBeeDevice::XBeeDeviceModel_t p_model, const channel_t p_chan );
+
+        /** Start a batch of parameter changes.  Until applyBatch() is called, the setXXX
+            methods send the change using a Queue Parameter Value frame, meaning that the XBee
+            accepts the new value (reporting its status in the usual way - see setCmdCallback())
+            but does not apply it.  This avoids the XBee re-applying its settings after every
+            change.  The new values aren't cached until the XBee reports that they have been
+            applied. */
+        void beginBatch( void );
+
+        /** Apply all changes made since beginBatch() (via the AC command) and end the batch.  
+            The status of the AC command is reported via the call-back in the usual way.  Once
+            it has been received, the values of the parameters which were changed 
+            successfully are cached and the outcome of each change can be retrieved via 
+            getBatchStatus().
+
+            \returns true in the case that the AC command was sent */
+        virtual bool applyBatch( void );
+
+        /** Retrieve the outcome of a parameter change made in the current (or most recent)
+            batch.  This is the status reported by the XBee when the change was queued or, in
+            the case that the XBee accepted the change, the status of the AC command which 
+            applied it.  XBEE_API_CMD_AT_STATUS_NO_RESPONSE indicates that the XBee hasn't 
+            (yet) responded.
+
+            \param p_mnemonic Command used to change the parameter - see XBEE_AT_MNEMONIC()
+            \param p_status Receives the outcome
+            \returns true in the case that the parameter was changed in the batch */
+        bool getBatchStatus( const uint16_t p_mnemonic, XBeeApiCmdAtStatus_e* const p_status ) const;
+
+        /** Determine whether or not a batch of parameter changes is in progress */
+        bool isBatching( void ) const;
        
         /** Request the hardware version identifier from the XBee.
             As the data is retrieved asynchronously to this call,
@@ -217,18 +431,47 @@ class XBeeApiCmdAt : public XBeeApiFrameDecoder
     It's not necessary to use any of the requestXXX methods
     (as the getXXX methods will take care of this, however
     calling a requestXXX method will effectively pre-fetch the
-    data meaning that getXXX will not have to block */
+    data meaning that getXXX will not have to block
+
+    A blocked method is woken as soon as the response to its
+    request is received.  The blocking methods of a single object
+    should only be used by one thread at a time. */
 class XBeeApiCmdAtBlocking : public XBeeApiCmdAt
 {
     protected:
         /** Timeout used for blocking methods in milliseconds */
         uint16_t m_timeout;
         
-        /** Wait slice time while blocking.  The function will 
-            wait_ms(m_slice) until the XBee responds with the
-            data or m_timeout elapses */
+        /** Retained for compatibility - no longer used, as blocking
+            methods are woken by m_event rather than polling */
         uint16_t m_slice;
 
+        /** Event signalled when a response is decoded */
+        XBeeApiEvent m_event;
+
+        /** Frame identifier of the most recently decoded response */
+        volatile uint8_t m_responseFrameId;
+
+        /** Status of the most recently decoded response */
+        volatile uint8_t m_responseStatus;
+
+        /** Extends XBeeApiCmdAt::decodeCallback() to wake any blocked method */
+        virtual bool decodeCallback( const XBeeApiFrameView& p_data );
+
+        /** Prepare to wait for the response to a request - must be called before the
+            request is sent */
+        void prepareForResponse( void );
+
+        /** Wait for the response to the most recently sent request (see getLastFrameId()).
+            In the case that the timeout expires, all of the requests still awaiting a 
+            response are cancelled (see cancelAllRequests()) - as the XBee responds in order, 
+            the responses to any earlier requests have had at least as long to arrive.
+
+            \param p_timeout Timeout for the wait
+            \returns true in the case that the response was received, false in the case that 
+                     the timeout expired */
+        bool waitForResponse( XBeeApiTimeout* const p_timeout );
+
     public:
        /** Constructor 
        
@@ -237,9 +480,7 @@ class XBeeApiCmdAtBlocking : public XBeeApiCmdAt
             \param p_timeout Timeout to be used when waiting for 
                              data from the XBee, specified in
                              milliseconds
-            \param p_slice While waiting for data, blocking methods
-                           will call the OS wait_ms() function, using
-                           the value specified by p_slice */
+            \param p_slice Retained for compatibility - no longer used */
        XBeeApiCmdAtBlocking( XBeeDevice* const p_device = NULL,
                             const uint16_t p_timeout = 1000, 
                             const uint16_t p_slice = 100);
@@ -276,6 +517,21 @@ class XBeeApiCmdAtBlocking : public XBeeApiCmdAt
 
         virtual bool getMacMode( XBeeApiMACMode_e* const p_mode );       
         virtual bool setMacMode( const XBeeApiMACMode_e p_mode );       
+
+        /** Block until the response to the most recently sent command has been received
+            (or the timeout expires).  Allows a number of requests to be made back to back
+            via the non-blocking XBeeApiCmdAt methods and then waited for together - the 
+            XBee responds to commands in the order in which they were sent.
+
+            \returns true in the case that the response was received */
+        bool waitForLastResponse( void );
+
+        /** Extends XBeeApiCmdAt::applyBatch(), blocking until the XBee has responded.  The
+            outcome of each change can be retrieved via getBatchStatus().
+
+            \returns true in the case that the XBee reported that all of the changes were
+                     applied successfully */
+        virtual bool applyBatch( void );
 };
 
 #endif
\ No newline at end of file
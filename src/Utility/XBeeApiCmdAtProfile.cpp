@@ -0,0 +1,156 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiCmdAtProfile.hpp"
+#include "XBeeApiEvent.hpp"
+
+XBeeApiCmdAtProfile::XBeeApiCmdAtProfile( void ) : m_fields( 0 )
+{
+}
+
+XBeeApiCmdAtProfile::XBeeApiProfileFieldMask_t XBeeApiCmdAtProfile::getFieldMask( const XBeeApiProfileField_e p_field )
+{
+    return (XBeeApiProfileFieldMask_t)( 1U << p_field );
+}
+
+bool XBeeApiCmdAtProfile::isSpecified( const XBeeApiProfileField_e p_field ) const
+{
+    return(( m_fields & getFieldMask( p_field )) != 0 );
+}
+
+#define PROFILE_GET_VALUE( _field, _name, _var, _type, _mnemonic, _width ) \
+        case XBEE_PROFILE_ ## _field:\
+            ret_val = (uint16_t)m_ ## _var;\
+            break;
+
+uint16_t XBeeApiCmdAtProfile::getValue( const XBeeApiProfileField_e p_field ) const
+{
+    uint16_t ret_val = 0;
+
+    switch( p_field )
+    {
+        XBEE_PROFILE_FIELD_LIST( PROFILE_GET_VALUE )
+        default:
+            break;
+    }
+
+    return ret_val;
+}
+
+void XBeeApiCmdAtProfile::clear( const XBeeApiProfileField_e p_field )
+{
+    m_fields &= (XBeeApiProfileFieldMask_t)~getFieldMask( p_field );
+}
+
+#define MAKE_PROFILE_SET( _field, _name, _var, _type, _mnemonic, _width ) \
+void XBeeApiCmdAtProfile::set ## _name( const _type p_param ) \
+{\
+    m_ ## _var = p_param;\
+    m_fields |= getFieldMask( XBEE_PROFILE_ ## _field );\
+}
+
+XBEE_PROFILE_FIELD_LIST( MAKE_PROFILE_SET )
+
+/* The methods of the XBeeApiCmdAt base class are called explicitly below in order to avoid
+   the blocking versions implemented by XBeeApiCmdAtBlocking - the requests are sent back to 
+   back and then waited for together */
+
+/** Request the current value of the parameter from the XBee */
+#define PROFILE_REQUEST( _field, _name, _var, _type, _mnemonic, _width ) \
+    if( isSpecified( XBEE_PROFILE_ ## _field ))\
+    {\
+        p_cmd->XBeeApiCmdAt::request ## _name();\
+        requested = true;\
+    }
+
+/** Compare the value read from the XBee with that in the profile.  Parameters which 
+    couldn't be read are assumed to differ */
+#define PROFILE_COMPARE( _field, _name, _var, _type, _mnemonic, _width ) \
+    if( isSpecified( XBEE_PROFILE_ ## _field ))\
+    {\
+        _type current;\
+        if(( !p_cmd->XBeeApiCmdAt::get ## _name( &current )) ||\
+           ( current != m_ ## _var ))\
+        {\
+            differ |= getFieldMask( XBEE_PROFILE_ ## _field );\
+        }\
+    }
+
+/** Send the value from the profile to the XBee */
+#define PROFILE_WRITE( _field, _name, _var, _type, _mnemonic, _width ) \
+    if(( differ & getFieldMask( XBEE_PROFILE_ ## _field )) &&\
+       ( !p_cmd->XBeeApiCmdAt::set ## _name( m_ ## _var )))\
+    {\
+        failed |= getFieldMask( XBEE_PROFILE_ ## _field );\
+    }
+
+/** Check that the XBee accepted & applied the value sent by PROFILE_WRITE */
+#define PROFILE_VERIFY( _field, _name, _var, _type, _mnemonic, _width ) \
+    if( differ & getFieldMask( XBEE_PROFILE_ ## _field ))\
+    {\
+        XBeeApiCmdAt::XBeeApiCmdAtStatus_e status;\
+        if(( !p_cmd->getBatchStatus( _mnemonic, &status )) ||\
+           ( status != XBeeApiCmdAt::XBEE_API_CMD_AT_STATUS_OK ))\
+        {\
+            failed |= getFieldMask( XBEE_PROFILE_ ## _field );\
+        }\
+    }
+
+bool XBeeApiCmdAtProfile::apply( XBeeApiCmdAtBlocking* const p_cmd, XBeeApiProfileResult_t* const p_result ) const
+{
+    /* Used purely to measure the time taken */
+    XBeeApiTimeout timer( 0 );
+    XBeeApiProfileFieldMask_t differ = 0;
+    XBeeApiProfileFieldMask_t failed = 0;
+    bool requested = false;
+
+    /* Read the current values.  The XBee responds in order, so once the response to the
+       last request is in, all of the others should be too */
+    XBEE_PROFILE_FIELD_LIST( PROFILE_REQUEST )
+
+    if( requested )
+    {
+        p_cmd->waitForLastResponse();
+    }
+
+    XBEE_PROFILE_FIELD_LIST( PROFILE_COMPARE )
+
+    /* Only write the parameters which differ, applying them all in one go */
+    if( differ )
+    {
+        p_cmd->beginBatch();
+
+        XBEE_PROFILE_FIELD_LIST( PROFILE_WRITE )
+
+        /* Blocks until the XBee has responded to the AC, by which time the responses to all
+           of the changes will have been received.  The outcome of each change is checked 
+           below */
+        p_cmd->applyBatch();
+
+        XBEE_PROFILE_FIELD_LIST( PROFILE_VERIFY )
+    }
+
+    if( p_result != NULL )
+    {
+        p_result->m_changed = differ & (XBeeApiProfileFieldMask_t)~failed;
+        p_result->m_failed = failed;
+        p_result->m_elapsedMs = timer.getElapsed();
+    }
+
+    return( failed == 0 );
+}
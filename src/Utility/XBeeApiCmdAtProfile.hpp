@@ -0,0 +1,130 @@
+/**
+   @file
+   @brief Class to describe the desired configuration of an XBee and apply
+          it with the minimum of changes
+
+   @author John Bailey 
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+   
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPICMDATPROFILE_HPP
+#define      XBEEAPICMDATPROFILE_HPP
+
+#include "XBeeApiCmdAt.hpp"
+
+#include <stdint.h>
+
+/** List of the parameters which can be specified in a profile, used to generate the
+    code dealing with each parameter.  Each entry gives:
+      - The suffix of the XBeeApiCmdAtProfile::XBeeApiProfileField_e value
+      - The name used in the XBeeApiCmdAt methods (e.g. requestChannel(), getChannel(), setChannel())
+      - The name of the member variable holding the value (without the m_ prefix)
+      - The type of the parameter
+      - The AT command used to access the parameter - see XBEE_AT_MNEMONIC()
+      - The number of bytes used for the parameter value in AT command frames */
+#define XBEE_PROFILE_FIELD_LIST( _X ) \
+    _X( CHANNEL,                        Channel,                     chan,             XBeeApiCmdAt::channel_t,          XBEE_AT_MNEMONIC( 'C', 'H' ), 1U ) \
+    _X( COORDINATOR_ENABLED,            CoordinatorEnabled,          CE,               bool,                             XBEE_AT_MNEMONIC( 'C', 'E' ), 1U ) \
+    _X( END_DEVICE_ASSOCIATION_ENABLED, EndDeviceAssociationEnabled, EDA,              bool,                             XBEE_AT_MNEMONIC( 'A', '1' ), 1U ) \
+    _X( PAN_ID,                         PanId,                       PANId,            XBeeApiCmdAt::panId_t,            XBEE_AT_MNEMONIC( 'I', 'D' ), 2U ) \
+    _X( SOURCE_ADDRESS,                 SourceAddress,               sourceAddress,    uint16_t,                         XBEE_AT_MNEMONIC( 'M', 'Y' ), 2U ) \
+    _X( RETRIES,                        Retries,                     retries,          uint8_t,                          XBEE_AT_MNEMONIC( 'R', 'R' ), 1U ) \
+    _X( RANDOM_DELAY_SLOTS,             RandomDelaySlots,            randomDelaySlots, uint8_t,                          XBEE_AT_MNEMONIC( 'R', 'N' ), 1U ) \
+    _X( MAC_MODE,                       MacMode,                     macMode,          XBeeApiCmdAt::XBeeApiMACMode_e,   XBEE_AT_MNEMONIC( 'M', 'M' ), 1U )
+
+/** Class describing the desired values of some or all of the XBee parameters supported by
+    XBeeApiCmdAt.  Only the parameters which have been given a value (via the setXXX 
+    methods) form part of the profile.
+
+    When the profile is applied to an XBee, the current values of the parameters are read
+    back (all requests being sent back to back) and only those which differ from the profile
+    are changed.  The changes are made as a single batch (see XBeeApiCmdAt::beginBatch()), 
+    meaning that the XBee only has to re-apply its settings once. */
+class XBeeApiCmdAtProfile
+{
+    public:
+#define XBEE_PROFILE_ENUM( _field, _name, _var, _type, _mnemonic, _width ) XBEE_PROFILE_ ## _field,
+        /** Parameters which can be specified in the profile */
+        typedef enum {
+            XBEE_PROFILE_FIELD_LIST( XBEE_PROFILE_ENUM )
+            /** Not an actual parameter - provides the number of parameters */
+            XBEE_PROFILE_FIELD_COUNT
+        } XBeeApiProfileField_e;
+#undef XBEE_PROFILE_ENUM
+
+        /** Type used to hold a set of parameters, with bit n representing the parameter with
+            XBeeApiProfileField_e value n */
+        typedef uint16_t XBeeApiProfileFieldMask_t;
+
+        /** Result of applying the profile to an XBee */
+        typedef struct {
+            /** Parameters which were changed */
+            XBeeApiProfileFieldMask_t m_changed;
+            /** Parameters which needed changing, but where the change failed */
+            XBeeApiProfileFieldMask_t m_failed;
+            /** Time taken to apply the profile, in milliseconds */
+            uint32_t                  m_elapsedMs;
+        } XBeeApiProfileResult_t;
+
+    protected:
+        /** Parameters which have been specified */
+        XBeeApiProfileFieldMask_t m_fields;
+
+#define XBEE_PROFILE_MEMBER( _field, _name, _var, _type, _mnemonic, _width ) _type m_ ## _var;
+        XBEE_PROFILE_FIELD_LIST( XBEE_PROFILE_MEMBER )
+#undef XBEE_PROFILE_MEMBER
+
+    public:
+        /** Constructor.  The profile is initially empty */
+        XBeeApiCmdAtProfile( void );
+
+        /** Determine the mask bit representing a parameter */
+        static XBeeApiProfileFieldMask_t getFieldMask( const XBeeApiProfileField_e p_field );
+
+        /** Determine whether or not a parameter is specified in the profile */
+        bool isSpecified( const XBeeApiProfileField_e p_field ) const;
+
+        /** Retrieve the value of a parameter in the profile, in the form in which it is sent
+            to the XBee.  The value is meaningless if the parameter isn't specified */
+        uint16_t getValue( const XBeeApiProfileField_e p_field ) const;
+
+        /** Remove a parameter from the profile */
+        void clear( const XBeeApiProfileField_e p_field );
+
+        /* Methods to specify the value of each parameter - see the equivalent methods in XBeeApiCmdAt */
+        void setChannel( const XBeeApiCmdAt::channel_t p_chan );
+        void setCoordinatorEnabled( const bool p_en );
+        void setEndDeviceAssociationEnabled( const bool p_en );
+        void setPanId( const XBeeApiCmdAt::panId_t p_id );
+        void setSourceAddress( const uint16_t p_addr );
+        void setRetries( const uint8_t p_retries );
+        void setRandomDelaySlots( const uint8_t p_slots );
+        void setMacMode( const XBeeApiCmdAt::XBeeApiMACMode_e p_mode );
+
+        /** Apply the profile to the XBee associated with p_cmd.  Blocks until complete.
+
+            \param p_cmd Object to be used to communicate with the XBee.  Must be registered
+                         with an XBeeDevice
+            \param p_result Receives details of what was changed.  May be NULL
+            \returns true in the case that the XBee now matches the profile, false in the case
+                     that one or more changes failed */
+        bool apply( XBeeApiCmdAtBlocking* const p_cmd, XBeeApiProfileResult_t* const p_result = NULL ) const;
+};
+
+#endif
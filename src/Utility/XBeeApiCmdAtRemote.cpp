@@ -0,0 +1,537 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiCmdAtRemote.hpp"
+#include "XBeeApiCriticalSection.hpp"
+
+#define CMD_AC XBEE_AT_MNEMONIC( 'A', 'C' )
+
+/** Remote command option: apply changes on the remote node immediately */
+#define XBEE_REMOTE_OPT_APPLY_CHANGES (0x02U)
+
+#define XBEE_REMOTE_POSN_ADDR64 (5U)
+#define XBEE_REMOTE_POSN_ADDR16 (13U)
+#define XBEE_REMOTE_POSN_CMD (15U)
+#define XBEE_REMOTE_POSN_STATUS (17U)
+#define XBEE_REMOTE_POSN_PARAM_START (18U)
+
+/** Length of the parameter data in a remote AT command response of total length _p_len
+    (which includes the trailing checksum) */
+#define XBEE_REMOTE_RESPONSE_DATA_LEN( _p_len ) ((_p_len) - ( XBEE_REMOTE_POSN_PARAM_START + 1U ))
+
+/** Parameter index used for commands which don't relate to a parameter (e.g. AC) */
+#define XBEE_REMOTE_PARAM_NONE (0xFFU)
+
+/** API identifiers of the frames decoded by this class */
+static const XBeeApiIdentifier_e at_remote_api_ids[] = { XBEE_CMD_REMOTE_AT_RESPONSE };
+
+#define AT_REMOTE_PARAM( _field, _name, _var, _type, _mnemonic, _width ) { _mnemonic, _width },
+
+/** Command & parameter length for each parameter, indexed by XBeeApiRemoteParam_e */
+static const struct {
+    uint16_t m_mnemonic;
+    uint8_t  m_len;
+} at_remote_params[ XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ] = {
+    XBEE_PROFILE_FIELD_LIST( AT_REMOTE_PARAM )
+};
+
+XBeeApiCmdAtRemote::XBeeApiCmdAtRemote( const size_t p_maxNodes, XBeeDevice* const p_device ) : XBeeApiFrameDecoder( p_device, at_remote_api_ids, sizeof( at_remote_api_ids ) / sizeof( at_remote_api_ids[ 0 ] ) ),
+    m_maxNodes( p_maxNodes ),
+    m_nodeCount( 0 ),
+    m_callback( NULL ),
+    m_callbackCtx( NULL ),
+    m_lastFrameId( XBEE_FRAME_ID_NONE )
+{
+    m_nodes = new XBeeApiRemoteNode_t[ p_maxNodes ];
+
+    for( size_t i = 0;
+         i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+         i++ )
+    {
+        m_pending[ i ].m_frameId = XBEE_FRAME_ID_NONE;
+    }
+}
+
+XBeeApiCmdAtRemote::~XBeeApiCmdAtRemote( void )
+{
+    delete[]( m_nodes );
+}
+
+
+size_t XBeeApiCmdAtRemote::findNode( const uint64_t p_addr64, const uint16_t p_addr16 ) const
+{
+    size_t ret_val = XBEE_REMOTE_NODE_INVALID;
+
+    for( size_t i = 0;
+         ( i < m_nodeCount ) && ( ret_val == XBEE_REMOTE_NODE_INVALID );
+         i++ )
+    {
+        if( p_addr64 != XBEE_REMOTE_ADDR64_UNKNOWN )
+        {
+            if( m_nodes[ i ].m_addr64 == p_addr64 )
+            {
+                ret_val = i;
+            }
+        }
+        else if(( p_addr16 != XBEE_REMOTE_ADDR16_UNKNOWN ) &&
+                ( m_nodes[ i ].m_addr16 == p_addr16 ))
+        {
+            ret_val = i;
+        }
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiCmdAtRemote::addNode( const uint64_t p_addr64, const uint16_t p_addr16 )
+{
+    size_t ret_val = XBEE_REMOTE_NODE_INVALID;
+
+    if(( p_addr64 != XBEE_REMOTE_ADDR64_UNKNOWN ) ||
+       ( p_addr16 != XBEE_REMOTE_ADDR16_UNKNOWN ))
+    {
+        ret_val = findNode( p_addr64, p_addr16 );
+
+        if(( ret_val == XBEE_REMOTE_NODE_INVALID ) &&
+           ( m_nodeCount < m_maxNodes ))
+        {
+            XBeeApiRemoteNode_t* const node = &( m_nodes[ m_nodeCount ] );
+
+            node->m_addr64 = p_addr64;
+            node->m_addr16 = p_addr16;
+            node->m_have = 0;
+
+            /* Make the node visible to decodeCallback() only once it's initialised */
+            XBeeApiCriticalSection cs( m_lock );
+            ret_val = m_nodeCount++;
+        }
+    }
+
+    return ret_val;
+}
+
+size_t XBeeApiCmdAtRemote::getNodeCount( void ) const
+{
+    return m_nodeCount;
+}
+
+const XBeeApiCmdAtRemote::XBeeApiRemoteNode_t* XBeeApiCmdAtRemote::getNode( const size_t p_node ) const
+{
+    const XBeeApiRemoteNode_t* ret_val = NULL;
+
+    if( p_node < m_nodeCount )
+    {
+        ret_val = &( m_nodes[ p_node ] );
+    }
+
+    return ret_val;
+}
+
+#define REMOTE_GET_NODE_VALUE( _field, _name, _var, _type, _mnemonic, _width ) \
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_ ## _field:\
+            ret_val = (uint16_t)p_node.m_ ## _var;\
+            break;
+
+uint16_t XBeeApiCmdAtRemote::getNodeValue( const XBeeApiRemoteNode_t& p_node, const uint8_t p_param )
+{
+    uint16_t ret_val = 0;
+
+    switch( p_param )
+    {
+        XBEE_PROFILE_FIELD_LIST( REMOTE_GET_NODE_VALUE )
+        default:
+            break;
+    }
+
+    return ret_val;
+}
+
+#define REMOTE_SET_NODE_VALUE( _field, _name, _var, _type, _mnemonic, _width ) \
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_ ## _field:\
+            p_node->m_ ## _var = (_type)p_value;\
+            break;
+
+void XBeeApiCmdAtRemote::setNodeValue( XBeeApiRemoteNode_t* const p_node, const uint8_t p_param, const uint16_t p_value )
+{
+    switch( p_param )
+    {
+        XBEE_PROFILE_FIELD_LIST( REMOTE_SET_NODE_VALUE )
+        default:
+            break;
+    }
+}
+
+bool XBeeApiCmdAtRemote::sendReq( const size_t p_node, const uint8_t p_param, const uint16_t p_mnemonic,
+                                  const bool p_isSet, const uint16_t p_value, const bool p_apply )
+{
+    bool ret_val = false;
+
+    if(( m_device != NULL ) &&
+       ( p_node < m_nodeCount ))
+    {
+        /* The frame identifier is allocated up-front so that the details of the request
+           can be recorded before the response has any chance of arriving */
+        const uint8_t frameId = m_device->allocFrameId( this );
+
+        if( frameId != XBEE_FRAME_ID_NONE )
+        {
+            XBeeApiRemotePending_t* pend = NULL;
+
+            {
+                XBeeApiCriticalSection cs( m_lock );
+
+                for( size_t i = 0;
+                     ( i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT ) && ( pend == NULL );
+                     i++ )
+                {
+                    /* An entry using the same frame identifier must be stale, as the
+                       device has handed the identifier out again */
+                    if(( m_pending[ i ].m_frameId == XBEE_FRAME_ID_NONE ) ||
+                       ( m_pending[ i ].m_frameId == frameId ))
+                    {
+                        pend = &( m_pending[ i ] );
+                        pend->m_frameId = frameId;
+                        pend->m_node = (uint16_t)p_node;
+                        pend->m_param = p_param;
+                        pend->m_isSet = p_isSet;
+                        pend->m_value = p_value;
+                    }
+                }
+            }
+
+            if( pend != NULL )
+            {
+                const uint8_t len = p_isSet ? at_remote_params[ p_param ].m_len : 0U;
+                XBeeApiCmdAtRemoteReq req( frameId, m_nodes[ p_node ], p_mnemonic, p_apply, p_value, len );
+
+                m_lastFrameId = frameId;
+                ret_val = m_device->SendFrame( &req );
+            }
+
+            if( !ret_val )
+            {
+                cancelRequest( frameId );
+            }
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiCmdAtRemote::requestParam( const size_t p_node, const XBeeApiRemoteParam_e p_param )
+{
+    bool ret_val = false;
+
+    if( p_param < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT )
+    {
+        invalidateParam( p_node, p_param );
+        ret_val = sendReq( p_node, p_param, at_remote_params[ p_param ].m_mnemonic, false, 0, false );
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiCmdAtRemote::isParamValid( const XBeeDevice::XBeeDeviceModel_t p_model, const XBeeApiRemoteParam_e p_param,
+                                       const uint16_t p_value )
+{
+    bool ret_val = false;
+
+    switch( p_param )
+    {
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_CHANNEL:
+            ret_val = ( p_value <= 0xFFU ) &&
+                      ( XBeeApiCmdAt::isChannelValid( p_model, (XBeeApiCmdAt::channel_t)p_value ));
+            break;
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_COORDINATOR_ENABLED:
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_END_DEVICE_ASSOCIATION_ENABLED:
+            ret_val = ( p_value <= 1U );
+            break;
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_MAC_MODE:
+            ret_val = ( p_value <= XBeeApiCmdAt::XBEE_API_MAC_MODE_DIGI_NO_ACK );
+            break;
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_RETRIES:
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_RANDOM_DELAY_SLOTS:
+            ret_val = ( p_value <= 0xFFU );
+            break;
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_PAN_ID:
+        case XBeeApiCmdAtProfile::XBEE_PROFILE_SOURCE_ADDRESS:
+            ret_val = true;
+            break;
+        default:
+            break;
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiCmdAtRemote::isParamValid( const XBeeApiRemoteParam_e p_param, const uint16_t p_value ) const
+{
+    return(( m_device != NULL ) &&
+           ( isParamValid( m_device->getXBeeModel(), p_param, p_value )));
+}
+
+bool XBeeApiCmdAtRemote::setParam( const size_t p_node, const XBeeApiRemoteParam_e p_param, const uint16_t p_value,
+                                   const bool p_apply )
+{
+    bool ret_val = false;
+
+    if( isParamValid( p_param, p_value ))
+    {
+        invalidateParam( p_node, p_param );
+        ret_val = sendReq( p_node, p_param, at_remote_params[ p_param ].m_mnemonic, true, p_value, p_apply );
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiCmdAtRemote::applyChanges( const size_t p_node )
+{
+    return sendReq( p_node, XBEE_REMOTE_PARAM_NONE, CMD_AC, false, 0, true );
+}
+
+bool XBeeApiCmdAtRemote::getParam( const size_t p_node, const XBeeApiRemoteParam_e p_param, uint16_t* const p_value ) const
+{
+    bool ret_val = false;
+
+    if(( p_node < m_nodeCount ) &&
+       ( p_param < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ) &&
+       ( m_nodes[ p_node ].m_have & ( 1U << p_param )))
+    {
+        *p_value = getNodeValue( m_nodes[ p_node ], p_param );
+        ret_val = true;
+    }
+
+    return ret_val;
+}
+
+void XBeeApiCmdAtRemote::invalidateParam( const size_t p_node, const XBeeApiRemoteParam_e p_param )
+{
+    if(( p_node < m_nodeCount ) &&
+       ( p_param < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ))
+    {
+        XBeeApiCriticalSection cs( m_lock );
+        m_nodes[ p_node ].m_have &= ~( 1U << p_param );
+    }
+}
+
+bool XBeeApiCmdAtRemote::cancelRequest( const uint8_t p_frameId )
+{
+    bool ret_val = false;
+
+    if( p_frameId != XBEE_FRAME_ID_NONE )
+    {
+        {
+            XBeeApiCriticalSection cs( m_lock );
+
+            for( size_t i = 0;
+                 i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+                 i++ )
+            {
+                if( m_pending[ i ].m_frameId == p_frameId )
+                {
+                    m_pending[ i ].m_frameId = XBEE_FRAME_ID_NONE;
+                    ret_val = true;
+                }
+            }
+        }
+
+        if( m_device != NULL )
+        {
+            m_device->releaseFrameId( p_frameId, this );
+        }
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiCmdAtRemote::decodeCallback( const XBeeApiFrameView& p_data )
+{
+    bool ret_val = false;
+
+    if(( XBEE_CMD_REMOTE_AT_RESPONSE == p_data[ XBEE_CMD_POSN_API_ID ] ) &&
+       ( p_data.getLen() > XBEE_REMOTE_POSN_PARAM_START )) {
+
+        const uint8_t frameId = p_data[ XBEE_CMD_POSN_FRAME_ID ];
+        const uint16_t mnemonic = XBEE_AT_MNEMONIC( p_data[ XBEE_REMOTE_POSN_CMD ],
+                                                    p_data[ XBEE_REMOTE_POSN_CMD + 1U ] );
+        const XBeeApiCmdAt::XBeeApiCmdAtStatus_e status = (XBeeApiCmdAt::XBeeApiCmdAtStatus_e)p_data[ XBEE_REMOTE_POSN_STATUS ];
+        const size_t dataLen = XBEE_REMOTE_RESPONSE_DATA_LEN( p_data.getLen() );
+        const uint16_t addr16 = ((uint16_t)p_data[ XBEE_REMOTE_POSN_ADDR16 ] << 8U ) |
+                                           p_data[ XBEE_REMOTE_POSN_ADDR16 + 1U ];
+        uint64_t addr64 = 0;
+        size_t node = XBEE_REMOTE_NODE_INVALID;
+        uint8_t param = XBEE_REMOTE_PARAM_NONE;
+        bool isSet = false;
+        uint16_t value = 0;
+
+        for( size_t i = 0;
+             i < sizeof( addr64 );
+             i++ )
+        {
+            addr64 = ( addr64 << 8U ) | p_data[ XBEE_REMOTE_POSN_ADDR64 + i ];
+        }
+
+        /* Match the response against the request which caused it */
+        if( frameId != XBEE_FRAME_ID_NONE )
+        {
+            XBeeApiCriticalSection cs( m_lock );
+
+            for( size_t i = 0;
+                 i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+                 i++ )
+            {
+                if( m_pending[ i ].m_frameId == frameId )
+                {
+                    node = m_pending[ i ].m_node;
+                    param = m_pending[ i ].m_param;
+                    isSet = m_pending[ i ].m_isSet;
+                    value = m_pending[ i ].m_value;
+                    m_pending[ i ].m_frameId = XBEE_FRAME_ID_NONE;
+                }
+            }
+        }
+
+        /* Response to a request which has been cancelled or which wasn't sent by this object -
+           decode it based on the address of the node & the command */
+        if( node == XBEE_REMOTE_NODE_INVALID )
+        {
+            node = findNode( addr64, XBEE_REMOTE_ADDR16_UNKNOWN );
+            if( node == XBEE_REMOTE_NODE_INVALID )
+            {
+                node = findNode( XBEE_REMOTE_ADDR64_UNKNOWN, addr16 );
+            }
+
+            for( uint8_t p = 0;
+                 p < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT;
+                 p++ )
+            {
+                if( at_remote_params[ p ].m_mnemonic == mnemonic )
+                {
+                    param = p;
+                }
+            }
+        }
+
+        if(( node != XBEE_REMOTE_NODE_INVALID ) &&
+           ( node < m_nodeCount ))
+        {
+            XBeeApiRemoteNode_t* const entry = &( m_nodes[ node ] );
+
+            /* Learn whichever of the node's addresses weren't known */
+            if( addr64 != XBEE_REMOTE_ADDR64_UNKNOWN )
+            {
+                entry->m_addr64 = addr64;
+            }
+            if( addr16 != XBEE_REMOTE_ADDR16_UNKNOWN )
+            {
+                entry->m_addr16 = addr16;
+            }
+
+            if(( param < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ) &&
+               ( at_remote_params[ param ].m_mnemonic == mnemonic ))
+            {
+                /* A response carrying parameter data is the result of a get, one without is the
+                   result of a set, in which case the value that was set becomes the cached value */
+                if(( status == XBeeApiCmdAt::XBEE_API_CMD_AT_STATUS_OK ) &&
+                   (( dataLen >= at_remote_params[ param ].m_len ) ||
+                    (( dataLen == 0 ) && isSet )))
+                {
+                    if( dataLen != 0 )
+                    {
+                        value = 0;
+                        for( size_t i = dataLen - at_remote_params[ param ].m_len;
+                             i < dataLen;
+                             i++ )
+                        {
+                            value = ( value << 8U ) | p_data[ XBEE_REMOTE_POSN_PARAM_START + i ];
+                        }
+                    }
+                    setNodeValue( entry, param, value );
+                    entry->m_have |= ( 1U << param );
+                }
+                else
+                {
+                    entry->m_have &= ~( 1U << param );
+                }
+            }
+
+            if( m_callback != NULL )
+            {
+                m_callback( this, node, mnemonic, frameId, status, m_callbackCtx );
+            }
+
+            ret_val = true;
+        }
+    }
+
+    return ret_val;
+}
+
+void XBeeApiCmdAtRemote::setCmdCallback( const XBeeApiCmdAtRemoteCallback_t p_callback, void* const p_ctx )
+{
+    m_callback = p_callback;
+    m_callbackCtx = p_ctx;
+}
+
+uint8_t XBeeApiCmdAtRemote::getLastFrameId( void ) const
+{
+    return m_lastFrameId;
+}
+
+XBeeApiCmdAtRemote::XBeeApiCmdAtRemoteReq::XBeeApiCmdAtRemoteReq( const uint8_t p_frameId,
+                                                                  const XBeeApiRemoteNode_t& p_node,
+                                                                  const uint16_t p_mnemonic,
+                                                                  const bool p_apply,
+                                                                  const uint16_t p_value,
+                                                                  const uint8_t p_valueLen ) : XBeeApiFrame( )
+{
+    size_t posn = 0;
+
+    m_apiId = XBEE_CMD_REMOTE_AT_CMD;
+
+    m_buffer[ posn++ ] = p_frameId;
+
+    /* Addresses are sent MSB first */
+    for( size_t s = sizeof( p_node.m_addr64 );
+         s > 0;
+         s-- )
+    {
+        m_buffer[ posn++ ] = (uint8_t)( p_node.m_addr64 >> (( s - 1U ) * 8U ));
+    }
+    m_buffer[ posn++ ] = (uint8_t)( p_node.m_addr16 >> 8U );
+    m_buffer[ posn++ ] = (uint8_t)( p_node.m_addr16 );
+
+    m_buffer[ posn++ ] = p_apply ? XBEE_REMOTE_OPT_APPLY_CHANGES : 0U;
+    m_buffer[ posn++ ] = (uint8_t)( p_mnemonic >> 8U );
+    m_buffer[ posn++ ] = (uint8_t)( p_mnemonic );
+
+    /* Parameter values are sent MSB first */
+    for( size_t s = p_valueLen;
+         s > 0;
+         s-- )
+    {
+        m_buffer[ posn++ ] = (uint8_t)( p_value >> (( s - 1U ) * 8U ));
+    }
+
+    m_dataLen = posn;
+    m_data = m_buffer;
+}
+
+XBeeApiCmdAtRemote::XBeeApiCmdAtRemoteReq::~XBeeApiCmdAtRemoteReq()
+{
+}
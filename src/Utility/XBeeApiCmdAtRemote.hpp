@@ -0,0 +1,294 @@
+/**
+   @file
+   @brief Class to access the configuration interface of remote XBees
+          via remote AT commands
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPICMDATREMOTE_HPP
+#define      XBEEAPICMDATREMOTE_HPP
+
+#include "XBeeApiFrame.hpp"
+#include "XBeeDevice.hpp"
+#include "XBeeApiCmdAt.hpp"
+#include "XBeeApiCmdAtProfile.hpp"
+#include "XBeeApiCriticalSection.hpp"
+
+#include <stdint.h>
+
+/** 64-bit address value used in remote AT commands to indicate that the 16-bit address
+    should be used instead */
+#define XBEE_REMOTE_ADDR64_UNKNOWN 0xFFFFFFFFFFFFFFFFULL
+
+/** 16-bit address value used in remote AT commands to indicate that the 64-bit address
+    should be used instead */
+#define XBEE_REMOTE_ADDR16_UNKNOWN 0xFFFEU
+
+/** Value returned in place of a node index in the case that there's no such node */
+#define XBEE_REMOTE_NODE_INVALID ((size_t)-1)
+
+/** Maximum length of the data in a remote AT command frame: frame ID, 64-bit address,
+    16-bit address, options, command and parameter */
+#define XBEE_API_CMD_REMOTE_BUFFER_LEN ( 14U + XBEE_API_CMD_MAX_PARAM_LEN )
+
+/** Class to access the configuration interface of a number of remote XBees, via the
+    XBee attached to the XBeeDevice.
+
+    The parameters supported are those listed in XBeeApiCmdAtProfile::XBeeApiProfileField_e.
+    In contrast to XBeeApiCmdAt, where each object represents one XBee, a single object
+    of this class caches the parameters for many nodes.  The per-node cache is densely
+    packed (see XBeeApiRemoteNode_t) and details of set requests awaiting a response are
+    held in a small table shared between all nodes, so the memory required for each
+    additional node is kept to a minimum.
+
+    Requests are non-blocking - see setCmdCallback() for notification of completion. */
+class XBeeApiCmdAtRemote : public XBeeApiFrameDecoder
+{
+    public:
+        /** Type used to identify a parameter */
+        typedef XBeeApiCmdAtProfile::XBeeApiProfileField_e XBeeApiRemoteParam_e;
+
+        /** Type of function which can be called when the response to a remote AT command is
+            received
+
+            \param p_cmd Object which sent the command
+            \param p_node Index of the node which responded
+            \param p_mnemonic Command to which the response relates - see XBEE_AT_MNEMONIC()
+            \param p_frameId Frame identifier used for the command
+            \param p_status Status reported by the XBee
+            \param p_ctx Context pointer, as passed to setCmdCallback() */
+        typedef void (*XBeeApiCmdAtRemoteCallback_t)( XBeeApiCmdAtRemote* const p_cmd,
+                                                      const size_t p_node,
+                                                      const uint16_t p_mnemonic,
+                                                      const uint8_t p_frameId,
+                                                      const XBeeApiCmdAt::XBeeApiCmdAtStatus_e p_status,
+                                                      void* const p_ctx );
+
+        /** Cached parameters for a single remote node */
+        typedef struct {
+            /** 64-bit address, or XBEE_REMOTE_ADDR64_UNKNOWN */
+            uint64_t m_addr64;
+            /** 16-bit address, or XBEE_REMOTE_ADDR16_UNKNOWN */
+            uint16_t m_addr16;
+            uint16_t m_PANId;
+            uint16_t m_sourceAddress;
+            XBeeApiCmdAt::channel_t m_chan;
+            uint8_t  m_retries;
+            uint8_t  m_randomDelaySlots;
+            uint8_t  m_macMode : 2;
+            uint8_t  m_CE      : 1;
+            uint8_t  m_EDA     : 1;
+            /** Bit mask indicating which parameters hold data retrieved from the node.  Bit n
+                relates to the parameter with XBeeApiRemoteParam_e value n */
+            uint8_t  m_have;
+        } XBeeApiRemoteNode_t;
+
+    protected:
+        /** Details of a request which is awaiting a response */
+        typedef struct {
+            /** Frame identifier of the request, XBEE_FRAME_ID_NONE if the entry is unused */
+            uint8_t  m_frameId;
+            /** Parameter being changed */
+            uint8_t  m_param;
+            /** Index of the node in m_nodes */
+            uint16_t m_node;
+            /** Value being set, in the case that the request is a set */
+            uint16_t m_value;
+            /** Indicates whether or not the request is a set */
+            bool     m_isSet;
+        } XBeeApiRemotePending_t;
+
+        /** Node table */
+        XBeeApiRemoteNode_t*   m_nodes;
+        /** Number of entries allocated in m_nodes */
+        size_t                 m_maxNodes;
+        /** Number of entries used in m_nodes */
+        size_t                 m_nodeCount;
+
+        /** Requests awaiting a response */
+        XBeeApiRemotePending_t m_pending[ XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT ];
+
+        /** Function to be called when the response to a command is received */
+        XBeeApiCmdAtRemoteCallback_t m_callback;
+        /** Context pointer to be passed to m_callback */
+        void* m_callbackCtx;
+        /** Frame identifier used for the most recently sent command */
+        uint8_t m_lastFrameId;
+        /** Lock guarding m_pending & the node table against decodeCallback() */
+        XBeeApiCriticalSectionLock m_lock;
+
+        /** Class to create an XBeeApiFrame which can be used to send an AT command to
+            a remote XBee */
+        class XBeeApiCmdAtRemoteReq : public XBeeApiFrame {
+            protected:
+                /** Frame identifier, addresses, options, command & parameter value */
+                uint8_t m_buffer[ XBEE_API_CMD_REMOTE_BUFFER_LEN ];
+            public:
+                /** Constructor
+
+                    \param p_frameId Frame identifier to use
+                    \param p_node Node to which the command is to be sent
+                    \param p_mnemonic Command to be sent - see XBEE_AT_MNEMONIC()
+                    \param p_apply Whether or not the remote node should apply changes immediately
+                    \param p_value Parameter value
+                    \param p_valueLen Length of the parameter value in bytes.  0 indicates that
+                                      there's no value (i.e. the command is a get) */
+                XBeeApiCmdAtRemoteReq( const uint8_t p_frameId,
+                                       const XBeeApiRemoteNode_t& p_node,
+                                       const uint16_t p_mnemonic,
+                                       const bool p_apply,
+                                       const uint16_t p_value = 0,
+                                       const uint8_t p_valueLen = 0 );
+                /** Destructor */
+                virtual ~XBeeApiCmdAtRemoteReq();
+        };
+
+        /** Send a command to a node
+
+            \param p_node Index of the node
+            \param p_param Parameter the command relates to
+            \param p_mnemonic Command to be sent
+            \param p_isSet Whether or not the command is a set
+            \param p_value Value to be set
+            \param p_apply Whether or not the remote node should apply changes immediately
+            \returns true in the case that the command was sent */
+        bool sendReq( const size_t p_node, const uint8_t p_param, const uint16_t p_mnemonic,
+                      const bool p_isSet, const uint16_t p_value, const bool p_apply );
+
+        /** Find a node by address, preferring the 64-bit address if it's known
+
+            \returns Index of the node or XBEE_REMOTE_NODE_INVALID */
+        size_t findNode( const uint64_t p_addr64, const uint16_t p_addr16 ) const;
+
+        /** Retrieve the cached value of a parameter, regardless of whether it's valid */
+        static uint16_t getNodeValue( const XBeeApiRemoteNode_t& p_node, const uint8_t p_param );
+
+        /** Update the cached value of a parameter */
+        static void setNodeValue( XBeeApiRemoteNode_t* const p_node, const uint8_t p_param, const uint16_t p_value );
+
+        /* Implement XBeeApiCmdDecoder interface */
+        virtual bool decodeCallback( const XBeeApiFrameView& p_data );
+
+    public:
+        /** Constructor
+
+            \param p_maxNodes Maximum number of nodes for which parameters are to be cached
+            \param p_device XBee device with which this object should be associated */
+        XBeeApiCmdAtRemote( const size_t p_maxNodes, XBeeDevice* const p_device = NULL );
+
+        /** Destructor */
+        virtual ~XBeeApiCmdAtRemote( void );
+
+        /** Add a node to the table.  The node may be identified by either 64-bit or 16-bit
+            address (or both).  In the case that the node is already in the table, the existing
+            entry is returned
+
+            \param p_addr64 64-bit address of the node, or XBEE_REMOTE_ADDR64_UNKNOWN
+            \param p_addr16 16-bit address of the node, or XBEE_REMOTE_ADDR16_UNKNOWN
+            \returns Index of the node, or XBEE_REMOTE_NODE_INVALID in the case that the table is full */
+        size_t addNode( const uint64_t p_addr64, const uint16_t p_addr16 = XBEE_REMOTE_ADDR16_UNKNOWN );
+
+        /** Retrieve the number of nodes in the table */
+        size_t getNodeCount( void ) const;
+
+        /** Retrieve the table entry for a node
+
+            \param p_node Index of the node
+            \returns Pointer to the entry, or NULL in the case that p_node is invalid */
+        const XBeeApiRemoteNode_t* getNode( const size_t p_node ) const;
+
+        /** Request the current value of a parameter from a node.  Once the response is received,
+            the value can be accessed via getParam()
+
+            \param p_node Index of the node
+            \param p_param Parameter to request
+            \returns true in the case that the request was sent */
+        bool requestParam( const size_t p_node, const XBeeApiRemoteParam_e p_param );
+
+        /** Change the value of a parameter on a node.  Values are validated in the same way as
+            the equivalent XBeeApiCmdAt setXXX methods.  Channels are validated against the
+            model of the local XBee, on the basis that all nodes in the network share a channel.
+
+            \param p_node Index of the node
+            \param p_param Parameter to change
+            \param p_value New value
+            \param p_apply true to have the node apply the change immediately, false to have
+                           it queue the change until applyChanges() is called
+            \returns true in the case that the request was sent */
+        bool setParam( const size_t p_node, const XBeeApiRemoteParam_e p_param, const uint16_t p_value,
+                       const bool p_apply = true );
+
+        /** Determine whether or not a value is acceptable for a parameter.  Values are validated
+            in the same way as the equivalent XBeeApiCmdAt setXXX methods
+
+            \param p_model Model of XBee to validate against (relevant to the channel)
+            \param p_param Parameter to validate
+            \param p_value Value of the parameter
+            \returns true in the case that the value is acceptable */
+        static bool isParamValid( const XBeeDevice::XBeeDeviceModel_t p_model, const XBeeApiRemoteParam_e p_param,
+                                  const uint16_t p_value );
+
+        /** Determine whether or not a value is acceptable for a parameter, validating against
+            the model of the XBee attached to the XBeeDevice - see setParam()
+
+            \param p_param Parameter to validate
+            \param p_value Value of the parameter
+            \returns true in the case that the value is acceptable */
+        bool isParamValid( const XBeeApiRemoteParam_e p_param, const uint16_t p_value ) const;
+
+        /** Have a node apply any queued changes (via the AC command)
+
+            \param p_node Index of the node
+            \returns true in the case that the request was sent */
+        bool applyChanges( const size_t p_node );
+
+        /** Read the cached value of a parameter for a node.  Does not initiate any communication
+            with the node.
+
+            \param p_node Index of the node
+            \param p_param Parameter to read
+            \param p_value Receives the value
+            \returns true in the case that the value has been retrieved from the node */
+        bool getParam( const size_t p_node, const XBeeApiRemoteParam_e p_param, uint16_t* const p_value ) const;
+
+        /** Discard the cached value of a parameter for a node */
+        void invalidateParam( const size_t p_node, const XBeeApiRemoteParam_e p_param );
+
+        /** Abandon a command which has not received a response (e.g. because the node is out
+            of range), releasing its frame identifier.  Any response which subsequently
+            arrives is decoded based on the address of the node & the command.
+
+            \param p_frameId Frame identifier of the command, as returned by getLastFrameId()
+            \returns true in the case that the command was awaiting a response */
+        bool cancelRequest( const uint8_t p_frameId );
+
+        /** Set a function to be called when the response to each command sent by this
+            object is received.  Note that the function may be called from interrupt context.
+
+            \param p_callback Function to be called, or NULL to remove a previously set function
+            \param p_ctx Context pointer to be passed to p_callback */
+        void setCmdCallback( const XBeeApiCmdAtRemoteCallback_t p_callback, void* const p_ctx = NULL );
+
+        /** Retrieve the frame identifier used for the most recently sent command */
+        uint8_t getLastFrameId( void ) const;
+};
+
+#endif
@@ -0,0 +1,394 @@
+/**
+
+Copyright 2014 John Bailey
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#include "XBeeApiRemotePush.hpp"
+#include "XBeeApiCriticalSection.hpp"
+
+/** Time run() waits before re-trying a command which couldn't be sent (e.g. because all
+    frame identifiers were in use) */
+#define XBEE_REMOTE_PUSH_RESEND_MS 1U
+
+XBeeApiRemotePush::XBeeApiRemotePush( XBeeApiCmdAtRemote* const p_remote,
+                                      const uint8_t p_window,
+                                      const uint16_t p_timeoutMs,
+                                      const uint8_t p_retries ) :
+    m_remote( p_remote ),
+    m_profile( NULL ),
+    m_state( NULL ),
+    m_nodeCount( 0 ),
+    m_nextNode( 0 ),
+    m_window( p_window ),
+    m_timeoutMs( p_timeoutMs ),
+    m_retries( p_retries ),
+    m_progress(),
+    m_clock( NULL )
+{
+    if( m_window > XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT )
+    {
+        m_window = XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+    }
+    else if( m_window == 0 )
+    {
+        m_window = 1;
+    }
+
+    for( size_t i = 0;
+         i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+         i++ )
+    {
+        m_slots[ i ].m_active = false;
+    }
+}
+
+XBeeApiRemotePush::~XBeeApiRemotePush( void )
+{
+    if( m_profile != NULL )
+    {
+        m_remote->setCmdCallback( NULL );
+    }
+    delete[]( m_state );
+    delete( m_clock );
+}
+
+void XBeeApiRemotePush::cmdCallback( XBeeApiCmdAtRemote* const,
+                                     const size_t p_node,
+                                     const uint16_t,
+                                     const uint8_t p_frameId,
+                                     const XBeeApiCmdAt::XBeeApiCmdAtStatus_e p_status,
+                                     void* const p_ctx )
+{
+    XBeeApiRemotePush* const push = (XBeeApiRemotePush*)p_ctx;
+
+    {
+        XBeeApiCriticalSection cs( push->m_lock );
+
+        for( size_t i = 0;
+             i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+             i++ )
+        {
+            XBeeApiRemotePushSlot_t* const slot = &( push->m_slots[ i ] );
+
+            /* The response may arrive before sendSlot() has had chance to record the frame
+               identifier, in which case it's matched on the node alone */
+            if(( slot->m_active ) &&
+               ( slot->m_node == p_node ) &&
+               ( !slot->m_responded ) &&
+               (( slot->m_frameId == p_frameId ) ||
+                ( slot->m_frameId == XBEE_FRAME_ID_NONE )))
+            {
+                slot->m_frameId = p_frameId;
+                slot->m_status = p_status;
+                slot->m_responded = true;
+            }
+        }
+    }
+
+    push->m_event.signal();
+}
+
+uint8_t XBeeApiRemotePush::nextParam( const size_t p_node, const uint8_t p_from ) const
+{
+    uint8_t ret_val = XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT;
+
+    for( uint8_t p = p_from;
+         ( p < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT ) &&
+         ( ret_val == XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT );
+         p++ )
+    {
+        const XBeeApiCmdAtProfile::XBeeApiProfileField_e field = (XBeeApiCmdAtProfile::XBeeApiProfileField_e)p;
+        uint16_t current;
+
+        /* Parameters not known to already match the profile need changing */
+        if(( m_profile->isSpecified( field )) &&
+           (( !m_remote->getParam( p_node, field, &current )) ||
+            ( current != m_profile->getValue( field ))))
+        {
+            ret_val = p;
+        }
+    }
+
+    return ret_val;
+}
+
+void XBeeApiRemotePush::sendSlot( XBeeApiRemotePushSlot_t* const p_slot )
+{
+    const XBeeApiCmdAtProfile::XBeeApiProfileField_e field = (XBeeApiCmdAtProfile::XBeeApiProfileField_e)p_slot->m_param;
+    /* Changes are queued on the node, with the last change applying them all */
+    const bool apply = ( nextParam( p_slot->m_node, p_slot->m_param + 1U ) == XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT );
+
+    p_slot->m_frameId = XBEE_FRAME_ID_NONE;
+    p_slot->m_responded = false;
+    p_slot->m_sentMs = m_clock->getElapsed();
+
+    if( m_remote->setParam( p_slot->m_node, field, m_profile->getValue( field ), apply ))
+    {
+        XBeeApiCriticalSection cs( m_lock );
+
+        if( !p_slot->m_responded )
+        {
+            p_slot->m_frameId = m_remote->getLastFrameId();
+        }
+        p_slot->m_attempts++;
+        m_progress.m_commands++;
+    }
+}
+
+void XBeeApiRemotePush::finishSlot( XBeeApiRemotePushSlot_t* const p_slot, const XBeeApiRemotePushNodeState_e p_state )
+{
+    m_state[ p_slot->m_node ] = p_state;
+    m_progress.m_inProgress--;
+
+    if( p_state == XBEE_REMOTE_PUSH_NODE_DONE )
+    {
+        m_progress.m_done++;
+    }
+    else
+    {
+        m_progress.m_failed++;
+    }
+
+    p_slot->m_active = false;
+}
+
+void XBeeApiRemotePush::advanceSlot( XBeeApiRemotePushSlot_t* const p_slot, const uint8_t p_from )
+{
+    const uint8_t param = nextParam( p_slot->m_node, p_from );
+
+    if( param == XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT )
+    {
+        finishSlot( p_slot, XBEE_REMOTE_PUSH_NODE_DONE );
+    }
+    else
+    {
+        p_slot->m_param = param;
+        p_slot->m_attempts = 0;
+        sendSlot( p_slot );
+    }
+}
+
+void XBeeApiRemotePush::startSlot( XBeeApiRemotePushSlot_t* const p_slot )
+{
+    p_slot->m_node = (uint16_t)m_nextNode++;
+    p_slot->m_frameId = XBEE_FRAME_ID_NONE;
+    p_slot->m_responded = false;
+    p_slot->m_active = true;
+
+    m_state[ p_slot->m_node ] = XBEE_REMOTE_PUSH_NODE_IN_PROGRESS;
+    m_progress.m_inProgress++;
+
+    advanceSlot( p_slot, 0 );
+}
+
+bool XBeeApiRemotePush::start( const XBeeApiCmdAtProfile* const p_profile )
+{
+    bool ret_val = true;
+
+    for( uint8_t p = 0;
+         p < XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT;
+         p++ )
+    {
+        const XBeeApiCmdAtProfile::XBeeApiProfileField_e field = (XBeeApiCmdAtProfile::XBeeApiProfileField_e)p;
+
+        if(( p_profile->isSpecified( field )) &&
+           ( !m_remote->isParamValid( field, p_profile->getValue( field ))))
+        {
+            ret_val = false;
+        }
+    }
+
+    if( ret_val )
+    {
+        /* Abandon anything still outstanding from a previous push */
+        for( size_t i = 0;
+             i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+             i++ )
+        {
+            if( m_slots[ i ].m_active )
+            {
+                m_remote->cancelRequest( m_slots[ i ].m_frameId );
+                m_slots[ i ].m_active = false;
+            }
+        }
+
+        delete[]( m_state );
+        delete( m_clock );
+
+        m_profile = p_profile;
+        m_nodeCount = m_remote->getNodeCount();
+        m_nextNode = 0;
+        m_state = new uint8_t[ m_nodeCount ];
+        m_clock = new XBeeApiTimeout( 0 );
+
+        for( size_t i = 0;
+             i < m_nodeCount;
+             i++ )
+        {
+            m_state[ i ] = XBEE_REMOTE_PUSH_NODE_PENDING;
+        }
+
+        m_progress = XBeeApiRemotePushProgress_t();
+        m_progress.m_total = m_nodeCount;
+
+        m_event.clear();
+        m_remote->setCmdCallback( cmdCallback, this );
+
+        poll();
+    }
+
+    return ret_val;
+}
+
+bool XBeeApiRemotePush::poll( void )
+{
+    if( m_profile != NULL )
+    {
+        const uint32_t now = m_clock->getElapsed();
+
+        for( size_t i = 0;
+             i < XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT;
+             i++ )
+        {
+            XBeeApiRemotePushSlot_t* const slot = &( m_slots[ i ] );
+            bool retry = false;
+
+            if( !slot->m_active )
+            {
+                /* Nothing to do */
+            }
+            else if( slot->m_responded )
+            {
+                switch( slot->m_status )
+                {
+                    case XBeeApiCmdAt::XBEE_API_CMD_AT_STATUS_OK:
+                        advanceSlot( slot, slot->m_param + 1U );
+                        break;
+                    case XBeeApiCmdAt::XBEE_API_CMD_AT_STATUS_TX_FAILURE:
+                        /* The command didn't make it to the node */
+                        retry = true;
+                        break;
+                    default:
+                        /* The node rejected the command - re-sending won't help */
+                        finishSlot( slot, XBEE_REMOTE_PUSH_NODE_FAILED );
+                        break;
+                }
+            }
+            else if( slot->m_frameId == XBEE_FRAME_ID_NONE )
+            {
+                /* Couldn't be sent last time around */
+                sendSlot( slot );
+            }
+            else if(( now - slot->m_sentMs ) >= m_timeoutMs )
+            {
+                m_remote->cancelRequest( slot->m_frameId );
+                retry = true;
+            }
+
+            if( retry )
+            {
+                if( slot->m_attempts > m_retries )
+                {
+                    finishSlot( slot, XBEE_REMOTE_PUSH_NODE_FAILED );
+                }
+                else
+                {
+                    m_progress.m_retries++;
+                    sendSlot( slot );
+                }
+            }
+        }
+
+        /* Start work on further nodes, keeping the number in progress within the window */
+        for( size_t i = 0;
+             ( i < m_window ) && ( m_nextNode < m_nodeCount );
+             i++ )
+        {
+            if( !m_slots[ i ].m_active )
+            {
+                startSlot( &( m_slots[ i ] ));
+            }
+        }
+    }
+
+    return isComplete();
+}
+
+bool XBeeApiRemotePush::run( void )
+{
+    while( !poll() )
+    {
+        /* Sleep until either a response arrives or the next time-out is due */
+        const uint32_t now = m_clock->getElapsed();
+        uint32_t wait_ms = m_timeoutMs;
+
+        for( size_t i = 0;
+             i < m_window;
+             i++ )
+        {
+            const XBeeApiRemotePushSlot_t* const slot = &( m_slots[ i ] );
+
+            if( slot->m_active )
+            {
+                const uint32_t elapsed = now - slot->m_sentMs;
+                uint32_t remaining = XBEE_REMOTE_PUSH_RESEND_MS;
+
+                if(( slot->m_frameId != XBEE_FRAME_ID_NONE ) &&
+                   ( elapsed < m_timeoutMs ))
+                {
+                    remaining = m_timeoutMs - elapsed;
+                }
+                if( remaining < wait_ms )
+                {
+                    wait_ms = remaining;
+                }
+            }
+        }
+
+        m_event.wait( wait_ms );
+    }
+
+    return( m_progress.m_failed == 0 );
+}
+
+bool XBeeApiRemotePush::isComplete( void ) const
+{
+    return(( m_profile == NULL ) ||
+           (( m_nextNode >= m_nodeCount ) &&
+            ( m_progress.m_inProgress == 0 )));
+}
+
+void XBeeApiRemotePush::getProgress( XBeeApiRemotePushProgress_t* const p_progress )
+{
+    *p_progress = m_progress;
+
+    if( m_clock != NULL )
+    {
+        p_progress->m_elapsedMs = m_clock->getElapsed();
+    }
+}
+
+XBeeApiRemotePush::XBeeApiRemotePushNodeState_e XBeeApiRemotePush::getNodeState( const size_t p_node ) const
+{
+    XBeeApiRemotePushNodeState_e ret_val = XBEE_REMOTE_PUSH_NODE_PENDING;
+
+    if( p_node < m_nodeCount )
+    {
+        ret_val = (XBeeApiRemotePushNodeState_e)m_state[ p_node ];
+    }
+
+    return ret_val;
+}
@@ -0,0 +1,223 @@
+/**
+   @file
+   @brief Class to push a configuration change out to a number of remote
+          XBees, with several nodes being configured concurrently
+
+   @author John Bailey
+
+   @copyright Copyright 2014 John Bailey
+
+   @section LICENSE
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*/
+
+#if !defined XBEEAPIREMOTEPUSH_HPP
+#define      XBEEAPIREMOTEPUSH_HPP
+
+#include "XBeeApiCmdAtRemote.hpp"
+#include "XBeeApiCmdAtProfile.hpp"
+#include "XBeeApiEvent.hpp"
+
+#include <stdint.h>
+
+/** Default number of nodes which are configured concurrently */
+#define XBEE_REMOTE_PUSH_DEFAULT_WINDOW 8U
+/** Default time to wait for a remote node to respond to a command */
+#define XBEE_REMOTE_PUSH_DEFAULT_TIMEOUT_MS 2000U
+/** Default number of times a command is re-sent to a node which fails to respond */
+#define XBEE_REMOTE_PUSH_DEFAULT_RETRIES 3U
+
+/** Class to apply a profile (see XBeeApiCmdAtProfile) to all of the nodes known to an
+    XBeeApiCmdAtRemote object.
+
+    Up to a configurable number of nodes (the window) are worked on at any one time, each
+    having a single command outstanding.  The parameters which differ from the profile are
+    sent to each node as queued changes, with the last change instructing the node to apply
+    them all.  Parameters which are already cached (see XBeeApiCmdAtRemote::getParam()) with
+    the value in the profile are skipped.  Commands which receive no response (or which the
+    local XBee fails to transmit) are re-sent up to a configurable number of times before the
+    node is considered to have failed; commands which are rejected by the node fail it
+    immediately.
+
+    Note that a node which is moved to a different channel or PAN may do so before its
+    response makes it back, in which case the node will be reported as having failed.  Such
+    nodes can be checked once the gateway itself has been moved.
+
+    The object is driven by calling poll() periodically (or run(), which blocks until the
+    push is complete) and takes over the command call-back of the XBeeApiCmdAtRemote
+    object (see XBeeApiCmdAtRemote::setCmdCallback()) for the duration of the push. */
+class XBeeApiRemotePush
+{
+    public:
+        /** State of an individual node */
+        typedef enum {
+            /** Node has not yet been worked on */
+            XBEE_REMOTE_PUSH_NODE_PENDING     = 0,
+            /** Node is currently being configured */
+            XBEE_REMOTE_PUSH_NODE_IN_PROGRESS = 1,
+            /** Node matches the profile */
+            XBEE_REMOTE_PUSH_NODE_DONE        = 2,
+            /** Node could not be configured */
+            XBEE_REMOTE_PUSH_NODE_FAILED      = 3
+        } XBeeApiRemotePushNodeState_e;
+
+        /** Progress of the push */
+        typedef struct {
+            /** Total number of nodes being configured */
+            size_t   m_total;
+            /** Number of nodes which have been successfully configured */
+            size_t   m_done;
+            /** Number of nodes which could not be configured */
+            size_t   m_failed;
+            /** Number of nodes currently being configured */
+            size_t   m_inProgress;
+            /** Number of commands sent, including re-tries */
+            uint32_t m_commands;
+            /** Number of commands which were re-tried */
+            uint32_t m_retries;
+            /** Time since the push was started, in milliseconds */
+            uint32_t m_elapsedMs;
+        } XBeeApiRemotePushProgress_t;
+
+    protected:
+        /** A node which is currently being worked on */
+        typedef struct {
+            /** Index of the node */
+            uint16_t         m_node;
+            /** Parameter currently being changed */
+            uint8_t          m_param;
+            /** Number of times the current command has been sent */
+            uint8_t          m_attempts;
+            /** Time at which the current command was sent, relative to the start of the push */
+            uint32_t         m_sentMs;
+            /** Frame identifier of the current command, XBEE_FRAME_ID_NONE if not sent */
+            volatile uint8_t m_frameId;
+            /** Status received in response to the current command */
+            volatile uint8_t m_status;
+            /** Set once a response to the current command has been received */
+            volatile bool    m_responded;
+            /** Set when the slot is working on a node */
+            bool             m_active;
+        } XBeeApiRemotePushSlot_t;
+
+        /** Object used to communicate with the nodes */
+        XBeeApiCmdAtRemote*        m_remote;
+        /** Profile being pushed out to the nodes */
+        const XBeeApiCmdAtProfile* m_profile;
+        /** State of each node - see XBeeApiRemotePushNodeState_e */
+        uint8_t*                   m_state;
+        /** Number of nodes being pushed to, i.e. number of entries in m_state */
+        size_t                     m_nodeCount;
+        /** Next node which has not yet been started */
+        size_t                     m_nextNode;
+
+        /** Nodes currently being worked on */
+        XBeeApiRemotePushSlot_t    m_slots[ XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT ];
+        /** Number of entries in m_slots which are in use */
+        uint8_t                    m_window;
+        /** Time to wait for a response */
+        uint16_t                   m_timeoutMs;
+        /** Number of times to re-try a command */
+        uint8_t                    m_retries;
+
+        /** Progress counters */
+        XBeeApiRemotePushProgress_t m_progress;
+        /** Measures the time since the push was started */
+        XBeeApiTimeout*            m_clock;
+        /** Signalled when a response is received */
+        XBeeApiEvent               m_event;
+        /** Lock guarding m_slots against cmdCallback() */
+        XBeeApiCriticalSectionLock m_lock;
+
+        /** Call-back registered with m_remote */
+        static void cmdCallback( XBeeApiCmdAtRemote* const p_cmd,
+                                 const size_t p_node,
+                                 const uint16_t p_mnemonic,
+                                 const uint8_t p_frameId,
+                                 const XBeeApiCmdAt::XBeeApiCmdAtStatus_e p_status,
+                                 void* const p_ctx );
+
+        /** Find the next parameter which needs changing on a node
+
+            \param p_node Index of the node
+            \param p_from First parameter to consider
+            \returns Parameter, or XBeeApiCmdAtProfile::XBEE_PROFILE_FIELD_COUNT in the case
+                     that there's nothing (more) to change */
+        uint8_t nextParam( const size_t p_node, const uint8_t p_from ) const;
+
+        /** Send (or re-send) the current command for a slot */
+        void sendSlot( XBeeApiRemotePushSlot_t* const p_slot );
+
+        /** Move a slot on to the next parameter, finishing the node if there's nothing
+            further to change */
+        void advanceSlot( XBeeApiRemotePushSlot_t* const p_slot, const uint8_t p_from );
+
+        /** Finish work on the node in a slot, freeing the slot */
+        void finishSlot( XBeeApiRemotePushSlot_t* const p_slot, const XBeeApiRemotePushNodeState_e p_state );
+
+        /** Start work on the next pending node using a free slot */
+        void startSlot( XBeeApiRemotePushSlot_t* const p_slot );
+
+    public:
+        /** Constructor
+
+            \param p_remote Object used to communicate with the nodes.  Must be registered
+                            with an XBeeDevice
+            \param p_window Maximum number of nodes to configure concurrently.  Limited to
+                            XBEEAPI_CONFIG_MAX_FRAMES_IN_FLIGHT
+            \param p_timeoutMs Time to wait for a node to respond to a command
+            \param p_retries Number of times to re-send a command which receives no response */
+        XBeeApiRemotePush( XBeeApiCmdAtRemote* const p_remote,
+                           const uint8_t p_window = XBEE_REMOTE_PUSH_DEFAULT_WINDOW,
+                           const uint16_t p_timeoutMs = XBEE_REMOTE_PUSH_DEFAULT_TIMEOUT_MS,
+                           const uint8_t p_retries = XBEE_REMOTE_PUSH_DEFAULT_RETRIES );
+
+        /** Destructor */
+        virtual ~XBeeApiRemotePush( void );
+
+        /** Start pushing a profile out to all nodes currently known to the XBeeApiCmdAtRemote
+            object.  Any push already in progress is abandoned.
+
+            \param p_profile Profile to push.  Must remain valid until the push is complete
+            \returns false in the case that the profile contains a value which isn't valid
+                     (e.g. a channel not supported by the XBee), in which case nothing is sent */
+        bool start( const XBeeApiCmdAtProfile* const p_profile );
+
+        /** Progress the push - checks for responses & time-outs and sends further commands
+            as required.  Should be called periodically until isComplete() returns true.
+
+            \returns true in the case that the push is complete */
+        bool poll( void );
+
+        /** Block until the push is complete
+
+            \returns true in the case that all nodes were successfully configured */
+        bool run( void );
+
+        /** Determine whether or not all nodes have either been configured or failed */
+        bool isComplete( void ) const;
+
+        /** Retrieve the progress of the push
+
+            \param p_progress Receives the progress */
+        void getProgress( XBeeApiRemotePushProgress_t* const p_progress );
+
+        /** Retrieve the state of an individual node
+
+            \param p_node Index of the node, as used by XBeeApiCmdAtRemote */
+        XBeeApiRemotePushNodeState_e getNodeState( const size_t p_node ) const;
+};
+
+#endif
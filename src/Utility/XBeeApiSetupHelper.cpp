@@ -22,19 +22,46 @@ bool xbeeSetNetworkTypeP2P( XBeeApiCmdAt* const p_xbeeCmd,
                             const XBeeApiCmdAt::panId_t p_id,
                             const XBeeApiCmdAt::channel_t p_chan )
 {    
-    bool ret_val = p_xbeeCmd->setCoordinatorEnabled( false );
+    bool ret_val;
+
+    /* Queue all of the changes and then have the XBee apply them in one go */
+    p_xbeeCmd->beginBatch();
+
+    ret_val = p_xbeeCmd->setCoordinatorEnabled( false );
     if( ret_val ) 
     {
     	ret_val = p_xbeeCmd->setEndDeviceAssociationEnabled( false );
     }
     if( ret_val ) 
     {
-    	p_xbeeCmd->setChannel( p_chan );
+    	ret_val = p_xbeeCmd->setChannel( p_chan );
     }
     if( ret_val ) 
     {
-    	p_xbeeCmd->setPanId( p_id );
+    	ret_val = p_xbeeCmd->setPanId( p_id );
+    }
+
+    /* Always end the batch, so that the object isn't left queueing changes.  Any changes
+       which were accepted are applied, even if a later one failed */
+    if( !p_xbeeCmd->applyBatch() )
+    {
+        ret_val = false;
     }
+
     return ret_val;
 }
 
+bool xbeeSetNetworkTypeP2P( XBeeApiCmdAtBlocking* const p_xbeeCmd,
+                            const XBeeApiCmdAt::panId_t p_id,
+                            const XBeeApiCmdAt::channel_t p_chan,
+                            XBeeApiCmdAtProfile::XBeeApiProfileResult_t* const p_result )
+{
+    XBeeApiCmdAtProfile profile;
+
+    profile.setCoordinatorEnabled( false );
+    profile.setEndDeviceAssociationEnabled( false );
+    profile.setChannel( p_chan );
+    profile.setPanId( p_id );
+
+    return profile.apply( p_xbeeCmd, p_result );
+}
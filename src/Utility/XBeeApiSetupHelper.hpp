@@ -27,6 +27,7 @@ limitations under the License.
 
 #include "XBeeDevice.hpp"
 #include "XBeeApiCmdAt.hpp"
+#include "XBeeApiCmdAtProfile.hpp"
 
 typedef enum {
     XBEE_NETWORK_TYPE_P2P,
@@ -52,4 +53,21 @@ extern bool xbeeSetNetworkTypeP2P( XBeeApiCmdAt* const           p_xbeeCmd,
                                    const XBeeApiCmdAt::panId_t   p_id,
                                    const XBeeApiCmdAt::channel_t p_chan );
 
+/** Set the XBee to use the P2P networking model.  In contrast to the version of this function
+    taking an XBeeApiCmdAt, the current settings are read back from the XBee first and only the
+    settings which differ are changed (see XBeeApiCmdAtProfile).
+
+    \param p_xbeeCmd Pointer to an XBeeApiCmdAtBlocking object which has already been registered
+                     as a decoder with an XBee device.
+    \param p_id Network ID to use
+    \param p_chan Channel to use
+    \param p_result Receives details of what was changed.  May be NULL
+    \return true in the case that the XBee was configured, false in the case that a problem
+            was encountered
+*/      
+extern bool xbeeSetNetworkTypeP2P( XBeeApiCmdAtBlocking* const   p_xbeeCmd,
+                                   const XBeeApiCmdAt::panId_t   p_id,
+                                   const XBeeApiCmdAt::channel_t p_chan,
+                                   XBeeApiCmdAtProfile::XBeeApiProfileResult_t* const p_result = NULL );
+
 #endif /* !defined( XBEEAPISETUPHELPER_HPP ) */
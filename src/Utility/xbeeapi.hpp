@@ -26,13 +26,22 @@ limitations under the License.
 #define      XBEEAPI_HPP
 
 #include "XBeeDevice.hpp"
+#include "XBeeApiTransport.hpp"
+#include "XBeeApiTransportMbed.hpp"
+#include "XBeeApiTransportTermios.hpp"
 #include "XBeeApiFrame.hpp"
+#include "XBeeApiSharedFrame.hpp"
 #include "XBeeApiRxFrame.hpp"
 #include "XBeeApiRxFrameDecoder.hpp"
 #include "XBeeApiRxFrameCircularBuffer.hpp"
 #include "XBeeApiTxFrame.hpp"
 #include "XBeeApiTxFrameEx.hpp"
+#include "XBeeApiTxFramePooled.hpp"
 #include "XBeeApiCmdAt.hpp"
+#include "XBeeApiCmdAtProfile.hpp"
+#include "XBeeApiCmdAtRemote.hpp"
+#include "XBeeApiRemotePush.hpp"
 #include "XBeeApiSetupHelper.hpp"
+#include "XBeeApiGateway.hpp"
 
 #endif